@@ -0,0 +1,295 @@
+/******************************************************
+ *  Artifact - versioned binary export of trained racing lines and policies
+ ******************************************************/
+
+#include "artifact.hpp"
+#include "async_writer.hpp"
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// The format is little-endian; every platform we ship on is too
+static bool hostLittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// -------------------- Hashing --------------------
+static void hashBytes(uint64_t& hash, const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull; // FNV-1a
+    }
+}
+
+static void hashPoints(uint64_t& hash, const std::vector<sf::Vector2f>& points) {
+    uint32_t count = static_cast<uint32_t>(points.size());
+    hashBytes(hash, &count, sizeof(count));
+    for (const auto& p : points) {
+        hashBytes(hash, &p.x, sizeof(float));
+        hashBytes(hash, &p.y, sizeof(float));
+    }
+}
+
+uint64_t trackLayoutHash(const TrackLayout& layout) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    hashPoints(hash, layout.centreline);
+    hashPoints(hash, layout.checkpoints);
+    hashBytes(hash, &layout.width, sizeof(float));
+    hashBytes(hash, &layout.wallOffset, sizeof(float));
+    return hash;
+}
+
+uint32_t artifactChecksum(const uint8_t* data, size_t size) {
+    static const auto table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// -------------------- Writing --------------------
+template <typename T>
+static void append(std::vector<uint8_t>& out, const T* items, size_t count) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+// Writes to a temporary name first, so a reader never maps a half-written artifact
+static bool writeArtifact(const std::string& path, ArtifactKind kind, uint64_t trackHash, float fitness,
+                          const std::vector<uint8_t>& payload, AsyncWriter* writer) {
+    if (!hostLittleEndian()) {
+        std::cerr << "Artifact: big-endian hosts are not supported\n";
+        return false;
+    }
+    ArtifactHeader head = {};
+    head.magic = ARTIFACT_MAGIC;
+    head.version = ARTIFACT_VERSION;
+    head.kind = static_cast<uint16_t>(kind);
+    head.trackHash = trackHash;
+    head.payloadSize = static_cast<uint32_t>(payload.size());
+    head.checksum = artifactChecksum(payload.data(), payload.size());
+    head.fitness = fitness;
+
+    const std::string scratchPath = path + ".tmp";
+    if (writer) {
+        // Two exports of one path may be in flight at once, so each gets its own scratch file
+        static std::atomic<uint64_t> serial{0};
+        int stream = writer->open(path + "." + std::to_string(serial++) + ".tmp");
+        if (stream < 0) {
+            std::cerr << "Artifact: cannot write " << path << "\n";
+            return false;
+        }
+        // One write, so the writer takes the whole file or none of it
+        std::vector<uint8_t> file;
+        append(file, &head, 1);
+        append(file, payload.data(), payload.size());
+        if (!writer->write(stream, file.data(), file.size())) {
+            writer->close(stream); // no rename: path keeps its last complete artifact
+            std::cerr << "Artifact: writer has no room for " << path << "\n";
+            return false;
+        }
+        writer->close(stream, path);
+        return true;
+    }
+    {
+        std::ofstream out(scratchPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+        out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+        if (!out) {
+            std::cerr << "Artifact: cannot write " << path << "\n";
+            std::remove(scratchPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(scratchPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Artifact: cannot replace " << path << "\n";
+        std::remove(scratchPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeRacingLineArtifact(const std::string& path, uint64_t trackHash, const std::vector<sf::Vector2f>& waypoints, float fitness,
+                             AsyncWriter* writer) {
+    std::vector<uint8_t> payload;
+    ArtifactArrayHeader array = {static_cast<uint32_t>(waypoints.size()), 0};
+    append(payload, &array, 1);
+    for (const auto& wp : waypoints) {
+        const float xy[2] = {wp.x, wp.y};
+        append(payload, xy, 2);
+    }
+    return writeArtifact(path, ArtifactKind::RacingLine, trackHash, fitness, payload, writer);
+}
+
+bool writePolicyArtifact(const std::string& path, const PolicyNet& net, float fitness, uint64_t trackHash, AsyncWriter* writer) {
+    std::vector<uint8_t> payload;
+    ArtifactArrayHeader array = {static_cast<uint32_t>(net.layers.size()), 0};
+    append(payload, &array, 1);
+    for (size_t width : net.layers) {
+        uint32_t w = static_cast<uint32_t>(width);
+        append(payload, &w, 1);
+    }
+    append(payload, net.params.data(), net.params.size());
+    return writeArtifact(path, ArtifactKind::PolicyFloat, trackHash, fitness, payload, writer);
+}
+
+bool writePolicyArtifact(const std::string& path, const QuantizedPolicy& policy, float fitness, uint64_t trackHash,
+                         AsyncWriter* writer) {
+    std::vector<uint8_t> payload;
+    ArtifactArrayHeader array = {static_cast<uint32_t>(policy.layers.size()), 0};
+    append(payload, &array, 1);
+    for (const auto& layer : policy.layers) {
+        ArtifactQuantLayer q = {};
+        q.in = static_cast<uint32_t>(layer.in);
+        q.out = static_cast<uint32_t>(layer.out);
+        q.stride = static_cast<uint32_t>(layer.stride);
+        q.inputZero = layer.inputZero;
+        q.inputScale = layer.inputScale;
+        append(payload, &q, 1);
+        append(payload, layer.weights.data(), layer.weights.size());
+        append(payload, layer.rowSums.data(), layer.rowSums.size());
+        append(payload, layer.rowScales.data(), layer.rowScales.size());
+        append(payload, layer.bias.data(), layer.bias.size());
+    }
+    return writeArtifact(path, ArtifactKind::PolicyInt8, trackHash, fitness, payload, writer);
+}
+
+// -------------------- Reading --------------------
+bool Artifact::open(const std::string& path) {
+    head = {};
+    if (!file.open(path)) return false;
+
+    auto fail = [&](const char* reason) {
+        std::cerr << "Artifact " << path << ": " << reason << "\n";
+        file.close();
+        return false;
+    };
+
+    if (!hostLittleEndian()) return fail("big-endian hosts are not supported");
+    if (file.size() < sizeof(ArtifactHeader)) return fail("truncated header");
+    std::memcpy(&head, file.data(), sizeof(head));
+    if (head.magic != ARTIFACT_MAGIC || head.version != ARTIFACT_VERSION) return fail("not a version 1 artifact");
+    if (head.payloadSize != file.size() - sizeof(ArtifactHeader)) return fail("size does not match header");
+    if (artifactChecksum(payload(), head.payloadSize) != head.checksum) return fail("checksum mismatch");
+    return true;
+}
+
+size_t Artifact::lineSize() const {
+    if (kind() != ArtifactKind::RacingLine || head.payloadSize < sizeof(ArtifactArrayHeader)) return 0;
+    ArtifactArrayHeader array;
+    std::memcpy(&array, payload(), sizeof(array));
+    if (sizeof(array) + static_cast<uint64_t>(array.count) * 2 * sizeof(float) != head.payloadSize) return 0;
+    return array.count;
+}
+
+const float* Artifact::linePoints() const {
+    return reinterpret_cast<const float*>(payload() + sizeof(ArtifactArrayHeader));
+}
+
+bool Artifact::racingLine(std::vector<sf::Vector2f>& waypoints) const {
+    size_t count = lineSize();
+    if (count == 0) return false;
+    const float* xy = linePoints();
+    waypoints.resize(count);
+    for (size_t i = 0; i < count; i++) waypoints[i] = sf::Vector2f(xy[2 * i], xy[2 * i + 1]);
+    return true;
+}
+
+bool Artifact::policy(PolicyNet& net) const {
+    if (kind() != ArtifactKind::PolicyFloat || head.payloadSize < sizeof(ArtifactArrayHeader)) return false;
+    ArtifactArrayHeader array;
+    std::memcpy(&array, payload(), sizeof(array));
+    size_t offset = sizeof(array);
+    if (array.count < 2 || offset + static_cast<uint64_t>(array.count) * sizeof(uint32_t) > head.payloadSize) return false;
+
+    std::vector<size_t> layers(array.count);
+    const uint32_t* widths = reinterpret_cast<const uint32_t*>(payload() + offset);
+    for (size_t i = 0; i < layers.size(); i++) {
+        if (widths[i] == 0 || widths[i] > 65536) return false;
+        layers[i] = widths[i];
+    }
+    offset += array.count * sizeof(uint32_t);
+
+    const size_t params = policyParamCount(layers);
+    if (offset + params * sizeof(float) != head.payloadSize) return false;
+    net.layers = layers;
+    net.params.resize(params);
+    std::memcpy(net.params.data(), payload() + offset, params * sizeof(float));
+    return true;
+}
+
+bool Artifact::quantizedPolicy(QuantizedPolicy& policy) const {
+    if (kind() != ArtifactKind::PolicyInt8 || head.payloadSize < sizeof(ArtifactArrayHeader)) return false;
+    ArtifactArrayHeader array;
+    std::memcpy(&array, payload(), sizeof(array));
+    size_t offset = sizeof(array);
+    if (array.count == 0 || array.count > 64) return false;
+
+    std::vector<QuantizedLayer> layers(array.count);
+    for (auto& layer : layers) {
+        ArtifactQuantLayer q;
+        if (offset + sizeof(q) > head.payloadSize) return false;
+        std::memcpy(&q, payload() + offset, sizeof(q));
+        offset += sizeof(q);
+        if (q.in == 0 || q.out == 0 || q.in > 65536 || q.out > 65536 || q.stride < q.in || q.stride % 32 != 0) return false;
+
+        const uint64_t bytes = static_cast<uint64_t>(q.out) * q.stride + q.out * (sizeof(int32_t) + 2 * sizeof(float));
+        if (offset + bytes > head.payloadSize) return false;
+        layer.in = q.in;
+        layer.out = q.out;
+        layer.stride = q.stride;
+        layer.inputZero = q.inputZero;
+        layer.inputScale = q.inputScale;
+
+        auto take = [&](auto& vec, size_t count) {
+            vec.resize(count);
+            std::memcpy(vec.data(), payload() + offset, count * sizeof(vec[0]));
+            offset += count * sizeof(vec[0]);
+        };
+        take(layer.weights, layer.out * layer.stride);
+        take(layer.rowSums, layer.out);
+        take(layer.rowScales, layer.out);
+        take(layer.bias, layer.out);
+    }
+    if (offset != head.payloadSize) return false;
+    policy.layers = std::move(layers);
+    return true;
+}
+
+// -------------------- Racing Lines on Disk --------------------
+std::string racingLineFileName(const std::string& trackName) {
+    std::string file;
+    for (unsigned char c : trackName) {
+        file += std::isalnum(c) ? static_cast<char>(std::tolower(c)) : '-';
+    }
+    return file + ".sra";
+}
+
+bool loadRacingLineFor(const TrackLayout& layout, const std::string& directory, std::vector<sf::Vector2f>& waypoints) {
+    std::ifstream probe(directory + "/" + racingLineFileName(layout.name));
+    if (!probe) return false; // nothing exported yet, not an error
+    probe.close();
+
+    Artifact artifact;
+    if (!artifact.open(directory + "/" + racingLineFileName(layout.name))) return false;
+    if (artifact.kind() != ArtifactKind::RacingLine || artifact.header().trackHash != trackLayoutHash(layout)) {
+        std::cerr << "Artifact for " << layout.name << " was trained on a different layout, ignoring it\n";
+        return false;
+    }
+    return artifact.racingLine(waypoints);
+}
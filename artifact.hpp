@@ -0,0 +1,112 @@
+/******************************************************
+ *  Artifact - versioned binary export of trained racing lines and policies
+ ******************************************************/
+#pragma once
+
+#include "mapped_file.hpp"
+#include "policy.hpp"
+#include "track.hpp"
+
+#include <SFML/System.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class AsyncWriter;
+
+// -------------------- Artifact File --------------------
+// [ArtifactHeader][payload]. Every field is fixed-size and little-endian, every array
+// starts on a 4-byte boundary, so a mapped file is used in place: loading checks the
+// header and checksum once and then reads arrays straight out of the mapping.
+//
+// RacingLine payload:  ArtifactArrayHeader{count}, then count x {float x, float y}
+// PolicyFloat payload: ArtifactArrayHeader{layer widths}, uint32 widths[], float params[]
+// PolicyInt8 payload:  ArtifactArrayHeader{layers}, then per layer ArtifactQuantLayer
+//                      followed by int8 weights[out * stride], int32 rowSums[out],
+//                      float rowScales[out], float bias[out]
+
+enum class ArtifactKind : uint16_t {
+    RacingLine = 1,
+    PolicyFloat = 2,
+    PolicyInt8 = 3,
+};
+
+struct ArtifactHeader {
+    uint32_t magic;       // ARTIFACT_MAGIC
+    uint16_t version;     // ARTIFACT_VERSION
+    uint16_t kind;        // ArtifactKind
+    uint64_t trackHash;   // trackLayoutHash() it was trained on, 0 = not tied to a track
+    uint32_t payloadSize; // bytes following the header
+    uint32_t checksum;    // CRC-32 of the payload
+    float    fitness;     // trainer's score at export
+    uint32_t reserved;
+};
+static_assert(sizeof(ArtifactHeader) == 32, "ArtifactHeader layout is part of the file format");
+
+struct ArtifactArrayHeader {
+    uint32_t count;
+    uint32_t reserved;
+};
+static_assert(sizeof(ArtifactArrayHeader) == 8, "ArtifactArrayHeader layout is part of the file format");
+
+struct ArtifactQuantLayer {
+    uint32_t in, out, stride; // stride is a multiple of 32, so the arrays after it stay aligned
+    int32_t  inputZero;
+    float    inputScale;
+    uint32_t reserved[3];
+};
+static_assert(sizeof(ArtifactQuantLayer) == 32, "ArtifactQuantLayer layout is part of the file format");
+
+static const uint32_t ARTIFACT_MAGIC = 0x41525253; // "SRRA"
+static const uint16_t ARTIFACT_VERSION = 1;
+
+// Identifies a track's geometry (centreline, checkpoints, width, wall offset) by value,
+// so the same layout hashes the same on every machine and an edited one does not
+uint64_t trackLayoutHash(const TrackLayout& layout);
+
+uint32_t artifactChecksum(const uint8_t* data, size_t size); // CRC-32
+
+// An artifact is written under a scratch name and renamed over path once complete. With a
+// writer, both happen on its thread: the call only copies the file into the writer's
+// buffers, and false means it had no room (path is left as it was). Without one, the
+// call does the file I/O itself.
+bool writeRacingLineArtifact(const std::string& path, uint64_t trackHash, const std::vector<sf::Vector2f>& waypoints, float fitness,
+                             AsyncWriter* writer = nullptr);
+bool writePolicyArtifact(const std::string& path, const PolicyNet& net, float fitness, uint64_t trackHash = 0,
+                         AsyncWriter* writer = nullptr);
+bool writePolicyArtifact(const std::string& path, const QuantizedPolicy& policy, float fitness, uint64_t trackHash = 0,
+                         AsyncWriter* writer = nullptr);
+
+// Read-only view of an artifact file
+class Artifact {
+public:
+    // Maps the file and checks magic, version, sizes and checksum
+    bool open(const std::string& path);
+
+    bool isOpen() const { return file.isOpen(); }
+    const ArtifactHeader& header() const { return head; }
+    ArtifactKind kind() const { return static_cast<ArtifactKind>(head.kind); }
+
+    // RacingLine: x0, y0, x1, y1, ... straight from the mapping
+    size_t lineSize() const;
+    const float* linePoints() const;
+
+    // Copies into the in-memory types; false if the kind or layout doesn't match
+    bool racingLine(std::vector<sf::Vector2f>& waypoints) const;
+    bool policy(PolicyNet& net) const;
+    bool quantizedPolicy(QuantizedPolicy& policy) const;
+
+private:
+    const uint8_t* payload() const { return file.data() + sizeof(ArtifactHeader); }
+
+    MappedFile file;
+    ArtifactHeader head = {};
+};
+
+// Loads the racing line for a layout from DIR/<track>.sra if it exists and was
+// trained on exactly this geometry
+bool loadRacingLineFor(const TrackLayout& layout, const std::string& directory, std::vector<sf::Vector2f>& waypoints);
+
+// File name used for a track's racing line, e.g. "L-Shape" -> "l-shape.sra"
+std::string racingLineFileName(const std::string& trackName);
@@ -0,0 +1,586 @@
+/******************************************************
+ *  Async Writer - shared background file writing for replays, logs and checkpoints
+ ******************************************************/
+
+#include "async_writer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNC_WRITER_IO_URING
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+// -------------------- Files --------------------
+#ifdef _WIN32
+
+static intptr_t openForWriting(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return file == INVALID_HANDLE_VALUE ? -1 : reinterpret_cast<intptr_t>(file);
+}
+
+static long long writeAt(intptr_t file, const char* data, size_t size, uint64_t offset) {
+    OVERLAPPED at = {};
+    at.Offset = static_cast<DWORD>(offset);
+    at.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD written = 0;
+    return WriteFile(reinterpret_cast<HANDLE>(file), data, static_cast<DWORD>(size), &written, &at) ? written : -1;
+}
+
+static bool syncFile(intptr_t file) {
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(file)) != 0;
+}
+
+static void closeFile(intptr_t file) {
+    CloseHandle(reinterpret_cast<HANDLE>(file));
+}
+
+#else
+
+static intptr_t openForWriting(const std::string& path) {
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+static long long writeAt(intptr_t file, const char* data, size_t size, uint64_t offset) {
+    ssize_t written;
+    do {
+        written = pwrite(static_cast<int>(file), data, size, static_cast<off_t>(offset));
+    } while (written < 0 && errno == EINTR);
+    return written;
+}
+
+static bool syncFile(intptr_t file) {
+#ifdef __APPLE__
+    return fsync(static_cast<int>(file)) == 0;
+#else
+    return fdatasync(static_cast<int>(file)) == 0;
+#endif
+}
+
+static void closeFile(intptr_t file) {
+    ::close(static_cast<int>(file));
+}
+
+#endif
+
+// -------------------- io_uring --------------------
+// The raw kernel interface: a submission ring and a completion ring shared with the
+// kernel through mmap, and io_uring_enter to submit and wait. Only this thread uses
+// either ring, so the only ordering needed is against the kernel.
+static const uint64_t SYNC_TAG = uint64_t(1) << 63; // user_data of a sync; writes carry their buffer index
+static const uint64_t WAKE_TAG = uint64_t(1) << 62; // user_data of the poll on the wake eventfd
+
+struct AsyncWriter::Ring {
+#ifdef ASYNC_WRITER_IO_URING
+    int fd = -1;
+    void* sqMap = MAP_FAILED;
+    void* cqMap = MAP_FAILED;
+    size_t sqMapSize = 0, cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqMask = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr, *cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned sqEntries = 0;
+    unsigned unsubmitted = 0;
+    bool fixedBuffers = false;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool init(unsigned entries, char* buffers, size_t bufferSize, size_t bufferCount) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) return false; // old kernel, or io_uring disabled or filtered
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) return false;
+        cqMap = single ? sqMap : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED) return false;
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = static_cast<char*>(sqMap);
+        char* cq = static_cast<char*>(cqMap);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        sqEntries = params.sq_entries;
+
+        // Registered once, so writes skip pinning and mapping the pages every time.
+        // Without it (e.g. a low RLIMIT_MEMLOCK) plain writes still work.
+        std::vector<iovec> vectors(bufferCount);
+        for (size_t i = 0; i < bufferCount; i++) {
+            vectors[i].iov_base = buffers + i * bufferSize;
+            vectors[i].iov_len = bufferSize;
+        }
+        fixedBuffers = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, vectors.data(), static_cast<unsigned>(bufferCount)) == 0;
+        return true;
+    }
+
+    // Next free submission entry, zeroed, or null if the ring is full
+    io_uring_sqe* next() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        unsigned tail = *sqTail;
+        if (tail - head >= sqEntries) return nullptr;
+        unsigned index = tail & *sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        return sqe;
+    }
+
+    // Publishes the entry from next() to the kernel (submitted on the next enter())
+    void push() {
+        __atomic_store_n(sqTail, *sqTail + 1, __ATOMIC_RELEASE);
+        unsubmitted++;
+    }
+
+    // Submits everything pushed and, with wait, blocks until at least one completion
+    bool enter(bool wait) {
+        for (;;) {
+            long submitted = syscall(__NR_io_uring_enter, fd, unsubmitted, wait ? 1u : 0u, wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (submitted >= 0) {
+                unsubmitted -= static_cast<unsigned>(submitted);
+                return true;
+            }
+            if (errno != EINTR) return false;
+        }
+    }
+
+    bool pop(io_uring_cqe& out) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        out = cqes[head & *cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+#endif
+};
+
+// -------------------- Writer --------------------
+AsyncWriter::AsyncWriter(const AsyncWriterSettings& writerSettings) : settings(writerSettings) {
+    settings.bufferSize = std::max<size_t>(4096, settings.bufferSize);
+    settings.bufferCount = std::max<size_t>(2, settings.bufferCount);
+    storage.resize(settings.bufferSize * settings.bufferCount);
+    for (size_t i = settings.bufferCount; i-- > 0;) freeBuffers.push_back(static_cast<int>(i));
+    inFlightWrites.resize(settings.bufferCount);
+
+#ifdef ASYNC_WRITER_IO_URING
+    if (settings.allowIoUring) {
+        // Room for every buffer in flight, as many syncs and the wake poll
+        unsigned entries = 8;
+        while (entries < 2 * settings.bufferCount + 1 && entries < 4096) entries *= 2;
+        ring = std::make_unique<Ring>();
+        if (!ring->init(entries, storage.data(), settings.bufferSize, settings.bufferCount)) ring.reset();
+        // Without a way to interrupt a wait in the kernel, new buffers would sit in the
+        // queue until a write completes; pwrite is the better backend then
+        if (ring) wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wakeFd < 0) ring.reset();
+    }
+#endif
+    worker = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    for (size_t i = 0; i < streams.size(); i++) close(static_cast<int>(i));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        wakeWriter();
+    }
+    worker.join();
+    ring.reset();
+#ifndef _WIN32
+    if (wakeFd >= 0) ::close(wakeFd);
+#endif
+}
+
+int AsyncWriter::open(const std::string& path, const WriterStreamSettings& streamSettings) {
+    intptr_t file = openForWriting(path);
+    if (file == -1) {
+        std::cerr << "Async writer: cannot open " << path << "\n";
+        return -1;
+    }
+    auto stream = std::make_unique<Stream>();
+    stream->settings = streamSettings;
+    stream->file = file;
+    stream->path = path;
+    stream->lastSync = Clock::now();
+
+    // Closed streams give their slots back, so the writer thread never scans dead ones
+    std::lock_guard<std::mutex> lock(mutex);
+    if (freeStreamIds.empty()) {
+        stream->id = static_cast<int>(streams.size());
+        streams.push_back(nullptr);
+    } else {
+        stream->id = freeStreamIds.back();
+        freeStreamIds.pop_back();
+    }
+    const int id = stream->id;
+    streams[id] = std::move(stream);
+    return id;
+}
+
+bool AsyncWriter::write(int id, const void* data, size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!streams[id] || streams[id]->closed) return false;
+    Stream& stream = *streams[id];
+
+    const size_t room = (stream.buffer >= 0 ? settings.bufferSize - stream.fill : 0) + freeBuffers.size() * settings.bufferSize;
+    if (size > room) {
+        dropped.fetch_add(size, std::memory_order_relaxed);
+        return false;
+    }
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        if (stream.buffer < 0) {
+            stream.buffer = freeBuffers.back();
+            freeBuffers.pop_back();
+            stream.fill = 0;
+        }
+        size_t n = std::min(size, settings.bufferSize - stream.fill);
+        std::memcpy(storage.data() + stream.buffer * settings.bufferSize + stream.fill, bytes, n);
+        stream.fill += n;
+        bytes += n;
+        size -= n;
+        if (stream.fill == settings.bufferSize) handOver(stream);
+    }
+    return true;
+}
+
+void AsyncWriter::flush(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!streams[id]) return;
+    Stream& stream = *streams[id];
+    if (stream.buffer >= 0 && stream.fill > 0) handOver(stream);
+}
+
+void AsyncWriter::close(int id, const std::string& renameTo) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!streams[id] || streams[id]->closed) return;
+    Stream& stream = *streams[id];
+    stream.renameTo = renameTo;
+    if (stream.buffer >= 0 && stream.fill > 0) {
+        handOver(stream);
+    } else if (stream.buffer >= 0) {
+        freeBuffers.push_back(stream.buffer);
+        stream.buffer = -1;
+    }
+    stream.closed = true;
+    queue.push_back(Job{JobKind::Close, &stream, -1, 0, 0, 0});
+    pending++;
+    wakeWriter();
+}
+
+void AsyncWriter::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [&] { return pending == 0; });
+}
+
+void AsyncWriter::handOver(Stream& stream) {
+    queue.push_back(Job{JobKind::Write, &stream, stream.buffer, stream.fill, stream.offset, 0});
+    stream.offset += stream.fill;
+    stream.buffer = -1;
+    stream.fill = 0;
+    pending++;
+    wakeWriter();
+}
+
+// The writer thread sleeps either on the condition variable or, with writes in the
+// ring, inside io_uring_enter; there only a completion wakes it, so callers post to
+// wakeFd, which the ring polls. One post per wait is enough.
+void AsyncWriter::wakeWriter() {
+#ifdef ASYNC_WRITER_IO_URING
+    if (waitingInRing) {
+        waitingInRing = false;
+        const uint64_t one = 1;
+        if (::write(wakeFd, &one, sizeof(one)) < 0) reportError("wake");
+        return;
+    }
+#endif
+    wake.notify_one();
+}
+
+// -------------------- Writer Thread --------------------
+void AsyncWriter::finishWrite(const Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    freeBuffers.push_back(job.buffer);
+    if (--pending == 0) drained.notify_all();
+}
+
+void AsyncWriter::reportError(const char* what) {
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::cerr << "Async writer: " << what << " failed; the file is incomplete\n";
+    }
+}
+
+void AsyncWriter::wrote(Stream& stream, size_t bytes) {
+    writtenBytes.fetch_add(bytes, std::memory_order_relaxed);
+    stream.unsynced += bytes;
+    if (stream.settings.syncEveryBytes && stream.unsynced >= stream.settings.syncEveryBytes) syncStream(stream);
+}
+
+void AsyncWriter::syncStream(Stream& stream) {
+    stream.unsynced = 0;
+    stream.lastSync = Clock::now();
+#ifdef ASYNC_WRITER_IO_URING
+    if (ring) {
+        io_uring_sqe* sqe = ring->next();
+        if (!sqe) {
+            ring->enter(false); // hands the full ring to the kernel, which frees its entries
+            sqe = ring->next();
+        }
+        if (sqe) {
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = static_cast<int>(stream.file);
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            sqe->user_data = SYNC_TAG | reinterpret_cast<uintptr_t>(&stream);
+            ring->push();
+            stream.inFlight++;
+            ringInFlight++;
+            return;
+        }
+    }
+#endif
+    if (syncFile(stream.file)) {
+        syncs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        reportError("sync");
+    }
+}
+
+void AsyncWriter::writeNow(Job job) {
+    const char* buffer = storage.data() + job.buffer * settings.bufferSize;
+    while (job.size > 0) {
+        long long n = writeAt(job.stream->file, buffer + job.done, job.size, job.offset);
+        if (n <= 0) {
+            reportError("write");
+            break;
+        }
+        job.done += static_cast<size_t>(n);
+        job.offset += static_cast<uint64_t>(n);
+        job.size -= static_cast<size_t>(n);
+    }
+    wrote(*job.stream, job.done);
+    finishWrite(job);
+}
+
+void AsyncWriter::submitWrite(const Job& job) {
+#ifdef ASYNC_WRITER_IO_URING
+    io_uring_sqe* sqe = ring->next();
+    if (!sqe) {
+        ring->enter(false);
+        sqe = ring->next();
+    }
+    if (!sqe) {
+        writeNow(job); // cannot happen with the ring sized for every buffer, but never lose data
+        return;
+    }
+    sqe->opcode = ring->fixedBuffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = static_cast<int>(job.stream->file);
+    sqe->addr = reinterpret_cast<uintptr_t>(storage.data() + job.buffer * settings.bufferSize + job.done);
+    sqe->len = static_cast<uint32_t>(job.size);
+    sqe->off = job.offset;
+    sqe->buf_index = static_cast<uint16_t>(job.buffer);
+    sqe->user_data = static_cast<uint64_t>(job.buffer);
+    ring->push();
+    inFlightWrites[job.buffer] = job;
+    job.stream->inFlight++;
+    ringInFlight++;
+#else
+    writeNow(job);
+#endif
+}
+
+void AsyncWriter::armWake() {
+#ifdef ASYNC_WRITER_IO_URING
+    if (wakeArmed) return;
+    io_uring_sqe* sqe = ring->next();
+    if (!sqe) {
+        ring->enter(false);
+        sqe = ring->next();
+    }
+    if (!sqe) return; // the wait then ends on the next completion, as it would without the poll
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wakeFd;
+    sqe->poll_events = POLLIN;
+    sqe->user_data = WAKE_TAG;
+    ring->push();
+    wakeArmed = true;
+#endif
+}
+
+void AsyncWriter::reapCompletions(bool wait) {
+#ifdef ASYNC_WRITER_IO_URING
+    if (!ring->enter(wait && ringInFlight > 0)) reportError("io_uring submission");
+    io_uring_cqe cqe;
+    while (ring->pop(cqe)) {
+        if (cqe.user_data == WAKE_TAG) {
+            uint64_t posts;
+            if (::read(wakeFd, &posts, sizeof(posts)) < 0 && errno != EAGAIN) reportError("wake");
+            wakeArmed = false;
+            continue;
+        }
+        ringInFlight--;
+        if (cqe.user_data & SYNC_TAG) {
+            Stream& stream = *reinterpret_cast<Stream*>(static_cast<uintptr_t>(cqe.user_data & ~SYNC_TAG));
+            stream.inFlight--;
+            if (cqe.res < 0) {
+                reportError("sync");
+            } else {
+                syncs.fetch_add(1, std::memory_order_relaxed);
+            }
+            continue;
+        }
+
+        Job job = inFlightWrites[static_cast<size_t>(cqe.user_data)];
+        job.stream->inFlight--;
+        if (cqe.res <= 0) {
+            reportError("write");
+            wrote(*job.stream, job.done);
+            finishWrite(job);
+            continue;
+        }
+        job.done += static_cast<size_t>(cqe.res);
+        job.offset += static_cast<uint64_t>(cqe.res);
+        job.size -= static_cast<size_t>(cqe.res);
+        if (job.size > 0) {
+            submitWrite(job); // short write: the rest goes back in
+        } else {
+            wrote(*job.stream, job.done);
+            finishWrite(job);
+        }
+    }
+#else
+    (void)wait;
+#endif
+}
+
+bool AsyncWriter::finishClose(Stream& stream) {
+    if (stream.inFlight > 0) return false;
+    if (stream.settings.syncOnClose && stream.unsynced > 0) {
+        if (syncFile(stream.file)) {
+            syncs.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            reportError("sync");
+        }
+    }
+    closeFile(stream.file);
+    stream.file = -1;
+    if (!stream.renameTo.empty()) {
+        std::error_code error;
+        std::filesystem::rename(stream.path, stream.renameTo, error);
+        if (error) reportError("rename");
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const int id = stream.id;
+    streams[id].reset();
+    freeStreamIds.push_back(id);
+    if (--pending == 0) drained.notify_all();
+    return true;
+}
+
+AsyncWriter::Clock::time_point AsyncWriter::nextTimedSync() const {
+    Clock::time_point due = Clock::time_point::max();
+    for (const auto& stream : streams) {
+        if (stream && stream->file != -1 && stream->settings.syncEverySeconds > 0.f && stream->unsynced > 0) {
+            auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(stream->settings.syncEverySeconds));
+            due = std::min(due, stream->lastSync + interval);
+        }
+    }
+    return due;
+}
+
+void AsyncWriter::run() {
+    std::vector<Job> jobs;
+    std::vector<Stream*> syncDue;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            waitingInRing = false;
+            // With writes in the ring, waiting happens in the kernel instead (below)
+            if (queue.empty() && ringInFlight == 0) {
+                if (stopping && closing.empty()) return;
+                Clock::time_point due = nextTimedSync();
+                auto ready = [&] { return stopping || !queue.empty(); };
+                if (due == Clock::time_point::max()) {
+                    wake.wait(lock, ready);
+                } else {
+                    wake.wait_until(lock, due, ready);
+                }
+            }
+            jobs.assign(queue.begin(), queue.end());
+            queue.clear();
+
+            syncDue.clear();
+            Clock::time_point now = Clock::now();
+            for (const auto& stream : streams) {
+                if (stream && stream->file != -1 && stream->settings.syncEverySeconds > 0.f && stream->unsynced > 0 &&
+                    now - stream->lastSync >= std::chrono::duration<float>(stream->settings.syncEverySeconds)) {
+                    syncDue.push_back(stream.get());
+                }
+            }
+            // Nothing new: with writes in the ring the wait below is in the kernel
+            waitingInRing = ring && jobs.empty() && syncDue.empty() && ringInFlight > 0;
+        }
+
+        for (const Job& job : jobs) {
+            if (job.kind == JobKind::Close) {
+                closing.push_back(job.stream);
+            } else if (ring) {
+                submitWrite(job);
+            } else {
+                writeNow(job);
+            }
+        }
+        for (Stream* stream : syncDue) syncStream(*stream);
+        // Block for a completion only when nothing new arrived this round; a caller
+        // handing over a buffer meanwhile ends the wait through wakeFd
+        if (ring) {
+            const bool wait = jobs.empty() && syncDue.empty();
+            if (wait) armWake();
+            reapCompletions(wait);
+        }
+
+        closing.erase(std::remove_if(closing.begin(), closing.end(), [&](Stream* stream) { return finishClose(*stream); }),
+                      closing.end());
+    }
+}
@@ -0,0 +1,140 @@
+/******************************************************
+ *  Async Writer - shared background file writing for replays and exported artifacts
+ ******************************************************/
+#pragma once
+
+#include "memory_budget.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// When a stream's data is forced from the page cache to the disk. Syncs are batched:
+// one data sync covers everything written to the stream before it.
+struct WriterStreamSettings {
+    uint64_t syncEveryBytes = 0;   // sync after this many bytes since the last one, 0 = never
+    float syncEverySeconds = 0.f;  // sync written data at least this often, 0 = never
+    bool syncOnClose = true;
+};
+
+struct AsyncWriterSettings {
+    size_t bufferSize = 64 << 10;
+    size_t bufferCount = 32;       // shared by every stream; registered with io_uring once
+    bool allowIoUring = true;      // false forces the thread + pwrite backend
+};
+
+// One writer thread serves every stream. Callers copy data into fixed, preallocated
+// buffers and never touch the file themselves after open(). A full buffer is handed to
+// the writer thread, which submits it with io_uring (registered buffers, so the kernel
+// doesn't map them on every write) where the kernel supports it, or with pwrite otherwise.
+//
+// A write() that doesn't fit in the free buffers is dropped whole and counted. Nothing
+// waits for the disk, and a file that is written in whole records stays parseable.
+class AsyncWriter {
+public:
+    explicit AsyncWriter(const AsyncWriterSettings& settings = AsyncWriterSettings());
+    ~AsyncWriter(); // finishes and closes every stream
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Creates or truncates path. This open is the caller's only syscall for the stream.
+    // Returns a stream id, or -1 if the file can't be opened. Ids of closed streams are
+    // reused, so an id must not be used after close().
+    int open(const std::string& path, const WriterStreamSettings& settings = WriterStreamSettings());
+
+    bool write(int stream, const void* data, size_t size);
+    void flush(int stream); // hands over the partly filled buffer
+    // Flushes; the writer thread syncs (per settings) and closes. With renameTo, the
+    // finished file is then renamed over renameTo, so readers of that path only ever
+    // see a complete file.
+    void close(int stream, const std::string& renameTo = "");
+
+    // Blocks until everything handed over so far is written and closed streams are closed
+    void drain();
+
+    bool usingIoUring() const { return ring != nullptr; }
+    uint64_t bytesWritten() const { return writtenBytes.load(std::memory_order_relaxed); }
+    uint64_t droppedBytes() const { return dropped.load(std::memory_order_relaxed); }
+    uint64_t syncCount() const { return syncs.load(std::memory_order_relaxed); }
+    uint64_t errorCount() const { return errors.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    struct Ring; // io_uring state, defined in the .cpp
+    struct Stream;
+
+    enum class JobKind { Write, Close };
+    struct Job {
+        JobKind kind;
+        Stream* stream;
+        int buffer;      // Write only
+        size_t size;     // bytes still to write
+        uint64_t offset; // file offset of the first of them
+        size_t done;     // bytes of the buffer already written (short writes)
+    };
+
+    struct Stream {
+        int id = -1;
+        WriterStreamSettings settings;
+        intptr_t file = -1;
+        // Caller side, under mutex
+        int buffer = -1;   // partly filled buffer, -1 = none
+        size_t fill = 0;
+        uint64_t offset = 0; // file offset of the current buffer's first byte
+        bool closed = false;
+        std::string path, renameTo;
+        // Writer thread only
+        size_t inFlight = 0;
+        uint64_t unsynced = 0;
+        Clock::time_point lastSync;
+    };
+
+    void run();
+    void handOver(Stream& stream);         // mutex held
+    void wakeWriter();                     // mutex held
+    void finishWrite(const Job& job);      // returns the buffer; takes the mutex
+    void wrote(Stream& stream, size_t bytes);
+    void syncStream(Stream& stream);
+    bool finishClose(Stream& stream);      // true once the stream is closed
+    void writeNow(Job job);                // pwrite backend
+    void submitWrite(const Job& job);      // io_uring backend
+    void armWake();                        // io_uring backend
+    void reapCompletions(bool wait);
+    void reportError(const char* what);
+    Clock::time_point nextTimedSync() const; // mutex held
+
+    AsyncWriterSettings settings;
+    TaggedVector<char, MemoryTag::WriteBuffers> storage; // bufferCount * bufferSize, one allocation
+    std::vector<int> freeBuffers;
+    std::vector<std::unique_ptr<Stream>> streams; // by id; null once closed, until the id is reused
+    std::vector<int> freeStreamIds;
+    std::deque<Job> queue;
+    size_t pending = 0;               // jobs handed over and not yet finished
+    bool stopping = false;
+
+    std::mutex mutex;
+    std::condition_variable wake;     // work for the writer thread
+    std::condition_variable drained;  // pending reached zero
+
+    std::unique_ptr<Ring> ring;       // null = pwrite backend
+    int wakeFd = -1;                  // io_uring: eventfd that wakes the writer while it waits in the kernel
+    bool waitingInRing = false;       // io_uring: the writer is (about to be) blocked in the kernel; under mutex
+    bool wakeArmed = false;           // io_uring: a poll on wakeFd is in the ring
+    std::vector<Job> inFlightWrites;  // io_uring: by buffer index
+    size_t ringInFlight = 0;          // io_uring: submissions not yet completed
+    std::vector<Stream*> closing;     // close requested, writes or syncs still in flight
+
+    std::atomic<uint64_t> writtenBytes{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> syncs{0};
+    std::atomic<uint64_t> errors{0};
+    std::thread worker;
+};
@@ -0,0 +1,310 @@
+/******************************************************
+ *  Baked Tracks - built-in track tables computed at compile time
+ ******************************************************/
+#pragma once
+
+#include "geometry.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// -------------------- Build Parameters --------------------
+// Shared with the runtime builder in track.cpp
+static constexpr float TRACK_WALL_GRID_CELL = 64.f;
+static constexpr float TRACK_MAX_MITER_SCALE = 4.f; // sharp corners would otherwise push walls to infinity
+
+// -------------------- Table Types --------------------
+struct BakedWall {
+    float length;   // border rectangle length
+    float rotation; // degrees
+};
+
+struct BakedGate {
+    uint32_t segment; // closest centreline segment
+    float distance;   // checkpoint's distance to it
+    float rotation;   // degrees, across the road
+};
+
+// Everything Track::build derives from a layout, as flat arrays. Wall ids follow the
+// runtime builder: 2*i is the outer wall of segment i, 2*i+1 the inner one.
+struct BakedTrackTables {
+    size_t vertexCount;
+    const GeoPoint* centreline;   // to check the layout still matches
+    float wallOffset;
+    const GeoPoint* outerCorners; // per vertex
+    const GeoPoint* innerCorners;
+    const GeoPoint* normals;      // per segment
+    const BakedWall* walls;       // per wall id
+    size_t gateCount;
+    const GeoPoint* checkpoints;
+    const BakedGate* gates;
+    GeoPoint gridOrigin;
+    int gridColumns;
+    int gridRows;
+    const uint32_t* cellStart;    // gridColumns*gridRows+1 offsets into cellIds
+    const uint32_t* cellIds;
+};
+
+// -------------------- Layout Data --------------------
+template <size_t N, size_t C>
+struct BakedLayoutData {
+    std::array<GeoPoint, N> centreline;
+    std::array<GeoPoint, C> checkpoints;
+    float width;
+    float wallOffset;
+};
+
+// Point at arc length s along a polyline
+template <size_t N>
+constexpr GeoPoint bakedPointAlong(const std::array<GeoPoint, N>& P, float s) {
+    float before = 0.f, at = 0.f;
+    size_t i = 1;
+    for (; i < N; i++) {
+        GeoPoint d = P[i] - P[i - 1];
+        before = at;
+        at += geoSqrt(d.x * d.x + d.y * d.y);
+        if (i + 1 == N || at >= s) break;
+    }
+    float span = at - before;
+    float t = span > 0.f ? (s - before) / span : 0.f;
+    return P[i - 1] + (P[i] - P[i - 1]) * t;
+}
+
+// C checkpoints evenly spaced by arc length, centred in their stretch of track
+template <size_t C, size_t N>
+constexpr std::array<GeoPoint, C> bakedSpacedCheckpoints(const std::array<GeoPoint, N>& P) {
+    float total = 0.f;
+    for (size_t i = 1; i < N; i++) {
+        GeoPoint d = P[i] - P[i - 1];
+        total += geoSqrt(d.x * d.x + d.y * d.y);
+    }
+    std::array<GeoPoint, C> checkpoints{};
+    for (size_t c = 0; c < C; c++) checkpoints[c] = bakedPointAlong(P, total * (c + 0.5f) / C);
+    return checkpoints;
+}
+
+// -------------------- Geometry --------------------
+template <size_t N, size_t C>
+struct BakedGeometry {
+    std::array<GeoPoint, N> outer{}, inner{};
+    std::array<GeoPoint, N - 1> normals{};
+    std::array<BakedWall, 2 * (N - 1)> walls{};
+    std::array<BakedGate, C> gates{};
+    GeoPoint gridOrigin{};
+    int gridColumns = 0;
+    int gridRows = 0;
+};
+
+constexpr BakedWall bakedWall(GeoPoint start, GeoPoint end) {
+    GeoPoint diff = end - start;
+    return BakedWall{geoSqrt(diff.x * diff.x + diff.y * diff.y), geoAtan2(diff.y, diff.x) * 180.f / GEO_PI};
+}
+
+template <size_t N, size_t C>
+constexpr BakedGeometry<N, C> bakeGeometry(const BakedLayoutData<N, C>& layout) {
+    static_assert(N >= 2, "a track needs at least one segment");
+    const auto& P = layout.centreline;
+    const bool loop = N > 2 && P[0] == P[N - 1];
+    BakedGeometry<N, C> g{};
+
+    // Same neighbour rules as Track::computeCorner
+    for (size_t v = 0; v < N; v++) {
+        GeoPoint prev{}, next{};
+        bool hasPrev = true, hasNext = true;
+        if (v > 0) prev = P[v - 1];
+        else if (loop) prev = P[N - 2];
+        else hasPrev = false;
+        if (v + 1 < N) next = P[v + 1];
+        else if (loop) next = P[1];
+        else hasNext = false;
+        geoMiterCorner(prev, P[v], next, hasPrev, hasNext, layout.wallOffset, TRACK_MAX_MITER_SCALE,
+                       ConstexprSqrt{}, g.outer[v], g.inner[v]);
+    }
+
+    for (size_t s = 0; s + 1 < N; s++) {
+        g.normals[s] = geoUnitNormal(P[s + 1] - P[s], ConstexprSqrt{});
+        g.walls[2 * s] = bakedWall(g.outer[s], g.outer[s + 1]);
+        g.walls[2 * s + 1] = bakedWall(g.inner[s], g.inner[s + 1]);
+    }
+
+    for (size_t c = 0; c < C; c++) {
+        BakedGate gate{0, 3.4e38f, 0.f};
+        for (size_t s = 0; s + 1 < N; s++) {
+            float d = geoPointSegmentDistance(layout.checkpoints[c], P[s], P[s + 1], ConstexprSqrt{});
+            if (d < gate.distance) {
+                gate.distance = d;
+                gate.segment = static_cast<uint32_t>(s);
+            }
+        }
+        GeoPoint dir = P[gate.segment + 1] - P[gate.segment];
+        gate.rotation = geoAtan2(dir.y, dir.x) * 180.f / GEO_PI + 90.f;
+        g.gates[c] = gate;
+    }
+
+    // Grid covers the walls' bounds plus one cell of padding, as in WallGrid::build
+    float minX = g.outer[0].x, maxX = minX, minY = g.outer[0].y, maxY = minY;
+    for (size_t v = 0; v < N; v++) {
+        for (GeoPoint p : {g.outer[v], g.inner[v]}) {
+            minX = std::min(minX, p.x);
+            maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+        }
+    }
+    g.gridOrigin = GeoPoint{minX - TRACK_WALL_GRID_CELL, minY - TRACK_WALL_GRID_CELL};
+    g.gridColumns = geoCeil((maxX - minX) / TRACK_WALL_GRID_CELL) + 2;
+    g.gridRows = geoCeil((maxY - minY) / TRACK_WALL_GRID_CELL) + 2;
+    return g;
+}
+
+// -------------------- Wall Grid --------------------
+template <size_t N, size_t C>
+constexpr GeoPoint bakedWallEnd(const BakedGeometry<N, C>& g, size_t id, bool end) {
+    size_t s = id / 2 + (end ? 1 : 0);
+    return id % 2 == 0 ? g.outer[s] : g.inner[s];
+}
+
+// Calls visit(cell) for every grid cell wall `id` goes into, in WallGrid::insert order
+template <size_t N, size_t C, typename Visit>
+constexpr void bakedForEachWallCell(const BakedGeometry<N, C>& g, size_t id, Visit visit) {
+    GeoPoint a = bakedWallEnd(g, id, false), b = bakedWallEnd(g, id, true);
+    auto cellX = [&](float x) { return geoFloor((x - g.gridOrigin.x) / TRACK_WALL_GRID_CELL); };
+    auto cellY = [&](float y) { return geoFloor((y - g.gridOrigin.y) / TRACK_WALL_GRID_CELL); };
+    int x0 = std::max(0, cellX(std::min(a.x, b.x)));
+    int x1 = std::min(g.gridColumns - 1, cellX(std::max(a.x, b.x)));
+    int y0 = std::max(0, cellY(std::min(a.y, b.y)));
+    int y1 = std::min(g.gridRows - 1, cellY(std::max(a.y, b.y)));
+
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            float bx = g.gridOrigin.x + cx * TRACK_WALL_GRID_CELL;
+            float by = g.gridOrigin.y + cy * TRACK_WALL_GRID_CELL;
+            if (geoSegmentTouchesBox(a, b, bx, by, bx + TRACK_WALL_GRID_CELL, by + TRACK_WALL_GRID_CELL)) {
+                visit(static_cast<size_t>(cy) * g.gridColumns + cx);
+            }
+        }
+    }
+}
+
+template <size_t N, size_t C>
+constexpr size_t bakedCellRefCount(const BakedGeometry<N, C>& g) {
+    size_t count = 0;
+    for (size_t id = 0; id < 2 * (N - 1); id++) {
+        bakedForEachWallCell(g, id, [&](size_t) { count++; });
+    }
+    return count;
+}
+
+template <size_t Cells, size_t Refs>
+struct BakedGrid {
+    std::array<uint32_t, Cells + 1> cellStart{};
+    std::array<uint32_t, Refs> cellIds{};
+};
+
+// Counting sort by cell; walls are visited in id order, so each cell lists its ids ascending
+template <size_t Cells, size_t Refs, size_t N, size_t C>
+constexpr BakedGrid<Cells, Refs> bakeGrid(const BakedGeometry<N, C>& g) {
+    BakedGrid<Cells, Refs> grid{};
+    for (size_t id = 0; id < 2 * (N - 1); id++) {
+        bakedForEachWallCell(g, id, [&](size_t cell) { grid.cellStart[cell + 1]++; });
+    }
+    for (size_t i = 0; i < Cells; i++) grid.cellStart[i + 1] += grid.cellStart[i];
+
+    std::array<uint32_t, Cells> fill{};
+    for (size_t id = 0; id < 2 * (N - 1); id++) {
+        bakedForEachWallCell(g, id, [&](size_t cell) {
+            grid.cellIds[grid.cellStart[cell] + fill[cell]++] = static_cast<uint32_t>(id);
+        });
+    }
+    return grid;
+}
+
+// -------------------- Per-Track Tables --------------------
+template <const auto& Layout>
+struct BakedTrack {
+    static constexpr auto geometry = bakeGeometry(Layout);
+    static constexpr size_t cellCount = static_cast<size_t>(geometry.gridColumns) * geometry.gridRows;
+    static constexpr auto grid = bakeGrid<cellCount, bakedCellRefCount(geometry)>(geometry);
+
+    static constexpr BakedTrackTables tables = {
+        Layout.centreline.size(), Layout.centreline.data(), Layout.wallOffset,
+        geometry.outer.data(), geometry.inner.data(), geometry.normals.data(), geometry.walls.data(),
+        Layout.checkpoints.size(), Layout.checkpoints.data(), geometry.gates.data(),
+        geometry.gridOrigin, geometry.gridColumns, geometry.gridRows,
+        grid.cellStart.data(), grid.cellIds.data(),
+    };
+};
+
+// -------------------- Built-In Layouts --------------------
+// A simple rectangular track with rounded corners
+inline constexpr BakedLayoutData<13, 4> RECTANGLE_LAYOUT = {
+    {{{200, 400}, {400, 400}, {600, 400}, {800, 400},
+      {900, 400}, {900, 300}, {900, 200}, {800, 200},
+      {600, 200}, {400, 200}, {200, 200}, {200, 300}, {200, 400}}},
+    {{{500, 400}, {900, 300}, {500, 200}, {200, 300}}},
+    80.f, 50.f,
+};
+
+inline constexpr std::array<GeoPoint, 9> HEXAGON_CENTRELINE = {{
+    {200, 600}, {500, 650}, {800, 600}, {900, 400}, {800, 200},
+    {500, 150}, {200, 200}, {100, 400}, {200, 600}
+}};
+inline constexpr BakedLayoutData<9, 4> HEXAGON_LAYOUT = {
+    HEXAGON_CENTRELINE, bakedSpacedCheckpoints<4>(HEXAGON_CENTRELINE), 80.f, 50.f,
+};
+
+inline constexpr std::array<GeoPoint, 11> L_SHAPE_CENTRELINE = {{
+    {150, 700}, {500, 700}, {850, 700}, {850, 500}, {650, 500}, {450, 500},
+    {450, 325}, {450, 150}, {150, 150}, {150, 425}, {150, 700}
+}};
+inline constexpr BakedLayoutData<11, 4> L_SHAPE_LAYOUT = {
+    L_SHAPE_CENTRELINE, bakedSpacedCheckpoints<4>(L_SHAPE_CENTRELINE), 80.f, 50.f,
+};
+
+// -------------------- Static Checks --------------------
+constexpr bool bakedNear(GeoPoint p, float x, float y) {
+    return p.x - x < 1e-3f && x - p.x < 1e-3f && p.y - y < 1e-3f && y - p.y < 1e-3f;
+}
+
+// The rectangle's mitered walls must land exactly where the original hand-placed
+// borders were: outer 150..950 x 150..450, inner 250..850 x 250..350
+static_assert(bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.outer[0], 150, 450) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.outer[4], 950, 450) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.outer[6], 950, 150) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.outer[10], 150, 150) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.inner[0], 250, 350) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.inner[4], 850, 350) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.inner[6], 850, 250) &&
+              bakedNear(BakedTrack<RECTANGLE_LAYOUT>::geometry.inner[10], 250, 250),
+              "baked rectangle walls moved away from the original borders");
+
+// The rectangle's checkpoints sit on the centreline, so every gate is at distance 0
+static_assert(BakedTrack<RECTANGLE_LAYOUT>::geometry.gates[0].distance == 0.f &&
+              BakedTrack<RECTANGLE_LAYOUT>::geometry.gates[1].distance == 0.f &&
+              BakedTrack<RECTANGLE_LAYOUT>::geometry.gates[2].distance == 0.f &&
+              BakedTrack<RECTANGLE_LAYOUT>::geometry.gates[3].distance == 0.f,
+              "baked rectangle gates are off the centreline");
+
+// Every wall goes into at least one cell and the cell index is consistent
+template <const auto& Layout>
+constexpr bool bakedGridConsistent() {
+    using Track = BakedTrack<Layout>;
+    const auto& grid = Track::grid;
+    if (grid.cellStart[0] != 0 || grid.cellStart[Track::cellCount] != grid.cellIds.size()) return false;
+    std::array<bool, 2 * (Layout.centreline.size() - 1)> seen{};
+    for (size_t i = 0; i < Track::cellCount; i++) {
+        if (grid.cellStart[i] > grid.cellStart[i + 1]) return false;
+        for (size_t k = grid.cellStart[i]; k < grid.cellStart[i + 1]; k++) {
+            if (grid.cellIds[k] >= seen.size()) return false;
+            seen[grid.cellIds[k]] = true;
+        }
+    }
+    for (bool wall : seen) {
+        if (!wall) return false;
+    }
+    return true;
+}
+static_assert(bakedGridConsistent<RECTANGLE_LAYOUT>(), "baked rectangle wall grid is inconsistent");
+static_assert(bakedGridConsistent<HEXAGON_LAYOUT>(), "baked hexagon wall grid is inconsistent");
+static_assert(bakedGridConsistent<L_SHAPE_LAYOUT>(), "baked L-shape wall grid is inconsistent");
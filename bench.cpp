@@ -0,0 +1,1329 @@
+/******************************************************
+ *  Speed Racers - micro-benchmarks (make bench && ./bench)
+ ******************************************************/
+
+#include "artifact.hpp"
+#include "async_writer.hpp"
+#include "car_renderer.hpp"
+#include "collision_cache.hpp"
+#include "controller_eval.hpp"
+#include "geometry.hpp"
+#include "memory_budget.hpp"
+#include "novelty_archive.hpp"
+#include "optimizer.hpp"
+#include "wall_grid.hpp"
+#include "sensors.hpp"
+#include "policy.hpp"
+#include "racing_line.hpp"
+#include "remote_eval.hpp"
+#include "replay.hpp"
+#include "style_archive.hpp"
+#include "telemetry.hpp"
+#include "track.hpp"
+#include "trainer.hpp"
+#include "vehicle.hpp"
+
+#include <SFML/System.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// -------------------- Helpers --------------------
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Walls of the default rectangle track (same literals as main.cpp)
+static std::vector<WallSegment> defaultTrackWalls() {
+    std::vector<WallSegment> walls;
+    appendPolylineWalls({{150, 450}, {950, 450}, {950, 150}, {150, 150}, {150, 450}}, walls);
+    appendPolylineWalls({{250, 350}, {850, 350}, {850, 250}, {250, 250}, {250, 350}}, walls);
+    return walls;
+}
+
+// A wavy closed circuit with many short wall segments, for scaling tests
+static std::vector<WallSegment> wavyTrackWalls(size_t segments, float radius, float halfWidth) {
+    std::vector<sf::Vector2f> outer, inner;
+    for (size_t i = 0; i <= segments; i++) {
+        float a = 2.f * GEO_PI * i / segments;
+        float r = radius + 0.1f * radius * std::sin(7.f * a);
+        outer.push_back({std::cos(a) * (r + halfWidth), std::sin(a) * (r + halfWidth)});
+        inner.push_back({std::cos(a) * (r - halfWidth), std::sin(a) * (r - halfWidth)});
+    }
+    std::vector<WallSegment> walls;
+    appendPolylineWalls(outer, walls);
+    appendPolylineWalls(inner, walls);
+    return walls;
+}
+
+// Same wavy circle as a closed track layout, for modules that take a Track
+static TrackLayout wavyTrackLayout(size_t points, float radius) {
+    TrackLayout layout;
+    layout.name = "wavy circuit";
+    for (size_t i = 0; i <= points; i++) {
+        float a = 2.f * GEO_PI * (i % points) / points;
+        float r = radius + 0.1f * radius * std::sin(7.f * a);
+        layout.centreline.push_back({std::cos(a) * r, std::sin(a) * r});
+    }
+    layout.checkpoints = {layout.centreline[0], layout.centreline[points / 2]};
+    layout.initialLine = layout.centreline;
+    return layout;
+}
+
+// Reference answer: test the ray against every wall
+static float bruteForceRay(const std::vector<WallSegment>& walls, sf::Vector2f o, sf::Vector2f d, float maxRange) {
+    float best = maxRange;
+    for (const auto& w : walls) {
+        sf::Vector2f e = w.b - w.a;
+        sf::Vector2f q = w.a - o;
+        float denom = d.x * e.y - d.y * e.x;
+        if (denom == 0.f) continue;
+        float t = (q.x * e.y - q.y * e.x) / denom;
+        float s = (q.x * d.y - q.y * d.x) / denom;
+        if (t >= 0.f && t < best && s >= 0.f && s <= 1.f) best = t;
+    }
+    return best;
+}
+
+// -------------------- Ray-Cast Sensors --------------------
+static void benchSensors(const char* name, const std::vector<WallSegment>& walls, float cellSize,
+                         sf::Vector2f areaMin, sf::Vector2f areaMax) {
+    WallGrid grid;
+    grid.build(walls, cellSize);
+    SensorRig rig = makeSensorFan(8, 180.f, 600.f);
+
+    const size_t CARS = 4096;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> px(areaMin.x, areaMax.x), py(areaMin.y, areaMax.y), heading(0.f, 360.f);
+    std::vector<float> x(CARS), y(CARS), h(CARS), out(CARS * rig.anglesDeg.size()), scratch;
+    for (size_t i = 0; i < CARS; i++) {
+        x[i] = px(rng);
+        y[i] = py(rng);
+        h[i] = heading(rng);
+    }
+
+    // Correctness against brute force on a subset
+    castSensorRays(grid, rig, x.data(), y.data(), h.data(), CARS, out.data(), scratch);
+    float maxError = 0.f;
+    for (size_t i = 0; i < 256; i++) {
+        for (size_t k = 0; k < rig.anglesDeg.size(); k++) {
+            float a = (h[i] + rig.anglesDeg[k]) * GEO_PI / 180.f;
+            float ref = bruteForceRay(walls, {x[i], y[i]}, {std::cos(a), std::sin(a)}, rig.maxRange);
+            maxError = std::max(maxError, std::fabs(ref - out[i * rig.anglesDeg.size() + k]));
+        }
+    }
+
+    const int REPEATS = 50;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPEATS; r++) {
+        castSensorRays(grid, rig, x.data(), y.data(), h.data(), CARS, out.data(), scratch);
+    }
+    double elapsed = secondsSince(start);
+    double rays = static_cast<double>(REPEATS) * CARS * rig.anglesDeg.size();
+
+    std::cout << std::left << std::setw(28) << name
+              << std::setw(8) << walls.size() << " walls  "
+              << std::fixed << std::setprecision(2) << rays / elapsed / 1e6 << " Mrays/s  "
+              << "max error " << std::setprecision(4) << maxError << "\n";
+}
+
+// -------------------- Policy Inference --------------------
+static void benchPolicy() {
+    // Realistic inputs: sensor readings of random cars on the wavy circuit
+    std::vector<WallSegment> walls = wavyTrackWalls(2000, 3000.f, 60.f);
+    WallGrid grid;
+    grid.build(walls, 64.f);
+    SensorRig rig = makeSensorFan(8, 180.f, 600.f);
+
+    const size_t SAMPLES = 4096;
+    const size_t IN = rig.anglesDeg.size() + 1;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> angle(0.f, 2.f * GEO_PI), offset(-50.f, 50.f), unit(0.f, 1.f);
+    std::vector<float> x(SAMPLES), y(SAMPLES), h(SAMPLES), rays(SAMPLES * rig.anglesDeg.size()), scratch;
+    for (size_t i = 0; i < SAMPLES; i++) {
+        float a = angle(rng);
+        float r = 3000.f + 300.f * std::sin(7.f * a) + offset(rng);
+        x[i] = std::cos(a) * r;
+        y[i] = std::sin(a) * r;
+        h[i] = unit(rng) * 360.f;
+    }
+    castSensorRays(grid, rig, x.data(), y.data(), h.data(), SAMPLES, rays.data(), scratch);
+
+    std::vector<float> inputs(SAMPLES * IN);
+    for (size_t i = 0; i < SAMPLES; i++) {
+        for (size_t k = 0; k < rig.anglesDeg.size(); k++) {
+            inputs[i * IN + k] = rays[i * rig.anglesDeg.size() + k] / rig.maxRange;
+        }
+        inputs[i * IN + IN - 1] = unit(rng);
+    }
+
+    PolicyNet net = makePolicyNet({IN, 64, 64, 2});
+    randomizePolicy(net, rng);
+    QuantizedPolicy quantized = quantizePolicy(net, inputs.data(), 512);
+
+    std::vector<float> reference(SAMPLES * 2), result(SAMPLES * 2);
+    const int REPEATS = 20;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPEATS; r++) evaluatePolicy(net, inputs.data(), SAMPLES, reference.data());
+    double floatRate = REPEATS * SAMPLES / secondsSince(start);
+    std::cout << std::left << std::setw(28) << "float" << std::fixed << std::setprecision(2)
+              << floatRate / 1e6 << " M inferences/s\n";
+
+    Int8Kernel best = detectInt8Kernel();
+    for (Int8Kernel kernel : {Int8Kernel::Scalar, Int8Kernel::Avx2, Int8Kernel::AvxVnni}) {
+        if (static_cast<int>(kernel) > static_cast<int>(best)) continue;
+
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < REPEATS; r++) {
+            evaluateQuantizedPolicy(quantized, inputs.data(), SAMPLES, result.data(), kernel);
+        }
+        double rate = REPEATS * SAMPLES / secondsSince(start);
+
+        float maxError = 0.f, meanError = 0.f;
+        for (size_t i = 0; i < result.size(); i++) {
+            float e = std::fabs(result[i] - reference[i]);
+            maxError = std::max(maxError, e);
+            meanError += e;
+        }
+        meanError /= result.size();
+
+        std::cout << std::left << std::setw(28) << (std::string("int8 ") + int8KernelName(kernel))
+                  << std::fixed << std::setprecision(2) << rate / 1e6 << " M inferences/s  ("
+                  << rate / floatRate << "x)  error vs float: mean " << std::setprecision(4) << meanError
+                  << " max " << maxError << "\n";
+    }
+}
+
+// -------------------- Racing Line Queries --------------------
+// Waypoint spacing stays ~20 units, so the circuit grows with the point count
+static void benchRacingLine(size_t points) {
+    const float radius = points * 3.f;
+    std::vector<sf::Vector2f> line;
+    for (size_t i = 0; i <= points; i++) {
+        float a = 2.f * GEO_PI * i / points;
+        float r = radius + 0.1f * radius * std::sin(7.f * a);
+        line.push_back({std::cos(a) * r, std::sin(a) * r});
+    }
+    RacingLine racingLine;
+    racingLine.build(line);
+
+    const size_t QUERIES = 200000;
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> angle(0.f, 2.f * GEO_PI), offset(-80.f, 80.f);
+    std::vector<sf::Vector2f> queries(QUERIES);
+    for (auto& q : queries) {
+        float a = angle(rng);
+        float r = radius + 0.1f * radius * std::sin(7.f * a) + offset(rng);
+        q = {std::cos(a) * r, std::sin(a) * r};
+    }
+
+    // Brute-force check on a subset
+    float maxError = 0.f;
+    for (size_t i = 0; i < 200; i++) {
+        float best = 1e30f;
+        for (size_t s = 0; s + 1 < line.size(); s++) {
+            sf::Vector2f ab = line[s + 1] - line[s], ap = queries[i] - line[s];
+            float t = std::clamp((ap.x * ab.x + ap.y * ab.y) / (ab.x * ab.x + ab.y * ab.y), 0.f, 1.f);
+            sf::Vector2f d = ap - ab * t;
+            best = std::min(best, std::sqrt(d.x * d.x + d.y * d.y));
+        }
+        maxError = std::max(maxError, std::fabs(best - racingLine.closest(queries[i]).distance));
+    }
+
+    volatile float sink = 0.f;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& q : queries) sink = racingLine.closest(q).arcLength;
+    double rate = QUERIES / secondsSince(start);
+    (void)sink;
+
+    std::cout << std::left << std::setw(28) << (std::to_string(points) + " segments") << std::fixed
+              << std::setprecision(2) << rate / 1e6 << " M queries/s  max error " << std::setprecision(4)
+              << maxError << "\n";
+}
+
+// -------------------- Baked Track Tables --------------------
+// Built-in layouts load compile-time tables; they must match what the runtime builder derives
+static void benchBakedTrack(const TrackLayout& layout) {
+    TrackLayout runtimeLayout = layout;
+    runtimeLayout.baked = nullptr;
+
+    Track baked, runtime;
+    baked.build(layout);
+    runtime.build(runtimeLayout);
+
+    // Walls and grid cells must be bit-identical, shape rotations within atan2 rounding
+    bool identical = baked.walls().columns() == runtime.walls().columns() &&
+                     baked.walls().rows() == runtime.walls().rows() &&
+                     baked.walls().origin() == runtime.walls().origin() &&
+                     baked.walls().segments().size() == runtime.walls().segments().size();
+    for (size_t i = 0; identical && i < baked.walls().segments().size(); i++) {
+        identical = baked.walls().segments()[i].a == runtime.walls().segments()[i].a &&
+                    baked.walls().segments()[i].b == runtime.walls().segments()[i].b;
+    }
+    for (int cy = 0; identical && cy < baked.walls().rows(); cy++) {
+        for (int cx = 0; identical && cx < baked.walls().columns(); cx++) {
+            identical = baked.walls().cell(cx, cy).ids == runtime.walls().cell(cx, cy).ids;
+        }
+    }
+    float maxRotationError = 0.f;
+    for (size_t i = 0; i < baked.borders().size(); i++) {
+        maxRotationError = std::max(maxRotationError, std::fabs(baked.borders()[i].getRotation() - runtime.borders()[i].getRotation()));
+    }
+    for (size_t i = 0; i < baked.checkpointShapes().size(); i++) {
+        maxRotationError = std::max(maxRotationError,
+                                    std::fabs(baked.checkpointShapes()[i].getRotation() - runtime.checkpointShapes()[i].getRotation()));
+    }
+
+    const int BUILDS = 2000;
+    Track track;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BUILDS; i++) track.build(layout);
+    double bakedUs = secondsSince(start) / BUILDS * 1e6;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BUILDS; i++) track.build(runtimeLayout);
+    double runtimeUs = secondsSince(start) / BUILDS * 1e6;
+
+    std::cout << std::left << std::setw(28) << layout.name << std::fixed << std::setprecision(1) << bakedUs
+              << " us baked vs " << runtimeUs << " us runtime  " << (identical ? "identical" : "MISMATCH")
+              << "  max rotation error " << std::setprecision(5) << maxRotationError << " deg\n";
+}
+
+// -------------------- Controller Evaluation --------------------
+// Scoring genomes on K tracks in one batched call vs K single-track calls. Every lane
+// is independent, so the per-track scores must come out identical.
+static void benchControllers() {
+    std::vector<EvalTrack> tracks;
+    for (const auto& layout : builtinTrackLayouts()) {
+        Track track;
+        track.build(layout);
+        tracks.push_back(makeEvalTrack(track));
+    }
+    const size_t K = tracks.size();
+
+    ControllerEvalSettings settings;
+    const size_t GENOMES = 64;
+    std::mt19937 rng(11);
+    std::vector<PolicyNet> genomes;
+    for (size_t g = 0; g < GENOMES; g++) {
+        genomes.push_back(makePolicyNet({settings.rig.anglesDeg.size() + 1, 32, 32, 2}));
+        randomizePolicy(genomes.back(), rng);
+        genomes.back().params.back() = 0.5f; // throttle bias, so cars get moving
+    }
+
+    std::vector<float> fitness(GENOMES), single(GENOMES * K), batched(GENOMES * K), column(GENOMES);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t k = 0; k < K; k++) {
+        evaluateControllers(genomes, {tracks[k]}, settings, fitness.data(), column.data());
+        for (size_t g = 0; g < GENOMES; g++) single[g * K + k] = column[g];
+    }
+    double singleUs = secondsSince(start) / GENOMES * 1e6;
+
+    start = std::chrono::steady_clock::now();
+    evaluateControllers(genomes, tracks, settings, fitness.data(), batched.data());
+    double batchedUs = secondsSince(start) / GENOMES * 1e6;
+
+    WorkPool pool;
+    int group = pool.addGroup("bench");
+    start = std::chrono::steady_clock::now();
+    evaluateControllers(pool, group, genomes, tracks, settings, fitness.data(), batched.data());
+    double pooledUs = secondsSince(start) / GENOMES * 1e6;
+
+    float best = *std::max_element(fitness.begin(), fitness.end());
+    std::cout << std::left << std::setw(28) << (std::to_string(K) + " tracks, per genome") << std::fixed << std::setprecision(1)
+              << singleUs << " us as " << K << " calls, " << batchedUs << " us batched (" << std::setprecision(2)
+              << singleUs / batchedUs << "x), " << std::setprecision(1) << pooledUs << " us on " << pool.threadCount()
+              << " threads  " << (single == batched ? "identical" : "MISMATCH") << "  best fitness "
+              << std::setprecision(3) << best << "\n";
+}
+
+// -------------------- Remote Evaluation --------------------
+// A coordinator and three workers over loopback. One worker hangs up partway through;
+// its batches are reissued to the others and every score must still match local
+// evaluation exactly.
+static void benchRemote() {
+    const std::vector<TrackLayout> layouts = builtinTrackLayouts();
+    std::vector<EvalTrack> tracks;
+    for (const auto& layout : layouts) {
+        Track track;
+        track.build(layout);
+        tracks.push_back(makeEvalTrack(track));
+    }
+    ControllerEvalSettings settings;
+    const std::vector<size_t> layers = {settings.rig.anglesDeg.size() + 1, 32, 32, 2};
+    const size_t GENOMES = 128;
+    std::mt19937 rng(17);
+    std::vector<PolicyNet> genomes;
+    for (size_t g = 0; g < GENOMES; g++) {
+        genomes.push_back(makePolicyNet(layers));
+        randomizePolicy(genomes.back(), rng);
+        genomes.back().params.back() = 0.5f;
+    }
+
+    const size_t K = tracks.size();
+    std::vector<float> local(GENOMES), localScores(GENOMES * K), remote(GENOMES), remoteScores(GENOMES * K);
+    auto start = std::chrono::steady_clock::now();
+    evaluateControllers(genomes, tracks, settings, local.data(), localScores.data());
+    double localMs = secondsSince(start) * 1e3;
+
+    RemoteSettings remoteSettings;
+    remoteSettings.genomesPerBatch = 4;
+    RemoteCoordinator coordinator(remoteSettings);
+    if (!coordinator.listen(0)) {
+        std::cout << "skipped: cannot listen on loopback\n";
+        return;
+    }
+    coordinator.setup(layers, layouts, settings);
+
+    const size_t WORKERS = 3;
+    std::atomic<bool> stop[WORKERS] = {};
+    std::vector<std::thread> workers;
+    const unsigned short port = coordinator.port();
+    for (size_t w = 0; w < WORKERS; w++) {
+        workers.emplace_back([&, w] {
+            WorkPool pool(1);
+            runRemoteWorker("127.0.0.1", port, pool, &stop[w]);
+        });
+    }
+    coordinator.waitForWorkers(WORKERS, 5.f);
+
+    // Lose a worker while it holds batches
+    std::thread failure([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(localMs / 4) + 1));
+        stop[0] = true;
+    });
+    start = std::chrono::steady_clock::now();
+    bool finished = coordinator.evaluate(genomes, remote.data(), remoteScores.data());
+    double remoteMs = secondsSince(start) * 1e3;
+    failure.join();
+    coordinator.shutdown();
+    for (auto& worker : workers) worker.join();
+
+    bool identical = finished && local == remote && localScores == remoteScores;
+    std::cout << std::left << std::setw(28) << (std::to_string(GENOMES) + " genomes, " + std::to_string(WORKERS) + " workers")
+              << std::fixed << std::setprecision(1) << localMs << " ms local, " << remoteMs << " ms remote, "
+              << coordinator.reissuedBatches() << " batches reissued  " << (identical ? "identical" : "MISMATCH") << "\n";
+}
+
+// A "worker" that connects and never reads, ahead of a real one. Its batches are far
+// bigger than the socket buffers, so a blocking send to it would never return; instead
+// it must be dropped after sendTimeout and its batches scored by the other worker.
+static void benchRemoteStall() {
+    const std::vector<TrackLayout> layouts = builtinTrackLayouts();
+    std::vector<EvalTrack> tracks;
+    for (const auto& layout : layouts) {
+        Track track;
+        track.build(layout);
+        tracks.push_back(makeEvalTrack(track));
+    }
+    ControllerEvalSettings settings;
+    settings.maxSteps = 20;
+    const std::vector<size_t> layers = {settings.rig.anglesDeg.size() + 1, 1024, 1024, 2}; // 4 MB per genome
+    const size_t GENOMES = 4;
+    std::mt19937 rng(23);
+    std::vector<PolicyNet> genomes;
+    for (size_t g = 0; g < GENOMES; g++) {
+        genomes.push_back(makePolicyNet(layers));
+        randomizePolicy(genomes.back(), rng);
+    }
+    std::vector<float> local(GENOMES), remote(GENOMES);
+    evaluateControllers(genomes, tracks, settings, local.data());
+
+    RemoteSettings remoteSettings;
+    remoteSettings.genomesPerBatch = 2;
+    remoteSettings.sendTimeout = 1.f;
+    RemoteCoordinator coordinator(remoteSettings);
+    if (!coordinator.listen(0)) {
+        std::cout << "skipped: cannot listen on loopback\n";
+        return;
+    }
+    coordinator.setup(layers, layouts, settings);
+    const unsigned short port = coordinator.port();
+    sf::TcpSocket stalled;
+    stalled.connect(sf::IpAddress("127.0.0.1"), port, sf::seconds(5.f));
+    coordinator.waitForWorkers(1, 5.f);
+    std::thread worker([&] {
+        WorkPool pool(1);
+        runRemoteWorker("127.0.0.1", port, pool);
+    });
+    coordinator.waitForWorkers(2, 5.f);
+
+    auto start = std::chrono::steady_clock::now();
+    bool finished = coordinator.evaluate(genomes, remote.data());
+    double remoteMs = secondsSince(start) * 1e3;
+    coordinator.shutdown();
+    worker.join();
+    stalled.disconnect();
+
+    bool ok = finished && coordinator.reissuedBatches() > 0 && local == remote;
+    std::cout << std::left << std::setw(28) << "stalled reader, 4 MB nets" << std::fixed << std::setprecision(1) << remoteMs
+              << " ms remote (send timeout 1 s), " << coordinator.reissuedBatches() << " batches reissued  "
+              << (ok ? "identical" : "MISMATCH") << "\n";
+}
+
+// -------------------- Telemetry --------------------
+// Streams records to a UDP socket on loopback, then decodes every datagram that arrived:
+// headers must be in sequence and the records byte-identical to what was pushed
+static void benchTelemetry() {
+    sf::UdpSocket listener;
+    if (listener.bind(sf::Socket::AnyPort, sf::IpAddress("127.0.0.1")) != sf::Socket::Done) {
+        std::cout << "skipped: cannot bind on loopback\n";
+        return;
+    }
+    const size_t RECORDS = 1000;
+    std::vector<TelemetryRecord> sent(RECORDS);
+    for (size_t i = 0; i < RECORDS; i++) {
+        TelemetryRecord& record = sent[i];
+        record = {};
+        record.frame = static_cast<uint32_t>(i / 2);
+        record.car = static_cast<uint8_t>(i % 2);
+        record.checkpoint = static_cast<uint8_t>(i / 97);
+        record.governorLevel = static_cast<uint8_t>(i % 3);
+        record.x = 0.5f * i;
+        record.y = -0.25f * i;
+        record.speed = 0.01f * i;
+        record.heading = static_cast<float>(i % 360);
+        record.simMs = 1.f / (i + 1);
+        record.renderMs = 2.f / (i + 1);
+        record.frameMs = 3.f / (i + 1);
+        record.memoryKB = static_cast<uint32_t>(i * 1024);
+    }
+
+    TelemetrySender sender;
+    sender.start("127.0.0.1", listener.getLocalPort(), 100.f);
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& record : sent) sender.push(record);
+    double pushNs = secondsSince(start) / RECORDS * 1e9;
+    sender.stop(); // sends whatever is still queued
+
+    std::vector<TelemetryRecord> received;
+    std::vector<char> datagram(sf::UdpSocket::MaxDatagramSize);
+    sf::SocketSelector selector;
+    selector.add(listener);
+    size_t datagrams = 0;
+    bool headersOk = true;
+    while (received.size() < RECORDS && selector.wait(sf::milliseconds(500))) {
+        size_t size = 0;
+        sf::IpAddress from;
+        unsigned short fromPort = 0;
+        if (listener.receive(datagram.data(), datagram.size(), size, from, fromPort) != sf::Socket::Done) break;
+        TelemetryHeader header;
+        if (size < sizeof(header)) {
+            headersOk = false;
+            break;
+        }
+        std::memcpy(&header, datagram.data(), sizeof(header));
+        headersOk = headersOk && header.magic == TELEMETRY_MAGIC && header.version == TELEMETRY_VERSION &&
+                    header.sequence == datagrams && header.dropped == 0 &&
+                    size == sizeof(header) + header.count * sizeof(TelemetryRecord);
+        if (!headersOk) break;
+        for (size_t i = 0; i < header.count; i++) {
+            TelemetryRecord record;
+            std::memcpy(&record, datagram.data() + sizeof(header) + i * sizeof(record), sizeof(record));
+            received.push_back(record);
+        }
+        datagrams++;
+    }
+
+    bool identical = headersOk && received.size() == RECORDS &&
+                     std::memcmp(received.data(), sent.data(), RECORDS * sizeof(TelemetryRecord)) == 0;
+    std::cout << std::left << std::setw(28) << (std::to_string(RECORDS) + " records") << std::fixed << std::setprecision(0)
+              << pushNs << " ns per push, " << received.size() << " received in " << datagrams << " datagrams  "
+              << (identical ? "identical" : "MISMATCH") << "\n";
+}
+
+// -------------------- Coarse-to-Fine Optimization --------------------
+// Same budget of pre-races with and without the multi-resolution schedule; the
+// optimizers are randomly seeded, so each is run several times and averaged
+static void benchProgressive(const TrackLayout& layout, int generations, int runs) {
+    Track track;
+    track.build(layout);
+    const float aiSpeed = 3.0f;
+    float initial = simulateRun(layout.initialLine, track.borders(), aiSpeed);
+
+    double flatSum = 0.0, progressiveSum = 0.0, flatSeconds = 0.0, progressiveSeconds = 0.0;
+    float flatBest = initial, progressiveBest = initial;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        float flat = simulateRun(optimizeWaypoints(layout.initialLine, track.borders(), aiSpeed, generations, false), track.borders(), aiSpeed);
+        flatSeconds += secondsSince(start);
+        start = std::chrono::steady_clock::now();
+        float progressive = simulateRun(optimizeWaypointsProgressive(layout.initialLine, track.borders(), aiSpeed, generations,
+                                                                     ProgressiveSettings(), false),
+                                        track.borders(), aiSpeed);
+        progressiveSeconds += secondsSince(start);
+        flatSum += flat;
+        progressiveSum += progressive;
+        flatBest = std::min(flatBest, flat);
+        progressiveBest = std::min(progressiveBest, progressive);
+    }
+    std::cout << std::left << std::setw(10) << layout.name << std::fixed << std::setprecision(3) << "initial " << initial
+              << "  flat mean " << flatSum / runs << " best " << flatBest << " (" << std::setprecision(1)
+              << flatSeconds * 1e3 / runs << " ms)  coarse-to-fine mean " << std::setprecision(3) << progressiveSum / runs << " best "
+              << progressiveBest << " (" << std::setprecision(1) << progressiveSeconds * 1e3 / runs << " ms)\n";
+}
+
+// -------------------- Window Handover --------------------
+// A hairpin whose outbound leg runs into a post. The stopped car re-acquires the return
+// leg right beside waypoint 6 and passes it at speed 0; handing that over would leave the
+// next window's car standing still, so the handover must start it fresh.
+static void benchWindowHandOver() {
+    const float aiSpeed = 3.0f;
+    const std::vector<sf::Vector2f> hairpin = {{0, 0},  {20, 0},  {40, 0},  {60, 0},
+                                               {60, -8}, {40, -8}, {30, -8}, {30, -60}};
+    const size_t stride = 6;
+    BorderGrid grid;
+    grid.build({orientedBox(sf::Transform(), sf::FloatRect(55, -4, 20, 8))});
+    const SimCarState entry{hairpin[0], 0.f, aiSpeed};
+
+    SimCarState raw{hairpin[stride], 0.f, -1.f};
+    int collisions = 0;
+    simulateWindow(hairpin, grid, entry, stride, &raw);
+    simulateRun(hairpin, grid, aiSpeed, &collisions);
+    SimCarState next = windowHandOver(hairpin, grid, entry, stride, aiSpeed);
+
+    const std::vector<sf::Vector2f> following(hairpin.begin() + stride, hairpin.end());
+    float stalled = simulateWindow(following, grid, raw);
+    float resumed = simulateWindow(following, grid, next);
+    bool ok = collisions > 0 && raw.speed == 0.f && next.speed == aiSpeed && next.position == hairpin[stride] &&
+              resumed < MAX_SIM_TIME;
+    std::cout << std::fixed << std::setprecision(2) << collisions << " wall hit(s), car passed the handover at speed " << raw.speed
+              << "; next window from that state " << stalled << " s, from the handover " << resumed << " s  "
+              << (ok ? "resumed" : "STALLED") << "\n";
+}
+
+// -------------------- Racing Styles --------------------
+// A short MAP-Elites run per built-in track: archive coverage, the roster it yields
+// against the hand-placed initial line, and what one archive insertion costs.
+static void benchStyles(const TrackLayout& layout, WorkPool& pool) {
+    StyleSettings settings;
+    settings.batches = 40;
+    Track track;
+    track.build(layout);
+    BorderGrid grid;
+    grid.build(borderBoxes(track.borders()));
+    int initialCollisions = 0;
+    float initial = simulateRun(layout.initialLine, grid, settings.aiSpeed, &initialCollisions);
+
+    auto start = std::chrono::steady_clock::now();
+    StyleArchive archive = searchRacingStyles(layout, pool, settings, false);
+    double seconds = secondsSince(start);
+    std::vector<StyleElite> roster = archive.roster(settings.rosterSize, settings.rosterSlack);
+    size_t evaluations = (settings.batches + 1) * settings.batchSize;
+
+    std::cout << std::left << std::setw(10) << layout.name << std::fixed << std::setprecision(2) << archive.filledCount() << "/"
+              << archive.cellCount() << " cells, " << evaluations << " lines in " << seconds << " s; initial line " << initial
+              << " (" << initialCollisions << " collisions)\n";
+    for (const auto& elite : roster) {
+        std::cout << "          style: fitness " << std::setw(6) << elite.fitness << " inner distance " << std::setw(6) << elite.innerDistance
+                  << " collisions " << elite.collisions << "\n";
+    }
+
+    // Insertion only touches the descriptor's own cell
+    StyleArchive scratch(settings, 2.f * layout.wallOffset);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> distance(0.f, 2.f * layout.wallOffset), fitness(10.f, 30.f);
+    StyleElite probe;
+    probe.waypoints = layout.initialLine;
+    const int INSERTS = 200000;
+    start = std::chrono::steady_clock::now();
+    size_t kept = 0;
+    for (int i = 0; i < INSERTS; i++) {
+        probe.innerDistance = distance(rng);
+        probe.collisions = static_cast<int>(rng() % 6);
+        probe.fitness = fitness(rng);
+        kept += scratch.insert(probe);
+    }
+    std::cout << "          archive insert: " << std::setprecision(1) << secondsSince(start) * 1e9 / INSERTS << " ns per candidate ("
+              << kept << " kept)\n";
+}
+
+// -------------------- Idle-Time Scaling --------------------
+// Endless generations of pre-races on a pool, as TrackManager refines lines while the
+// game is idle. The pool runs on every thread, is parked as a race would resume it, then
+// woken again. Parking must not wait for the pre-races in flight (they give up), and
+// none may run while parked.
+static void benchIdleScaling(const TrackLayout& layout) {
+    Track track;
+    track.build(layout);
+    BorderGrid grid;
+    grid.build(borderBoxes(track.borders()));
+
+    auto pool = std::make_unique<WorkPool>();
+    const unsigned threads = pool->threadCount();
+    const int group = pool->addGroup("refine");
+    std::atomic<int> running{0};
+    std::atomic<uint64_t> items{0};
+    std::atomic<bool> stop{false}, yield{false};
+    std::function<void()> generation = [&] {
+        if (stop) return;
+        pool->submit(
+            group, 2 * threads,
+            [&](size_t) {
+                running++;
+                if (!std::isinf(simulateRun(layout.initialLine, grid, 3.0f, nullptr, &yield))) items++;
+                running--;
+            },
+            [&] { generation(); });
+    };
+
+    const auto PHASE = std::chrono::milliseconds(300);
+    generation();
+    std::this_thread::sleep_for(PHASE);
+    const uint64_t idleItems = items;
+
+    auto start = std::chrono::steady_clock::now();
+    yield = true;
+    pool->setActiveThreads(0);
+    while (running > 0) std::this_thread::yield();
+    const double parkSeconds = secondsSince(start);
+    const uint64_t parkedFrom = items;
+    std::this_thread::sleep_for(PHASE);
+    const uint64_t parkedItems = items - parkedFrom;
+
+    yield = false;
+    pool->setActiveThreads(threads);
+    const uint64_t resumedFrom = items;
+    std::this_thread::sleep_for(PHASE);
+    const uint64_t resumedItems = items - resumedFrom;
+
+    stop = true;
+    pool.reset(); // finishes the generation in flight
+
+    const double phaseSeconds = std::chrono::duration<double>(PHASE).count();
+    std::cout << std::left << std::setw(28) << (layout.name + ", " + std::to_string(threads) + " threads") << std::fixed << std::setprecision(0)
+              << idleItems / phaseSeconds << " pre-races/s idle, parked in " << std::setprecision(2) << parkSeconds * 1e3
+              << " ms (one pre-race " << threads * phaseSeconds / std::max<uint64_t>(1, idleItems) * 1e3 << " ms), "
+              << parkedItems << " while parked, " << std::setprecision(0) << resumedItems / phaseSeconds << "/s resumed  "
+              << (parkedItems == 0 && resumedItems > 0 ? "ok" : "MISMATCH") << std::defaultfloat << "\n";
+}
+
+// -------------------- Novelty Search --------------------
+// k-NN over a large archive: the k-d forest against a linear scan, which must agree
+// exactly. Descriptors are clustered like real trajectories, not uniform.
+static void benchNoveltyArchive(size_t entries, size_t k) {
+    const size_t QUERIES = 1000;
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> spread(0.f, 1000.f);
+    std::normal_distribution<float> jitter(0.f, 30.f);
+    std::vector<float> centres(64 * TRAJECTORY_DIMS);
+    for (float& c : centres) c = spread(rng);
+    auto sample = [&](float* out) {
+        const float* centre = &centres[(rng() % 64) * TRAJECTORY_DIMS];
+        for (size_t d = 0; d < TRAJECTORY_DIMS; d++) out[d] = centre[d] + jitter(rng);
+    };
+
+    std::vector<float> all(entries * TRAJECTORY_DIMS);
+    for (size_t i = 0; i < entries; i++) sample(&all[i * TRAJECTORY_DIMS]);
+    NoveltyArchive archive(TRAJECTORY_DIMS);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < entries; i++) archive.insert(&all[i * TRAJECTORY_DIMS]);
+    double insertSeconds = secondsSince(start);
+
+    std::vector<float> queries(QUERIES * TRAJECTORY_DIMS);
+    for (size_t q = 0; q < QUERIES; q++) sample(&queries[q * TRAJECTORY_DIMS]);
+    std::vector<std::vector<float>> indexed(QUERIES), scanned(QUERIES);
+    start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < QUERIES; q++) archive.nearest(&queries[q * TRAJECTORY_DIMS], k, indexed[q]);
+    double indexedSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<float> distances(entries);
+    for (size_t q = 0; q < QUERIES; q++) {
+        const float* query = &queries[q * TRAJECTORY_DIMS];
+        for (size_t i = 0; i < entries; i++) {
+            float d = 0.f;
+            for (size_t a = 0; a < TRAJECTORY_DIMS; a++) {
+                float diff = all[i * TRAJECTORY_DIMS + a] - query[a];
+                d += diff * diff;
+            }
+            distances[i] = d;
+        }
+        std::partial_sort(distances.begin(), distances.begin() + k, distances.end());
+        scanned[q].assign(distances.begin(), distances.begin() + k);
+    }
+    double scanSeconds = secondsSince(start);
+
+    std::cout << std::setw(7) << entries << " entries, " << archive.treeCount() << " trees: insert " << std::fixed << std::setprecision(2)
+              << insertSeconds * 1e6 / entries << " us, " << k << "-NN query " << indexedSeconds * 1e6 / QUERIES << " us vs scan "
+              << scanSeconds * 1e6 / QUERIES << " us  " << (indexed == scanned ? "identical" : "MISMATCH") << "\n";
+}
+
+// Objective-only hill climbing against novelty search, same budget
+static void benchNoveltyTraining(const TrackLayout& layout, WorkPool& pool) {
+    TrainingSettings settings;
+    settings.outputDir = std::filesystem::temp_directory_path().string() + "/bench_novelty";
+    std::vector<TrainingJob> jobs(1);
+    jobs[0].layout = layout;
+    for (bool novelty : {false, true}) {
+        settings.noveltySearch = novelty;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<TrainingResult> results = trainTracks(jobs, pool, settings);
+        std::cout << "  -> " << std::left << std::setw(10) << layout.name << std::setw(10) << (novelty ? "novelty" : "objective")
+                  << std::right << std::fixed << std::setprecision(2) << results[0].fitness << " after " << results[0].generations
+                  << " generations, " << secondsSince(start) << " s\n";
+    }
+    std::filesystem::remove_all(settings.outputDir);
+}
+
+// -------------------- Async Writer --------------------
+// Two streams of 256-byte records written from this thread, as a recorder would. The
+// caller-side cost of each write() is what a game or training thread would pay; the
+// files are read back and compared byte for byte. A synchronous ofstream is the baseline.
+static void fillRecord(std::vector<char>& record, uint32_t stream, uint32_t index) {
+    for (size_t i = 0; i < record.size(); i++) record[i] = static_cast<char>((index * 131 + stream * 17 + i) & 0xFF);
+    std::memcpy(record.data(), &index, sizeof(index));
+}
+
+static bool fileMatches(const std::string& path, uint32_t stream, uint32_t records, std::vector<char>& record) {
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> read(record.size());
+    for (uint32_t r = 0; r < records; r++) {
+        fillRecord(record, stream, r);
+        if (!in.read(read.data(), read.size()) || read != record) return false;
+    }
+    return in.peek() == std::char_traits<char>::eof();
+}
+
+static void benchAsyncWriter(bool allowIoUring) {
+    const std::string dir = std::filesystem::temp_directory_path().string();
+    const std::string paths[2] = {dir + "/bench_stream0.bin", dir + "/bench_stream1.bin"};
+    const uint32_t RECORDS = 1u << 17; // 32 MB per stream
+    std::vector<char> record(256);
+    std::vector<double> latencies;
+    latencies.reserve(2 * RECORDS);
+
+    AsyncWriterSettings settings;
+    settings.allowIoUring = allowIoUring;
+    WriterStreamSettings checkpoints, log;
+    checkpoints.syncEveryBytes = 4 << 20;
+    log.syncEverySeconds = 0.05f;
+    auto start = std::chrono::steady_clock::now();
+    size_t stalls = 0;
+    bool usedRing;
+    uint64_t syncs, dropped;
+    {
+        AsyncWriter writer(settings);
+        usedRing = writer.usingIoUring();
+        int streams[2] = {writer.open(paths[0], checkpoints), writer.open(paths[1], log)};
+        for (uint32_t r = 0; r < RECORDS; r++) {
+            for (uint32_t s = 0; s < 2; s++) {
+                fillRecord(record, s, r);
+                auto before = std::chrono::steady_clock::now();
+                bool accepted = writer.write(streams[s], record.data(), record.size());
+                latencies.push_back(secondsSince(before) * 1e9);
+                // Benchmarks want every byte; a game would just carry on
+                for (; !accepted; stalls++) {
+                    std::this_thread::yield();
+                    accepted = writer.write(streams[s], record.data(), record.size());
+                }
+            }
+        }
+        writer.close(streams[0]);
+        writer.close(streams[1]);
+        writer.drain();
+        syncs = writer.syncCount();
+        dropped = writer.droppedBytes();
+    }
+    double seconds = secondsSince(start);
+    bool identical = fileMatches(paths[0], 0, RECORDS, record) && fileMatches(paths[1], 1, RECORDS, record);
+
+    std::sort(latencies.begin(), latencies.end());
+    double mean = 0.0;
+    for (double l : latencies) mean += l;
+    mean /= latencies.size();
+    std::cout << std::left << std::setw(12) << (usedRing ? "io_uring" : "pwrite") << std::fixed << std::setprecision(0)
+              << 64.0 / seconds << " MB/s, write() mean " << mean << " ns, p99.9 " << latencies[latencies.size() * 999 / 1000]
+              << " ns, max " << latencies.back() / 1e3 << " us; " << syncs << " syncs, " << stalls << " full-pool retries ("
+              << dropped / 256 << " records refused)  " << (identical ? "identical" : "MISMATCH") << "\n";
+
+    // Baseline: the same records written synchronously from this thread
+    latencies.clear();
+    start = std::chrono::steady_clock::now();
+    {
+        std::ofstream out[2] = {std::ofstream(paths[0], std::ios::binary | std::ios::trunc),
+                                std::ofstream(paths[1], std::ios::binary | std::ios::trunc)};
+        for (uint32_t r = 0; r < RECORDS; r++) {
+            for (uint32_t s = 0; s < 2; s++) {
+                fillRecord(record, s, r);
+                auto before = std::chrono::steady_clock::now();
+                out[s].write(record.data(), record.size());
+                latencies.push_back(secondsSince(before) * 1e9);
+            }
+        }
+    }
+    seconds = secondsSince(start);
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << std::left << std::setw(12) << "ofstream" << std::setprecision(0) << 64.0 / seconds << " MB/s, write() p99.9 "
+              << latencies[latencies.size() * 999 / 1000] << " ns, max " << latencies.back() / 1e3 << " us (no syncs)\n";
+    std::filesystem::remove(paths[0]);
+    std::filesystem::remove(paths[1]);
+}
+
+// -------------------- Replays --------------------
+static ReplayPose syntheticPose(size_t i) {
+    float t = static_cast<float>(i) * 0.01f;
+    return {400.f + 300.f * std::cos(t), 400.f + 200.f * std::sin(2.f * t), std::fmod(static_cast<float>(i) * 1.7f, 360.f)};
+}
+
+// Record a long lap through the async writer, then play it back as a ghost at two frames
+// per pose. Integer ticks must return the recorded poses exactly.
+static void benchReplay() {
+    const std::string dir = std::filesystem::temp_directory_path().string() + "/bench_replays";
+    const std::string path = dir + "/" + replayFileName("Bench", "best");
+    const size_t POSES = 100000; // 55 minutes at 30 poses/s
+    const uint64_t hash = 0x5eed;
+
+    auto start = std::chrono::steady_clock::now();
+    bool intact = false;
+    {
+        AsyncWriter writer;
+        ReplayRecorder recorder;
+        recorder.begin(writer, dir, hash, 30);
+        for (size_t i = 0; i < POSES; i++) {
+            ReplayPose p = syntheticPose(i);
+            recorder.record(p.x, p.y, p.heading);
+        }
+        intact = recorder.intact();
+        recorder.finish(path);
+        writer.drain();
+    }
+    double recordSeconds = secondsSince(start);
+    size_t onDisk = replayPoseCount(path, hash);
+
+    GhostPlayer ghost;
+    ghost.start(path, hash);
+    size_t frames = 0, mismatches = 0;
+    double poseSeconds = 0.0;
+    ReplayPose p;
+    for (size_t frame = 0;; frame++) {
+        float tick = frame * 0.5f;
+        while (!ghost.ready(tick)) std::this_thread::yield(); // a game would just hold the pose
+        auto before = std::chrono::steady_clock::now();
+        bool shown = ghost.pose(tick, p);
+        poseSeconds += secondsSince(before);
+        if (!shown) break;
+        frames++;
+        if (frame % 2 == 0) {
+            ReplayPose expected = syntheticPose(frame / 2);
+            if (p.x != expected.x || p.y != expected.y || p.heading != expected.heading) mismatches++;
+        }
+    }
+    std::cout << "Recorded " << onDisk << "/" << POSES << (intact ? " poses (intact)" : " poses (writes refused)") << " in " << std::fixed << std::setprecision(1) << recordSeconds * 1e3
+              << " ms; played " << frames << " frames, pose() mean " << std::setprecision(0) << poseSeconds / frames * 1e9 << " ns, "
+              << ghost.underruns() << " underruns\n";
+    std::cout << "Ghost buffer " << ghost.bufferBytes() << " bytes for a " << std::filesystem::file_size(path) / 1024
+              << " KB replay  " << (onDisk == POSES && frames == 2 * POSES - 1 && mismatches == 0 ? "exact" : "MISMATCH") << "\n";
+    ghost.stop();
+    std::filesystem::remove_all(dir);
+}
+
+// -------------------- Artifacts --------------------
+// Export and reload a racing line and an int8 policy; both must come back exactly. The
+// policy goes through a writer, as the game's exports do.
+static void benchArtifacts() {
+    const std::string dir = std::filesystem::temp_directory_path().string();
+    TrackLayout layout = defaultTrackLayout();
+    const std::string linePath = dir + "/" + racingLineFileName(layout.name);
+    const std::string policyPath = dir + "/bench_policy.sra";
+    writeRacingLineArtifact(linePath, trackLayoutHash(layout), layout.initialLine, 1.f);
+
+    std::mt19937 rng(5);
+    PolicyNet net = makePolicyNet({9, 64, 64, 2});
+    randomizePolicy(net, rng);
+    std::vector<float> inputs(256 * 9);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    for (auto& v : inputs) v = unit(rng);
+    QuantizedPolicy quantized = quantizePolicy(net, inputs.data(), 256);
+    {
+        AsyncWriter writer;
+        writePolicyArtifact(policyPath, quantized, 0.f, 0, &writer);
+        writer.drain();
+    }
+
+    const int LOADS = 1000;
+    std::vector<sf::Vector2f> line;
+    bool lineOk = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOADS; i++) lineOk = loadRacingLineFor(layout, dir, line) && lineOk;
+    double lineUs = secondsSince(start) / LOADS * 1e6;
+    lineOk = lineOk && line == layout.initialLine;
+
+    QuantizedPolicy loaded;
+    bool policyOk = true;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < LOADS; i++) {
+        Artifact artifact;
+        policyOk = artifact.open(policyPath) && artifact.quantizedPolicy(loaded) && policyOk;
+    }
+    double policyUs = secondsSince(start) / LOADS * 1e6;
+    std::vector<float> expected(256 * 2), actual(256 * 2);
+    evaluateQuantizedPolicy(quantized, inputs.data(), 256, expected.data());
+    if (policyOk) evaluateQuantizedPolicy(loaded, inputs.data(), 256, actual.data());
+    policyOk = policyOk && expected == actual;
+
+    std::remove(linePath.c_str());
+    std::remove(policyPath.c_str());
+    std::cout << std::left << std::setw(28) << "racing line" << std::fixed << std::setprecision(1) << lineUs
+              << " us per load  " << (lineOk ? "identical" : "MISMATCH") << "\n"
+              << std::setw(28) << "int8 policy (9-64-64-2)" << policyUs << " us per load  "
+              << (policyOk ? "outputs identical" : "MISMATCH") << "\n";
+}
+
+// -------------------- Vehicle Dynamics --------------------
+static void benchVehicles(size_t carCount) {
+    const VehicleParams params;
+    const VehicleTables tables = buildVehicleTables(params);
+
+    // Sanity: a single car at full throttle settles at the analytic top speed
+    VehicleState one;
+    one.resize(1);
+    float full = 1.f, straight = 0.f;
+    int framesTo90 = -1;
+    const float top = vehicleTopSpeed(params);
+    for (int frame = 0; frame < 2000; frame++) {
+        stepVehicles(tables, one, &full, &straight);
+        if (framesTo90 < 0 && one.speed[0] >= 0.9f * top) framesTo90 = frame + 1;
+    }
+
+    VehicleState cars;
+    cars.resize(carCount);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> input(-1.f, 1.f);
+    const int TICKS = 1000;
+    const size_t PATTERNS = 64; // inputs cycle through a few random frames, so generating them isn't timed
+    std::vector<float> throttle(carCount * PATTERNS), steer(carCount * PATTERNS);
+    for (size_t i = 0; i < throttle.size(); i++) {
+        throttle[i] = input(rng);
+        steer[i] = input(rng);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < TICKS; t++) {
+        size_t pattern = (t % PATTERNS) * carCount;
+        stepVehicles(tables, cars, &throttle[pattern], &steer[pattern]);
+    }
+    double elapsed = secondsSince(start);
+
+    float worstNorm = 0.f;
+    for (size_t i = 0; i < carCount; i++) {
+        worstNorm = std::max(worstNorm, std::fabs(std::sqrt(cars.dirX[i] * cars.dirX[i] + cars.dirY[i] * cars.dirY[i]) - 1.f));
+    }
+    std::cout << std::left << std::setw(28) << (std::to_string(carCount) + " cars") << std::fixed << std::setprecision(1)
+              << carCount * TICKS / elapsed / 1e6 << " M car-ticks/s  top speed " << std::setprecision(3) << one.speed[0]
+              << " (analytic " << top << ", 90% after " << framesTo90 << " frames)  heading norm error "
+              << std::scientific << std::setprecision(1) << worstNorm << std::defaultfloat << "\n";
+}
+
+// -------------------- Car Level of Detail --------------------
+// Cars packed along a big circuit, extracted for a 1000x800 window at three zooms. Every
+// car must be accounted for exactly once; the naive cost is one 4-vertex sprite and one
+// draw call per car.
+static void benchCarDetail(size_t carCount) {
+    const sf::Vector2u viewport(1000, 800);
+    sf::Texture texture;
+    CarRenderer renderer;
+    const uint16_t skins[2] = {renderer.addSkin(CarSkin{&texture, {40.f, 20.f}, sf::Color::Blue}),
+                               renderer.addSkin(CarSkin{&texture, {40.f, 20.f}, sf::Color::Red})};
+
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    std::vector<CarInstance> cars(carCount);
+    for (size_t i = 0; i < carCount; i++) {
+        const float angle = 2.f * GEO_PI * unit(rng), radius = 5000.f + 150.f * (unit(rng) - 0.5f);
+        cars[i].position = {radius * std::cos(angle), radius * std::sin(angle)};
+        cars[i].heading = angle * 180.f / GEO_PI + 90.f;
+        cars[i].skin = skins[i % 2];
+    }
+
+    for (float zoom : {1.f, 4.f, 16.f}) {
+        // Centred on the circuit's right-hand edge, so the close view has a pack of cars
+        const sf::View view(sf::Vector2f(zoom > 8.f ? 0.f : 5000.f, 0.f), sf::Vector2f(1000.f * zoom, 800.f * zoom));
+        const int REPEATS = 50;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < REPEATS; r++) renderer.extract(cars, view, viewport);
+        double elapsed = secondsSince(start) / REPEATS;
+
+        const CarRenderer::Stats& st = renderer.stats();
+        const bool complete = st.sprites + st.quads + st.points + st.merged + st.culled == carCount;
+        std::cout << std::left << std::setw(28) << ("zoom " + std::to_string(static_cast<int>(zoom)) + "x") << std::right
+                  << st.sprites << " sprites, " << st.quads << " quads, " << st.points << " points, " << st.merged
+                  << " merged, " << st.culled << " culled  " << st.vertices << " vertices (naive "
+                  << 4 * (carCount - st.culled) << ")  " << st.drawCalls << " draw calls  extract " << std::fixed
+                  << std::setprecision(0) << elapsed * 1e6 << " us  " << (complete ? "all cars accounted for" : "MISMATCH")
+                  << std::defaultfloat << "\n";
+    }
+}
+
+// -------------------- Lap Time Estimate --------------------
+// Stepped reference for estimateLapTime: one car on stepVehicles, steering for a point
+// a little ahead on the line and driving the estimated speed profile
+static float steppedLapTime(const std::vector<sf::Vector2f>& waypoints, const VehicleTables& tables,
+                            const std::vector<float>& profile) {
+    RacingLine line;
+    line.build(waypoints);
+    std::vector<float> arc(waypoints.size(), 0.f);
+    for (size_t i = 1; i < waypoints.size(); i++) arc[i] = line.arcLengthAt(i);
+    auto pointAt = [&](float s, float* speed) {
+        size_t seg = std::upper_bound(arc.begin(), arc.end(), s) - arc.begin();
+        seg = std::clamp<size_t>(seg, 1, arc.size() - 1) - 1;
+        float t = std::clamp((s - arc[seg]) / std::max(arc[seg + 1] - arc[seg], 1e-3f), 0.f, 1.f);
+        if (speed) *speed = profile[seg] + t * (profile[seg + 1] - profile[seg]);
+        return waypoints[seg] + t * (waypoints[seg + 1] - waypoints[seg]);
+    };
+
+    VehicleState car;
+    car.resize(1);
+    sf::Vector2f first = waypoints[1] - waypoints[0];
+    car.place(0, waypoints[0].x, waypoints[0].y, std::atan2(first.y, first.x) * 180.f / GEO_PI);
+    float progress = 0.f;
+    int frames = 0;
+    while (progress < line.length() - 1.f && frames < 60 * 300) {
+        const sf::Vector2f position(car.x[0], car.y[0]);
+        progress = std::max(progress, line.closest(position, progress - 20.f, progress + 100.f).arcLength);
+
+        float targetSpeed = 0.f;
+        pointAt(progress + 2.f * car.speed[0] + 4.f, &targetSpeed); // a frame or two ahead, so it pulls away from rest
+        sf::Vector2f toTarget = pointAt(progress + 40.f + 8.f * car.speed[0], nullptr) - position;
+        float cross = car.dirX[0] * toTarget.y - car.dirY[0] * toTarget.x;
+        float dot = car.dirX[0] * toTarget.x + car.dirY[0] * toTarget.y;
+        float throttle = std::clamp(10.f * (targetSpeed - car.speed[0]), -1.f, 1.f);
+        float steer = std::clamp(std::atan2(cross, dot) / 0.2f, -1.f, 1.f);
+        stepVehicles(tables, car, &throttle, &steer);
+        frames++;
+    }
+    return frames / 60.f;
+}
+
+// Rank correlation: 1 means both orders agree exactly
+static float spearman(const std::vector<float>& a, const std::vector<float>& b) {
+    auto ranks = [](const std::vector<float>& v) {
+        std::vector<size_t> order(v.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t x, size_t y) { return v[x] < v[y]; });
+        std::vector<float> r(v.size());
+        for (size_t i = 0; i < order.size(); i++) r[order[i]] = static_cast<float>(i);
+        return r;
+    };
+    std::vector<float> ra = ranks(a), rb = ranks(b);
+    const float n = static_cast<float>(a.size());
+    float d2 = 0.f;
+    for (size_t i = 0; i < ra.size(); i++) d2 += (ra[i] - rb[i]) * (ra[i] - rb[i]);
+    return 1.f - 6.f * d2 / (n * (n * n - 1.f));
+}
+
+// The estimate against the stepped vehicle, for each built-in line and for mutated
+// copies of it (ranking is what matters to an optimizer), and its cost vs simulateRun
+static void benchLapEstimate(const TrackLayout& layout) {
+    const VehicleParams params;
+    const VehicleTables tables = buildVehicleTables(params);
+    const float aiSpeed = 3.f;
+    Track track;
+    track.build(layout);
+    const std::vector<OrientedBox> boxes = borderBoxes(track.borders());
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> mutation(-20.f, 20.f);
+    const size_t LINES = 32;
+    std::vector<std::vector<sf::Vector2f>> lines(LINES, layout.initialLine);
+    for (size_t l = 1; l < LINES; l++) {
+        for (auto& wp : lines[l]) wp += sf::Vector2f(mutation(rng), mutation(rng));
+    }
+
+    std::vector<float> estimated(LINES), stepped(LINES), profile;
+    float worstError = 0.f;
+    for (size_t l = 0; l < LINES; l++) {
+        estimated[l] = estimateLapTime(lines[l], params, aiSpeed, &profile);
+        stepped[l] = steppedLapTime(lines[l], tables, profile);
+        worstError = std::max(worstError, std::fabs(estimated[l] - stepped[l]) / stepped[l]);
+    }
+
+    const int REPEATS = 200;
+    volatile float sink = 0.f;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < REPEATS; r++) sink = sink + estimateLapTime(lines[r % LINES], params, aiSpeed);
+    double estimateUs = secondsSince(start) / REPEATS * 1e6;
+    start = std::chrono::steady_clock::now();
+    for (size_t l = 0; l < LINES; l++) sink = sink + simulateRun(lines[l], boxes, aiSpeed);
+    double simulateUs = secondsSince(start) / LINES * 1e6;
+
+    std::cout << std::left << std::setw(28) << (layout.name + " (" + std::to_string(layout.initialLine.size()) + " pts)")
+              << std::fixed << std::setprecision(2) << estimated[0] << " s est vs " << stepped[0] << " s stepped, worst "
+              << std::setprecision(1) << 100.f * worstError << "%, rank corr " << std::setprecision(2)
+              << spearman(estimated, stepped) << "  " << std::setprecision(1) << estimateUs << " us vs simulateRun "
+              << simulateUs << " us\n";
+}
+
+// -------------------- Car vs Border Collisions --------------------
+// The same cars driven three times with the same inputs, testing borders by full scan
+// (what isWithinBorders used to do), through the grid every tick, and through the
+// per-car cache. Only the collision tests are timed; the runs must end identically.
+static void benchCollisions(const TrackLayout& layout, size_t carCount) {
+    Track track;
+    track.build(layout);
+    const std::vector<OrientedBox> boxes = borderBoxes(track.borders());
+    BorderGrid grid;
+    grid.build(boxes);
+    const VehicleTables tables = buildVehicleTables(VehicleParams());
+    const std::vector<sf::Vector2f>& centre = layout.centreline;
+    const int TICKS = 300;
+
+    auto carBox = [](const VehicleState& cars, size_t i) {
+        const sf::Transform transform(cars.dirX[i], -cars.dirY[i], cars.x[i], cars.dirY[i], cars.dirX[i], cars.y[i], 0.f, 0.f, 1.f);
+        return orientedBox(transform, sf::FloatRect(-20.f, -10.f, 40.f, 20.f));
+    };
+
+    struct Result {
+        double seconds = 0.0;
+        size_t hits = 0;
+        double checksum = 0.0;
+        size_t refreshes = 0;
+    };
+    auto drive = [&](int method) {
+        Result result;
+        VehicleState cars;
+        cars.resize(carCount);
+        CollisionCache cache;
+        cache.resize(carCount);
+        std::mt19937 rng(9);
+        std::uniform_real_distribution<float> unit(0.f, 1.f), drift(-0.2f, 0.2f);
+        for (size_t i = 0; i < carCount; i++) {
+            size_t seg = i % (centre.size() - 1);
+            sf::Vector2f d = centre[seg + 1] - centre[seg];
+            sf::Vector2f p = centre[seg] + unit(rng) * d;
+            cars.place(i, p.x, p.y, std::atan2(d.y, d.x) * 180.f / GEO_PI);
+        }
+        std::vector<float> throttle(carCount, 0.7f), steer(carCount, 0.f);
+
+        for (int t = 0; t < TICKS; t++) {
+            for (auto& s : steer) s = std::clamp(s + drift(rng), -1.f, 1.f);
+            stepVehicles(tables, cars, throttle.data(), steer.data());
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < carCount; i++) {
+                const OrientedBox box = carBox(cars, i);
+                bool hit = false;
+                if (method == 0) {
+                    for (const auto& border : boxes) hit = hit || boxesOverlap(box, border);
+                } else if (method == 1) {
+                    hit = grid.overlapsAny(box);
+                } else {
+                    hit = cache.overlapsAny(i, box, grid);
+                }
+                if (hit) {
+                    cars.speed[i] = 0.f;
+                    cars.x[i] -= 5.f * cars.dirX[i];
+                    cars.y[i] -= 5.f * cars.dirY[i];
+                    result.hits++;
+                }
+            }
+            result.seconds += secondsSince(start);
+        }
+        for (size_t i = 0; i < carCount; i++) result.checksum += cars.x[i] + cars.y[i];
+        result.refreshes = cache.refreshes();
+        return result;
+    };
+
+    Result scan = drive(0), gridded = drive(1), cached = drive(2);
+    const double carTicks = static_cast<double>(carCount) * TICKS;
+    bool identical = scan.hits == gridded.hits && scan.hits == cached.hits && scan.checksum == gridded.checksum &&
+                     scan.checksum == cached.checksum;
+    std::cout << std::left << std::setw(28) << (layout.name + " (" + std::to_string(boxes.size()) + " borders)") << std::fixed
+              << std::setprecision(1) << scan.seconds / carTicks * 1e9 << " ns scan, " << gridded.seconds / carTicks * 1e9
+              << " ns grid, " << cached.seconds / carTicks * 1e9 << " ns cached per car-tick (" << std::setprecision(2)
+              << gridded.seconds / cached.seconds << "x vs grid, " << std::setprecision(1) << 100.0 * cached.refreshes / carTicks
+              << "% refreshed)  " << (identical ? "identical" : "MISMATCH") << "\n";
+}
+
+// -------------------- Main --------------------
+int main() {
+    std::cout << "== Ray-cast sensors (8 rays/car, 4096 cars) ==\n";
+    benchSensors("default rectangle", defaultTrackWalls(), 64.f, {150, 150}, {950, 450});
+    benchSensors("wavy circuit (4k walls)", wavyTrackWalls(2000, 3000.f, 60.f), 64.f, {-3500, -3500}, {3500, 3500});
+
+    std::cout << "\n== Policy inference (9-64-64-2 MLP, 4096 samples) ==\n";
+    benchPolicy();
+
+    std::cout << "\n== Closest point on racing line ==\n";
+    benchRacingLine(1000);
+    benchRacingLine(20000);
+
+    std::cout << "\n== Built-in track build (baked tables vs runtime builder) ==\n";
+    for (const auto& layout : builtinTrackLayouts()) benchBakedTrack(layout);
+
+    std::cout << "\n== Vehicle dynamics (table-driven SoA kernel) ==\n";
+    benchVehicles(4096);
+
+    std::cout << "\n== Car level of detail (100k cars on a circuit of radius 5000, 1000x800 window) ==\n";
+    benchCarDetail(100000);
+
+    std::cout << "\n== Car vs border collisions (4096 cars, 300 ticks) ==\n";
+    benchCollisions(defaultTrackLayout(), 4096);
+    benchCollisions(wavyTrackLayout(1500, 3000.f), 4096);
+
+    std::cout << "\n== Lap time estimate (QSS velocity profile vs stepped vehicle, 32 lines) ==\n";
+    for (const auto& layout : builtinTrackLayouts()) benchLapEstimate(layout);
+
+    std::cout << "\n== Coarse-to-fine waypoint optimization (100 pre-races, mean of 8 runs) ==\n";
+    for (const auto& layout : builtinTrackLayouts()) benchProgressive(layout, GENERATIONS, 8);
+
+    std::cout << "\n== Window handover (a car stopped on a wall starts the next window afresh) ==\n";
+    benchWindowHandOver();
+
+    std::cout << "\n== Racing styles (MAP-Elites, inner distance x collisions, 41 batches of 32) ==\n";
+    {
+        WorkPool pool;
+        for (const auto& layout : builtinTrackLayouts()) benchStyles(layout, pool);
+    }
+
+    std::cout << "\n== Idle-time scaling (self-resubmitting pre-races, pool parked and woken) ==\n";
+    benchIdleScaling(defaultTrackLayout());
+    benchIdleScaling(wavyTrackLayout(1500, 3000.f));
+
+    std::cout << "\n== Novelty archive (10-D trajectory descriptors, k-d forest vs linear scan) ==\n";
+    for (size_t entries : {10000, 100000, 300000}) benchNoveltyArchive(entries, 15);
+
+    std::cout << "\n== Novelty search vs objective (trainTracks, 8 candidates per generation) ==\n";
+    {
+        WorkPool pool;
+        for (const auto& layout : builtinTrackLayouts()) benchNoveltyTraining(layout, pool);
+    }
+
+    std::cout << "\n== Controller evaluation (64 genomes, 9-32-32-2 MLP, 1500 steps) ==\n";
+    benchControllers();
+
+    std::cout << "\n== Remote evaluation (loopback coordinator, one worker lost mid-run) ==\n";
+    benchRemote();
+    benchRemoteStall();
+
+    std::cout << "\n== Telemetry (loopback UDP, pushed records vs decoded datagrams) ==\n";
+    benchTelemetry();
+
+    std::cout << "\n== Async writer (2 streams x 32 MB of 256-byte records, batched syncs) ==\n";
+    benchAsyncWriter(true);
+    benchAsyncWriter(false);
+
+    std::cout << "\n== Replay recording and ghost playback (100k poses) ==\n";
+    benchReplay();
+
+    std::cout << "\n== Artifacts (export, mmap load, compare) ==\n";
+    benchArtifacts();
+
+    std::cout << "\n== Memory (peaks are over the whole run) ==\n";
+    reportMemory(std::cout);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/******************************************************
+ *  Car Renderer - batched car drawing with per-car level of detail
+ ******************************************************/
+
+#include "car_renderer.hpp"
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const unsigned QUAD_CELL_PIXELS = 2;
+
+static sf::Color modulate(sf::Color a, sf::Color b) {
+    return sf::Color(static_cast<sf::Uint8>(a.r * b.r / 255), static_cast<sf::Uint8>(a.g * b.g / 255),
+                     static_cast<sf::Uint8>(a.b * b.b / 255), static_cast<sf::Uint8>(a.a * b.a / 255));
+}
+
+sf::Color averageColour(const sf::Image& image) {
+    const sf::Uint8* pixels = image.getPixelsPtr();
+    const size_t count = size_t(image.getSize().x) * image.getSize().y;
+    uint64_t sum[3] = {0, 0, 0}, weight = 0;
+    for (size_t i = 0; pixels && i < count; i++) {
+        const sf::Uint8* p = pixels + i * 4;
+        for (int c = 0; c < 3; c++) sum[c] += uint64_t(p[c]) * p[3];
+        weight += p[3];
+    }
+    if (weight == 0) return sf::Color::White;
+    return sf::Color(static_cast<sf::Uint8>(sum[0] / weight), static_cast<sf::Uint8>(sum[1] / weight),
+                     static_cast<sf::Uint8>(sum[2] / weight));
+}
+
+// -------------------- Occupancy --------------------
+void CarRenderer::Occupancy::reset(sf::Vector2u viewport, unsigned cell) {
+    unsigned newColumns = (viewport.x + cell - 1) / cell, newRows = (viewport.y + cell - 1) / cell;
+    if (newColumns != columns || newRows != rows || cell != cellPixels) {
+        columns = newColumns;
+        rows = newRows;
+        cellPixels = cell;
+        bits.assign((size_t(columns) * rows + 63) / 64, 0);
+    } else {
+        for (uint32_t index : marked) bits[index / 64] = 0;
+    }
+    marked.clear();
+}
+
+bool CarRenderer::Occupancy::mark(float px, float py) {
+    if (px < 0.f || py < 0.f) return true; // centre off screen, the car may still show at the edge
+    const unsigned cx = static_cast<unsigned>(px) / cellPixels, cy = static_cast<unsigned>(py) / cellPixels;
+    if (cx >= columns || cy >= rows) return true;
+    const uint32_t index = cy * columns + cx;
+    const uint64_t bit = uint64_t(1) << (index % 64);
+    if (bits[index / 64] & bit) return false;
+    bits[index / 64] |= bit;
+    marked.push_back(index);
+    return true;
+}
+
+// -------------------- Extraction --------------------
+uint16_t CarRenderer::addSkin(const CarSkin& skin) {
+    skins.push_back(skin);
+    spriteVertices.emplace_back();
+    return static_cast<uint16_t>(skins.size() - 1);
+}
+
+CarDetail CarRenderer::detailFor(float pixelLength) {
+    if (pixelLength >= CAR_SPRITE_MIN_PIXELS) return CarDetail::Sprite;
+    if (pixelLength >= CAR_QUAD_MIN_PIXELS) return CarDetail::Quad;
+    return CarDetail::Point;
+}
+
+void CarRenderer::appendQuad(std::vector<sf::Vertex>& out, const CarInstance& car, const CarSkin& skin, sf::Color colour,
+                             bool textured) const {
+    const float angle = car.heading * GEO_PI / 180.f;
+    const float c = std::cos(angle), s = std::sin(angle);
+    const float hx = skin.size.x / 2.f, hy = skin.size.y / 2.f;
+    sf::Vector2f textureSize;
+    if (textured && skin.texture) {
+        textureSize = sf::Vector2f(static_cast<float>(skin.texture->getSize().x), static_cast<float>(skin.texture->getSize().y));
+    }
+    // Corners clockwise from the back left, matching a sprite with its origin at the centre
+    static const float CORNERS[4][2] = {{-1.f, -1.f}, {1.f, -1.f}, {1.f, 1.f}, {-1.f, 1.f}};
+    for (const auto& corner : CORNERS) {
+        const float lx = corner[0] * hx, ly = corner[1] * hy;
+        sf::Vector2f position(car.position.x + c * lx - s * ly, car.position.y + s * lx + c * ly);
+        sf::Vector2f texCoords((corner[0] + 1.f) / 2.f * textureSize.x, (corner[1] + 1.f) / 2.f * textureSize.y);
+        out.emplace_back(position, colour, texCoords);
+    }
+}
+
+void CarRenderer::extract(const std::vector<CarInstance>& cars, const sf::View& view, sf::Vector2u viewport) {
+    for (auto& batch : spriteVertices) batch.clear();
+    quadVertices.clear();
+    pointVertices.clear();
+    pointCells.reset(viewport, 1);
+    quadCells.reset(viewport, QUAD_CELL_PIXELS);
+    spriteCells.reset(viewport, static_cast<unsigned>(CAR_SPRITE_MIN_PIXELS));
+    counts = Stats();
+
+    const sf::Vector2f size = view.getSize();
+    const sf::Vector2f topLeft = view.getCenter() - size / 2.f;
+    const float scaleX = viewport.x / size.x, scaleY = viewport.y / size.y;
+    const float pixelsPerUnit = std::min(scaleX, scaleY);
+
+    for (const CarInstance& car : cars) {
+        const CarSkin& skin = skins[car.skin];
+        // Cull on the car's bounding circle
+        const float reach = std::max(skin.size.x, skin.size.y) / 2.f;
+        const float sx = car.position.x - topLeft.x, sy = car.position.y - topLeft.y;
+        if (sx < -reach || sy < -reach || sx > size.x + reach || sy > size.y + reach) {
+            counts.culled++;
+            continue;
+        }
+
+        const sf::Color flat = modulate(skin.flat, car.tint);
+        switch (detailFor(skin.size.x * pixelsPerUnit)) {
+        case CarDetail::Sprite:
+            if (car.merge && !spriteCells.mark(sx * scaleX, sy * scaleY)) {
+                counts.merged++;
+                break;
+            }
+            appendQuad(spriteVertices[car.skin], car, skin, car.tint, true);
+            counts.sprites++;
+            break;
+        case CarDetail::Quad:
+            if (car.merge && !quadCells.mark(sx * scaleX, sy * scaleY)) {
+                counts.merged++;
+                break;
+            }
+            appendQuad(quadVertices, car, skin, flat, false);
+            counts.quads++;
+            break;
+        case CarDetail::Point:
+            if (car.merge && !pointCells.mark(sx * scaleX, sy * scaleY)) {
+                counts.merged++;
+                break;
+            }
+            pointVertices.emplace_back(car.position, flat);
+            counts.points++;
+            break;
+        }
+    }
+    counts.vertices = quadVertices.size() + pointVertices.size();
+    counts.drawCalls = !quadVertices.empty() + !pointVertices.empty();
+    for (const auto& batch : spriteVertices) {
+        counts.vertices += batch.size();
+        counts.drawCalls += !batch.empty();
+    }
+}
+
+// -------------------- Drawing --------------------
+void CarRenderer::draw(sf::RenderTarget& target) const {
+    if (!pointVertices.empty()) target.draw(pointVertices.data(), pointVertices.size(), sf::Points);
+    if (!quadVertices.empty()) target.draw(quadVertices.data(), quadVertices.size(), sf::Quads);
+    for (size_t skin = 0; skin < skins.size(); skin++) {
+        if (spriteVertices[skin].empty()) continue;
+        sf::RenderStates states(skins[skin].texture);
+        target.draw(spriteVertices[skin].data(), spriteVertices[skin].size(), sf::Quads, states);
+    }
+}
@@ -0,0 +1,91 @@
+/******************************************************
+ *  Car Renderer - batched car drawing with per-car level of detail
+ ******************************************************/
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// How much of a car is drawn, chosen from its length on screen
+enum class CarDetail : uint8_t {
+    Sprite, // textured quad
+    Quad,   // flat quad in the skin's colour
+    Point,  // one pixel in the skin's colour
+};
+
+static const float CAR_SPRITE_MIN_PIXELS = 12.f; // shorter than this on screen: flat quad
+static const float CAR_QUAD_MIN_PIXELS = 3.f;    // shorter than this on screen: point
+
+// A texture, the car's size in world units and the colour it fades to when small
+struct CarSkin {
+    const sf::Texture* texture = nullptr;
+    sf::Vector2f size{40.f, 20.f};
+    sf::Color flat = sf::Color::White;
+};
+
+// Mean colour of the opaque pixels, for CarSkin::flat
+sf::Color averageColour(const sf::Image& image);
+
+// One car to draw this frame
+struct CarInstance {
+    sf::Vector2f position;
+    float heading = 0.f;                // degrees, as sf::Transformable
+    uint16_t skin = 0;                  // index returned by addSkin()
+    sf::Color tint = sf::Color::White;  // multiplies the texture or the flat colour
+    bool merge = true;                  // false: always drawn and claims no cell, e.g. a see-through ghost
+};
+
+// Cars are drawn by extraction: every frame, extract() culls the cars against the
+// view, picks a CarDetail per car from its projected length and appends it to one of
+// the vertex batches. draw() then issues one call for the points, one for the flat
+// quads and one per skin for the sprites, whatever the number of cars.
+//
+// Cars are merged on screen: a point goes to its pixel, a flat quad to a 2x2-pixel cell
+// and a sprite to a cell CAR_SPRITE_MIN_PIXELS across, and a car landing where one of
+// its tier is already drawn adds no vertices. A sprite is at least a cell long, so the
+// one drawn covers most of those it hides. Cars with merge = false stay out of this, so
+// they can't hide the others. Apart from those, and cars centred off screen, vertex
+// count is bounded by the screen area, not the car count.
+// Points go under quads, and quads under sprites. Sprites are drawn a skin at a time in
+// the order the skins were added, and cars keep their order within a skin and a tier.
+class CarRenderer {
+public:
+    struct Stats {
+        size_t sprites = 0, quads = 0, points = 0;
+        size_t culled = 0; // outside the view
+        size_t merged = 0; // landed on a pixel or cell already drawn
+        size_t vertices = 0;
+        size_t drawCalls = 0;
+    };
+
+    uint16_t addSkin(const CarSkin& skin);
+
+    // The view must not be rotated; viewport is the target's size in pixels
+    void extract(const std::vector<CarInstance>& cars, const sf::View& view, sf::Vector2u viewport);
+    void draw(sf::RenderTarget& target) const;
+
+    const Stats& stats() const { return counts; }
+    static CarDetail detailFor(float pixelLength);
+
+private:
+    // Which cells of a screen-sized grid already hold something this frame
+    struct Occupancy {
+        unsigned columns = 0, rows = 0, cellPixels = 1;
+        std::vector<uint64_t> bits;
+        std::vector<uint32_t> marked; // to clear just those next frame
+
+        void reset(sf::Vector2u viewport, unsigned cell);
+        bool mark(float px, float py); // false if its cell is already marked
+    };
+
+    void appendQuad(std::vector<sf::Vertex>& out, const CarInstance& car, const CarSkin& skin, sf::Color colour,
+                    bool textured) const;
+
+    std::vector<CarSkin> skins;
+    std::vector<std::vector<sf::Vertex>> spriteVertices; // per skin
+    std::vector<sf::Vertex> quadVertices, pointVertices;
+    Occupancy pointCells, quadCells, spriteCells;
+    Stats counts;
+};
@@ -0,0 +1,52 @@
+/******************************************************
+ *  Collision Cache - per-car reuse of nearby borders between ticks
+ ******************************************************/
+
+#include "collision_cache.hpp"
+
+#include <algorithm>
+
+// Strict overlap, matching sf::Rect::intersects
+static bool overlaps(const sf::FloatRect& a, const sf::FloatRect& b) {
+    return std::max(a.left, b.left) < std::min(a.left + a.width, b.left + b.width) &&
+           std::max(a.top, b.top) < std::min(a.top + a.height, b.top + b.height);
+}
+
+static bool contains(const sf::FloatRect& outer, const sf::FloatRect& inner) {
+    return inner.left >= outer.left && inner.top >= outer.top && inner.left + inner.width <= outer.left + outer.width &&
+           inner.top + inner.height <= outer.top + outer.height;
+}
+
+static sf::FloatRect join(const sf::FloatRect& a, const sf::FloatRect& b) {
+    float left = std::min(a.left, b.left), top = std::min(a.top, b.top);
+    float right = std::max(a.left + a.width, b.left + b.width), bottom = std::max(a.top + a.height, b.top + b.height);
+    return sf::FloatRect(left, top, right - left, bottom - top);
+}
+
+void CollisionCache::invalidate() {
+    for (auto& entry : entries) entry.valid = false;
+}
+
+void CollisionCache::refresh(Entry& entry, const sf::FloatRect& box, const BorderGrid& grid) {
+    entry.region = sf::FloatRect(box.left - margin, box.top - margin, box.width + 2 * margin, box.height + 2 * margin);
+    grid.query(entry.region, scratch);
+    entry.borders.clear();
+    for (uint32_t index : scratch) {
+        if (overlaps(grid.border(index).bounds, entry.region)) entry.borders.push_back(grid.border(index));
+    }
+    entry.valid = true;
+    refreshCount++;
+}
+
+bool CollisionCache::overlapsAny(size_t car, const OrientedBox& box, const BorderGrid& grid) {
+    Entry& entry = entries[car];
+    queryCount++;
+    // A car that jumped (reset, teleport) sweeps a huge box and refreshes
+    if (!entry.valid || !contains(entry.region, join(entry.lastBox, box.bounds))) refresh(entry, box.bounds, grid);
+    entry.lastBox = box.bounds;
+
+    for (const auto& border : entry.borders) {
+        if (boxesOverlap(box, border)) return true;
+    }
+    return false;
+}
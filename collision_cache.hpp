@@ -0,0 +1,47 @@
+/******************************************************
+ *  Collision Cache - per-car reuse of nearby borders between ticks
+ ******************************************************/
+#pragma once
+
+#include "optimizer.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+// A car moves a few pixels per tick, so the borders near it this tick are the ones
+// near it next tick. Each car keeps a copy of the borders around a padded region;
+// its tests use only those until the car's swept box (the bounds it was last tested
+// with, joined with these) leaves the region. Only then does it go back to the
+// grid for a fresh set. Answers are exactly those of BorderGrid::overlapsAny.
+class CollisionCache {
+public:
+    explicit CollisionCache(float margin = 8.f) : margin(margin) {}
+
+    void resize(size_t cars) { entries.resize(cars); }
+
+    // Drops every car's borders; call whenever the borders change or a car is placed
+    void invalidate();
+
+    // Does car's box overlap any border in grid?
+    bool overlapsAny(size_t car, const OrientedBox& box, const BorderGrid& grid);
+
+    size_t queries() const { return queryCount; }
+    size_t refreshes() const { return refreshCount; } // queries that went to the grid
+
+private:
+    struct Entry {
+        sf::FloatRect region;   // holds every border that touches this
+        sf::FloatRect lastBox;  // bounds of the box last tested
+        TaggedVector<OrientedBox, MemoryTag::CollisionIndex> borders;
+        bool valid = false;
+    };
+
+    void refresh(Entry& entry, const sf::FloatRect& box, const BorderGrid& grid);
+
+    std::vector<Entry> entries;
+    std::vector<uint32_t> scratch;
+    float margin;               // padding around the box on each refresh
+    size_t queryCount = 0;
+    size_t refreshCount = 0;
+};
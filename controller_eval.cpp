@@ -0,0 +1,202 @@
+/******************************************************
+ *  Controller Evaluation - scoring policy genomes on several tracks at once
+ ******************************************************/
+
+#include "controller_eval.hpp"
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+static const float FINISH_SLACK = 20.0f;    // within this of the end of the line counts as finished
+static const float PROGRESS_BACK = 100.0f;  // progress search window, as in the HUD
+static const float PROGRESS_AHEAD = 200.0f;
+static const size_t GENOMES_PER_TASK = 4;
+
+EvalTrack makeEvalTrack(const Track& track) {
+    EvalTrack eval;
+    const auto& centreline = track.centreline();
+    eval.name = track.layout().name;
+    eval.walls = track.walls();
+    eval.line.build(centreline);
+    eval.start = centreline.front();
+    if (centreline.size() > 1) {
+        sf::Vector2f dir = centreline[1] - centreline[0];
+        eval.startHeadingDeg = std::atan2(dir.y, dir.x) * 180.f / GEO_PI;
+    }
+    return eval;
+}
+
+float aggregateFitness(const float* scores, size_t count, FitnessAggregate how) {
+    if (count == 0) return 0.f;
+    std::vector<float> sorted(scores, scores + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto meanOf = [&](size_t n) {
+        float sum = 0.f;
+        for (size_t i = 0; i < n; i++) sum += sorted[i];
+        return sum / n;
+    };
+    switch (how) {
+        case FitnessAggregate::Mean:   return meanOf(count);
+        case FitnessAggregate::Worst:  return sorted.front();
+        case FitnessAggregate::Median: return 0.5f * (sorted[(count - 1) / 2] + sorted[count / 2]);
+        default:                       return meanOf((count + 1) / 2);
+    }
+}
+
+// Is any wall within radius of (px, py)? Leaving the grid counts as a crash.
+static bool touchesWall(const WallGrid& grid, float px, float py, float radius) {
+    int cx = grid.cellX(px), cy = grid.cellY(py);
+    if (cx < 0 || cy < 0 || cx >= grid.columns() || cy >= grid.rows()) return true;
+
+    const int reach = static_cast<int>(std::ceil(radius / grid.cellSize()));
+    const float r2 = radius * radius;
+    for (int y = std::max(0, cy - reach); y <= std::min(grid.rows() - 1, cy + reach); y++) {
+        for (int x = std::max(0, cx - reach); x <= std::min(grid.columns() - 1, cx + reach); x++) {
+            const WallGrid::Cell& c = grid.cell(x, y);
+            for (size_t i = 0; i < c.ids.size(); i++) {
+                float len2 = c.ex[i] * c.ex[i] + c.ey[i] * c.ey[i];
+                float rx = px - c.ax[i], ry = py - c.ay[i];
+                float t = len2 > 0.f ? std::clamp((rx * c.ex[i] + ry * c.ey[i]) / len2, 0.f, 1.f) : 0.f;
+                float dx = rx - c.ex[i] * t, dy = ry - c.ey[i] * t;
+                if (dx * dx + dy * dy < r2) return true;
+            }
+        }
+    }
+    return false;
+}
+
+// -------------------- Batched Rollouts --------------------
+// Lane = genome * K + track. Car state is SoA over lanes.
+static void evaluateRange(const PolicyNet* genomes, size_t genomeCount, const std::vector<EvalTrack>& tracks,
+                          const ControllerEvalSettings& settings, float* scores) {
+    const size_t K = tracks.size();
+    const size_t lanes = genomeCount * K;
+    const size_t rays = settings.rig.anglesDeg.size();
+    const size_t in = rays + 1;
+
+    std::vector<float> x(lanes), y(lanes), heading(lanes), speed(lanes, 0.f), progress(lanes, 0.f);
+    std::vector<uint8_t> running(lanes, 1);
+    for (size_t lane = 0; lane < lanes; lane++) {
+        const EvalTrack& track = tracks[lane % K];
+        x[lane] = track.start.x;
+        y[lane] = track.start.y;
+        heading[lane] = track.startHeadingDeg;
+        scores[lane] = 0.f;
+    }
+
+    // Scratch: one track's running cars for the ray cast, one genome's running tracks for the network
+    std::vector<float> castX, castY, castHeading, castHits, castScratch;
+    std::vector<size_t> castLanes, netLanes;
+    std::vector<float> sensed(lanes * rays);
+    std::vector<float> netIn(in * K), netOut(2 * K), netScratch;
+    size_t stillRunning = lanes;
+
+    for (int step = 0; step < settings.maxSteps && stillRunning > 0; step++) {
+        for (size_t k = 0; k < K; k++) {
+            castX.clear();
+            castY.clear();
+            castHeading.clear();
+            castLanes.clear();
+            for (size_t lane = k; lane < lanes; lane += K) {
+                if (!running[lane]) continue;
+                castX.push_back(x[lane]);
+                castY.push_back(y[lane]);
+                castHeading.push_back(heading[lane]);
+                castLanes.push_back(lane);
+            }
+            if (castLanes.empty()) continue;
+            castHits.resize(castLanes.size() * rays);
+            castSensorRays(tracks[k].walls, settings.rig, castX.data(), castY.data(), castHeading.data(),
+                           castLanes.size(), castHits.data(), castScratch);
+            for (size_t i = 0; i < castLanes.size(); i++) {
+                std::copy(&castHits[i * rays], &castHits[i * rays] + rays, &sensed[castLanes[i] * rays]);
+            }
+        }
+
+        for (size_t g = 0; g < genomeCount; g++) {
+            netLanes.clear();
+            for (size_t lane = g * K; lane < (g + 1) * K; lane++) {
+                if (running[lane]) netLanes.push_back(lane);
+            }
+            const size_t batch = netLanes.size();
+            if (batch == 0) continue;
+
+            for (size_t b = 0; b < batch; b++) {
+                const size_t lane = netLanes[b];
+                for (size_t r = 0; r < rays; r++) netIn[r * batch + b] = sensed[lane * rays + r] / settings.rig.maxRange;
+                netIn[rays * batch + b] = speed[lane] / settings.maxSpeed;
+            }
+            evaluatePolicyInterleaved(genomes[g], netIn.data(), batch, netOut.data(), netScratch);
+
+            for (size_t b = 0; b < batch; b++) {
+                const size_t lane = netLanes[b];
+                const EvalTrack& track = tracks[lane % K];
+                const float steer = netOut[b], throttle = netOut[batch + b];
+
+                heading[lane] += steer * settings.turnRateDeg;
+                speed[lane] = throttle >= 0.f ? throttle * settings.maxSpeed : throttle * settings.maxReverse;
+                const float angle = heading[lane] * GEO_PI / 180.f;
+                x[lane] += std::cos(angle) * speed[lane];
+                y[lane] += std::sin(angle) * speed[lane];
+
+                const float length = track.line.length();
+                if (touchesWall(track.walls, x[lane], y[lane], settings.carRadius)) {
+                    running[lane] = 0;
+                    stillRunning--;
+                    scores[lane] = length > 0.f ? progress[lane] / length : 0.f;
+                    continue;
+                }
+
+                LinePoint at = track.line.closest(sf::Vector2f(x[lane], y[lane]), progress[lane] - PROGRESS_BACK,
+                                                  progress[lane] + PROGRESS_AHEAD);
+                if (at.distance < std::numeric_limits<float>::max()) progress[lane] = at.arcLength;
+                if (progress[lane] >= length - FINISH_SLACK) {
+                    running[lane] = 0;
+                    stillRunning--;
+                    scores[lane] = 1.f + static_cast<float>(settings.maxSteps - step - 1) / settings.maxSteps;
+                }
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < lanes; lane++) {
+        if (!running[lane]) continue;
+        float length = tracks[lane % K].line.length();
+        scores[lane] = length > 0.f ? progress[lane] / length : 0.f;
+    }
+}
+
+void evaluateControllers(const std::vector<PolicyNet>& genomes, const std::vector<EvalTrack>& tracks,
+                         const ControllerEvalSettings& settings, float* fitness, float* trackScores) {
+    std::vector<float> local;
+    if (!trackScores) {
+        local.resize(genomes.size() * tracks.size());
+        trackScores = local.data();
+    }
+    evaluateRange(genomes.data(), genomes.size(), tracks, settings, trackScores);
+    for (size_t g = 0; g < genomes.size(); g++) {
+        fitness[g] = aggregateFitness(trackScores + g * tracks.size(), tracks.size(), settings.aggregate);
+    }
+}
+
+void evaluateControllers(WorkPool& pool, int group, const std::vector<PolicyNet>& genomes, const std::vector<EvalTrack>& tracks,
+                         const ControllerEvalSettings& settings, float* fitness, float* trackScores) {
+    std::vector<float> local;
+    if (!trackScores) {
+        local.resize(genomes.size() * tracks.size());
+        trackScores = local.data();
+    }
+    const size_t tasks = (genomes.size() + GENOMES_PER_TASK - 1) / GENOMES_PER_TASK;
+    pool.parallelFor(group, tasks, [&](size_t task) {
+        size_t first = task * GENOMES_PER_TASK;
+        size_t count = std::min(GENOMES_PER_TASK, genomes.size() - first);
+        evaluateRange(genomes.data() + first, count, tracks, settings, trackScores + first * tracks.size());
+    });
+    for (size_t g = 0; g < genomes.size(); g++) {
+        fitness[g] = aggregateFitness(trackScores + g * tracks.size(), tracks.size(), settings.aggregate);
+    }
+}
@@ -0,0 +1,63 @@
+/******************************************************
+ *  Controller Evaluation - scoring policy genomes on several tracks at once
+ ******************************************************/
+#pragma once
+
+#include "policy.hpp"
+#include "racing_line.hpp"
+#include "sensors.hpp"
+#include "track.hpp"
+#include "wall_grid.hpp"
+#include "work_pool.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A track reduced to what a rollout needs; copies, so it outlives the Track
+struct EvalTrack {
+    std::string name;
+    WallGrid walls;
+    RacingLine line;      // centreline, for progress
+    sf::Vector2f start;
+    float startHeadingDeg = 0.f;
+};
+
+EvalTrack makeEvalTrack(const Track& track);
+
+// How per-track scores become one fitness. Averages reward a controller that is
+// brilliant on one track and useless on another; the robust choices don't.
+enum class FitnessAggregate {
+    Mean,
+    Median,
+    Worst,
+    WorstHalfMean, // mean of the lower half of the scores (default)
+};
+
+struct ControllerEvalSettings {
+    SensorRig rig = makeSensorFan(8, 180.f, 400.f); // networks take rays + 1 inputs (speed last)
+    int maxSteps = 1500;       // frames per rollout
+    float maxSpeed = 5.0f;     // throttle +1, same units as the player car
+    float maxReverse = 3.0f;   // throttle -1
+    float turnRateDeg = 3.0f;  // steer +-1
+    float carRadius = 10.0f;   // touching a wall within this distance ends the rollout
+    FitnessAggregate aggregate = FitnessAggregate::WorstHalfMean;
+};
+
+// Per-track score, higher is better: the fraction of the lap covered before crashing
+// or running out of time, plus 1 + (unused steps / maxSteps) for finishing
+float aggregateFitness(const float* scores, size_t count, FitnessAggregate how);
+
+// Rolls every genome out on every track in one batch and writes fitness[genome].
+// trackScores, if given, gets the per-track scores at [genome * tracks.size() + track].
+//
+// All of a genome's tracks advance in lockstep: one network pass per step covers all
+// of them, with the tracks interleaved as the kernel's SIMD lanes, and rays are cast
+// per track for every genome still running on it. Lanes that crash or finish drop out
+// of both, so K tracks cost about the same as K single-track calls.
+void evaluateControllers(const std::vector<PolicyNet>& genomes, const std::vector<EvalTrack>& tracks,
+                         const ControllerEvalSettings& settings, float* fitness, float* trackScores = nullptr);
+
+// Same, with genomes split into tasks on a pool group
+void evaluateControllers(WorkPool& pool, int group, const std::vector<PolicyNet>& genomes, const std::vector<EvalTrack>& tracks,
+                         const ControllerEvalSettings& settings, float* fitness, float* trackScores = nullptr);
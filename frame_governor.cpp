@@ -0,0 +1,98 @@
+/******************************************************
+ *  Frame Governor - keeps frames inside budget by shedding optional work
+ ******************************************************/
+
+#include "frame_governor.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+static const float SMOOTHING = 0.2f;       // weight of the newest sample in the running averages
+static const float RISK_FRACTION = 0.85f;  // frame work above this share of the budget raises the level
+static const float CALM_FRACTION = 0.5f;   // ...and below this share, for CALM_FRAMES, lowers it
+static const int CALM_FRAMES = 120;
+static const int LEVEL_UP_FRAMES = 10;     // let a new level take effect before raising it again
+
+const char* optionalWorkName(OptionalWork work) {
+    switch (work) {
+        case OptionalWork::HudText:   return "HUD text";
+        case OptionalWork::Telemetry: return "telemetry";
+        case OptionalWork::Scenery:   return "scenery streaming";
+        default:                      return "?";
+    }
+}
+
+FrameGovernor::FrameGovernor(float budget) : budgetMs(budget), frameStart(Clock::now()) {}
+
+float FrameGovernor::millisSince(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+void FrameGovernor::beginFrame() {
+    frameStart = Clock::now();
+}
+
+bool FrameGovernor::allow(OptionalWork work) {
+    WorkStats& s = stats[static_cast<int>(work)];
+    if (s.skippedInARow < MAX_SKIPPED_FRAMES) {
+        // Decimation: at level L this work runs once every 2^L frames
+        if (s.skippedInARow + 1 < (1 << loadLevel)) {
+            s.decimated++;
+            s.skippedInARow++;
+            return false;
+        }
+        // This frame would overrun with it: leave it for the next one
+        if (millisSince(frameStart) + s.costMs > budgetMs) {
+            s.deferred++;
+            s.skippedInARow++;
+            return false;
+        }
+    }
+    s.ran++;
+    s.skippedInARow = 0;
+    s.started = Clock::now();
+    return true;
+}
+
+void FrameGovernor::done(OptionalWork work) {
+    WorkStats& s = stats[static_cast<int>(work)];
+    float cost = millisSince(s.started);
+    s.costMs = s.ran == 1 ? cost : s.costMs + SMOOTHING * (cost - s.costMs);
+}
+
+void FrameGovernor::endFrame() {
+    float work = millisSince(frameStart);
+    frameMs = frames == 0 ? work : frameMs + SMOOTHING * (work - frameMs);
+    frames++;
+    framesAtLevel++;
+
+    int newLevel = loadLevel;
+    if (frameMs > RISK_FRACTION * budgetMs) {
+        calmFrames = 0;
+        if (loadLevel < MAX_LEVEL && framesAtLevel >= LEVEL_UP_FRAMES) newLevel = loadLevel + 1;
+    } else if (frameMs < CALM_FRACTION * budgetMs) {
+        if (++calmFrames >= CALM_FRAMES && loadLevel > 0) newLevel = loadLevel - 1;
+    } else {
+        calmFrames = 0;
+    }
+
+    if (newLevel != loadLevel) {
+        std::cout << "Frame governor: level " << loadLevel << " -> " << newLevel << " (frame work "
+                  << std::fixed << std::setprecision(1) << frameMs << " ms of " << budgetMs << " ms budget)\n"
+                  << std::defaultfloat;
+        loadLevel = newLevel;
+        framesAtLevel = 0;
+        calmFrames = 0;
+        levelChanges++;
+    }
+}
+
+void FrameGovernor::report(std::ostream& out) const {
+    out << "Frame governor: " << frames << " frames, " << levelChanges << " level changes, final level " << loadLevel << "\n";
+    for (int i = 0; i < static_cast<int>(OptionalWork::Count); i++) {
+        const WorkStats& s = stats[i];
+        out << "  " << std::left << std::setw(18) << optionalWorkName(static_cast<OptionalWork>(i)) << std::right
+            << " ran " << s.ran << ", decimated " << s.decimated << ", deferred " << s.deferred
+            << " (" << std::fixed << std::setprecision(2) << s.costMs << " ms each)\n" << std::defaultfloat;
+    }
+}
@@ -0,0 +1,63 @@
+/******************************************************
+ *  Frame Governor - keeps frames inside budget by shedding optional work
+ ******************************************************/
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Work the game can skip for a frame without changing the race. Each one leaves its
+// last result in place (HUD text, resident tiles), so skipping it only makes it stale.
+// Simulation, input and drawing the world are never asked about.
+enum class OptionalWork { HudText, Telemetry, Scenery, Count };
+
+const char* optionalWorkName(OptionalWork work);
+
+// Measures how long each frame's own work takes (excluding the wait in display()) and
+// how long each piece of optional work costs, then:
+//  - raises a load level while frames run close to budget, and decimates optional work
+//    to every 2nd / 4th / 8th frame at levels 1 / 2 / 3;
+//  - defers a piece outright when the frame so far plus its expected cost would
+//    overrun the budget.
+// Nothing is starved: a piece that has been skipped MAX_SKIPPED_FRAMES times in a row
+// runs regardless. Level changes are logged, and report() sums up the decisions.
+class FrameGovernor {
+public:
+    static const int MAX_LEVEL = 3;
+    static const int MAX_SKIPPED_FRAMES = 30;
+
+    explicit FrameGovernor(float budgetMs = 1000.f / 60.f);
+
+    void beginFrame();
+    // Ask before doing optional work. If it returns true, do the work and call done().
+    bool allow(OptionalWork work);
+    void done(OptionalWork work);
+    // Call once the frame's work is finished, before presenting it
+    void endFrame();
+
+    int level() const { return loadLevel; }
+    float averageFrameMs() const { return frameMs; }
+    void report(std::ostream& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static float millisSince(Clock::time_point start);
+
+    struct WorkStats {
+        float costMs = 0.f;         // smoothed cost when it runs
+        int skippedInARow = 0;
+        Clock::time_point started;
+        uint64_t ran = 0, decimated = 0, deferred = 0;
+    };
+
+    float budgetMs;
+    float frameMs = 0.f; // smoothed frame work time
+    int loadLevel = 0;
+    int framesAtLevel = 0;
+    int calmFrames = 0;  // consecutive frames well under budget, for stepping back down
+    uint64_t frames = 0;
+    uint64_t levelChanges = 0;
+    Clock::time_point frameStart;
+    WorkStats stats[static_cast<int>(OptionalWork::Count)];
+};
@@ -0,0 +1,145 @@
+/******************************************************
+ *  Geometry - constexpr building blocks shared by runtime and baked track data
+ ******************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// sf::Vector2f is not a literal type in SFML 2.5, so constant-evaluated code uses this
+struct GeoPoint {
+    float x = 0.f;
+    float y = 0.f;
+};
+
+constexpr GeoPoint operator+(GeoPoint a, GeoPoint b) { return GeoPoint{a.x + b.x, a.y + b.y}; }
+constexpr GeoPoint operator-(GeoPoint a, GeoPoint b) { return GeoPoint{a.x - b.x, a.y - b.y}; }
+constexpr GeoPoint operator*(GeoPoint a, float s) { return GeoPoint{a.x * s, a.y * s}; }
+constexpr GeoPoint operator/(GeoPoint a, float s) { return GeoPoint{a.x / s, a.y / s}; }
+constexpr bool operator==(GeoPoint a, GeoPoint b) { return a.x == b.x && a.y == b.y; }
+
+// Every degree/radian conversion in the game and its tools uses this one
+static constexpr float GEO_PI = 3.14159265f;
+
+// -------------------- Constant-Evaluable Math --------------------
+// Newton's method from above in double. Rounding the converged double to float gives
+// the correctly rounded float square root, i.e. the same result as std::sqrt(float).
+constexpr double geoSqrtDouble(double x) {
+    if (!(x > 0.0)) return 0.0;
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 2048; i++) {
+        double next = 0.5 * (r + x / r);
+        if (next >= r) break;
+        r = next;
+    }
+    return r;
+}
+
+constexpr float geoSqrt(float x) { return static_cast<float>(geoSqrtDouble(x)); }
+
+// atan for |z| <= 1: two half-angle reductions, then the Taylor series
+constexpr double geoAtanUnit(double z) {
+    for (int i = 0; i < 2; i++) z = z / (1.0 + geoSqrtDouble(1.0 + z * z));
+    double term = z, sum = 0.0, z2 = z * z;
+    for (int k = 0; k < 40; k++) {
+        sum += term / (2 * k + 1);
+        term *= -z2;
+    }
+    return 4.0 * sum;
+}
+
+constexpr double geoAtan2Double(double y, double x) {
+    const double pi = 3.14159265358979323846;
+    if (x == 0.0) return y > 0.0 ? pi / 2 : (y < 0.0 ? -pi / 2 : 0.0);
+    double ay = y < 0.0 ? -y : y, ax = x < 0.0 ? -x : x;
+    double a = ay <= ax ? geoAtanUnit(ay / ax) : pi / 2 - geoAtanUnit(ax / ay);
+    if (x < 0.0) a = pi - a;
+    return y < 0.0 ? -a : a;
+}
+
+constexpr float geoAtan2(float y, float x) { return static_cast<float>(geoAtan2Double(y, x)); }
+
+constexpr int geoFloor(float x) {
+    int i = static_cast<int>(x);
+    return static_cast<float>(i) > x ? i - 1 : i;
+}
+
+constexpr int geoCeil(float x) {
+    int i = static_cast<int>(x);
+    return static_cast<float>(i) < x ? i + 1 : i;
+}
+
+// Square roots for the templates below in constant expressions; runtime callers pass a
+// std::sqrt functor instead (track.cpp), which gives the same correctly rounded result
+struct ConstexprSqrt {
+    constexpr float operator()(float x) const { return geoSqrt(x); }
+};
+
+// -------------------- Shared Track Geometry --------------------
+// Track (runtime) and baked_tracks.hpp (compile time) both go through these, so the
+// two can only differ by the square roots, which are correctly rounded either way.
+
+template <typename Sqrt>
+constexpr GeoPoint geoUnitNormal(GeoPoint dir, Sqrt sqrtOf) {
+    float length = sqrtOf(dir.x * dir.x + dir.y * dir.y);
+    if (length == 0.f) return GeoPoint{0.f, 0.f};
+    return GeoPoint{-dir.y / length, dir.x / length};
+}
+
+// Mitered wall corners at centreline point `at`, offset by `wallOffset` along the bisector
+// of the normals of the segments either side (missing neighbours reuse the other normal)
+template <typename Sqrt>
+constexpr void geoMiterCorner(GeoPoint prev, GeoPoint at, GeoPoint next, bool hasPrev, bool hasNext,
+                              float wallOffset, float maxMiterScale, Sqrt sqrtOf, GeoPoint& outer, GeoPoint& inner) {
+    GeoPoint n0, n1;
+    if (hasPrev) n0 = geoUnitNormal(at - prev, sqrtOf);
+    if (hasNext) n1 = geoUnitNormal(next - at, sqrtOf);
+
+    if (n0 == GeoPoint{}) n0 = n1;
+    if (n1 == GeoPoint{}) n1 = n0;
+
+    GeoPoint miter = n0 + n1;
+    float length = sqrtOf(miter.x * miter.x + miter.y * miter.y);
+    miter = length > 1e-4f ? miter / length : n0;
+
+    float cosHalf = miter.x * n0.x + miter.y * n0.y;
+    float scale = wallOffset / std::max(cosHalf, 1.f / maxMiterScale);
+    outer = at + miter * scale;
+    inner = at - miter * scale;
+}
+
+template <typename Sqrt>
+constexpr float geoPointSegmentDistance(GeoPoint p, GeoPoint a, GeoPoint b, Sqrt sqrtOf) {
+    GeoPoint ab = b - a;
+    float len2 = ab.x * ab.x + ab.y * ab.y;
+    float t = len2 > 0.f ? std::clamp(((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / len2, 0.f, 1.f) : 0.f;
+    GeoPoint d = p - (a + ab * t);
+    return sqrtOf(d.x * d.x + d.y * d.y);
+}
+
+// Does segment a->b touch the box [minX,maxX] x [minY,maxY]? (slab test)
+constexpr bool geoSegmentTouchesBox(GeoPoint a, GeoPoint b, float minX, float minY, float maxX, float maxY) {
+    float t0 = 0.f, t1 = 1.f;
+    const float d[2] = {b.x - a.x, b.y - a.y};
+    const float p[2] = {a.x, a.y};
+    const float lo[2] = {minX, minY};
+    const float hi[2] = {maxX, maxY};
+
+    for (int axis = 0; axis < 2; axis++) {
+        if (d[axis] < 1e-6f && d[axis] > -1e-6f) {
+            if (p[axis] < lo[axis] || p[axis] > hi[axis]) return false;
+            continue;
+        }
+        float ta = (lo[axis] - p[axis]) / d[axis];
+        float tb = (hi[axis] - p[axis]) / d[axis];
+        if (ta > tb) {
+            float swap = ta;
+            ta = tb;
+            tb = swap;
+        }
+        t0 = std::max(t0, ta);
+        t1 = std::min(t1, tb);
+        if (t0 > t1) return false;
+    }
+    return true;
+}
@@ -3,6 +3,22 @@
  ******************************************************/
 
 #include <SFML/Graphics.hpp>
+#include "car_renderer.hpp"
+#include "collision_cache.hpp"
+#include "frame_governor.hpp"
+#include "geometry.hpp"
+#include "memory_budget.hpp"
+#include "optimizer.hpp"
+#include "racing_line.hpp"
+#include "remote_eval.hpp"
+#include "replay.hpp"
+#include "scenery.hpp"
+#include "style_archive.hpp"
+#include "telemetry.hpp"
+#include "track.hpp"
+#include "track_manager.hpp"
+#include "trainer.hpp"
+#include "vehicle.hpp"
 #include <cmath>
 #include <vector>
 #include <iostream>
@@ -11,21 +27,34 @@
 #include <chrono>
 #include <random>
 #include <iomanip>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <thread>
 
 // -------------------- Constants --------------------
-static const float PI = 3.14159265f;
 static const float CHECKPOINT_RADIUS = 30.0f;
-static const size_t POPULATION_SIZE = 20;
-static const int GENERATIONS = 100; // Number of pre-races for optimization
-static const float MUTATION_RATE = 0.05f; // Mutation rate for waypoint adjustments
+static const float EDIT_PICK_RADIUS = 15.0f; // Track editor: how close a click must be to grab a point
+static const float EDIT_HANDLE_RADIUS = 5.0f;
+static const size_t NO_POINT = static_cast<size_t>(-1);
+static const size_t PLAYER_CAR = 0; // index into the vehicle state
+static const size_t AI_CAR = 1;
+static const float AI_WAYPOINT_RADIUS = 25.0f; // >= the car's low-speed turning radius, so it can't orbit a waypoint
+static const unsigned REPLAY_TICK_EVERY = 2;    // sim ticks per recorded pose (60 Hz sim -> 30 poses/s)
+static const uint8_t GHOST_ALPHA = 110;
+static const float CAMERA_ZOOM_STEP = 1.25f;   // per mouse wheel notch
+static const float CAMERA_MIN_ZOOM = 0.5f;     // view size relative to the window
+static const float CAMERA_MAX_ZOOM = 16.0f;
+static const float AI_FULL_LOCK_ANGLE = 0.2f;  // heading error (radians) that gets full steering
 
 // -------------------- Utility Functions --------------------
 float degToRad(float deg) {
-    return deg * PI / 180.0f;
+    return deg * GEO_PI / 180.0f;
 }
 
 float radToDeg(float rad) {
-    return rad * 180.0f / PI;
+    return rad * 180.0f / GEO_PI;
 }
 
 float distance(const sf::Vector2f& a, const sf::Vector2f& b) {
@@ -34,20 +63,19 @@ float distance(const sf::Vector2f& a, const sf::Vector2f& b) {
     return std::sqrt(dx * dx + dy * dy);
 }
 
-// Checks if the car is within track borders and handles collision
-bool isWithinBorders(sf::Sprite& car, float& speed, const std::vector<sf::RectangleShape>& borders) {
-    for (const auto& border : borders) {
-        if (car.getGlobalBounds().intersects(border.getGlobalBounds())) {
-            // Stop the car
-            speed = 0.0f;
+// Checks if the car is within track borders and handles collision. carIndex picks
+// the car's entry in the collision cache, which usually answers without the grid.
+bool isWithinBorders(sf::Sprite& car, float& speed, CollisionCache& cache, size_t carIndex, const BorderGrid& borders) {
+    if (cache.overlapsAny(carIndex, orientedBox(car.getTransform(), car.getLocalBounds()), borders)) {
+        // Stop the car
+        speed = 0.0f;
 
-            // Move car slightly back in the opposite direction
-            float currentAngle = car.getRotation();
-            sf::Vector2f direction(-std::cos(degToRad(currentAngle)), -std::sin(degToRad(currentAngle)));
-            car.move(direction * 5.f);
+        // Move car slightly back in the opposite direction
+        float currentAngle = car.getRotation();
+        sf::Vector2f direction(-std::cos(degToRad(currentAngle)), -std::sin(degToRad(currentAngle)));
+        car.move(direction * 5.f);
 
-            return false;
-        }
+        return false;
     }
     return true;
 }
@@ -57,115 +85,294 @@ bool hasHitCheckpoint(const sf::Vector2f& carPosition, const sf::Vector2f& check
     return distance(carPosition, checkpointPosition) < CHECKPOINT_RADIUS;
 }
 
-// -------------------- AI Optimization Structures --------------------
-struct AIIndividual {
-    std::vector<sf::Vector2f> waypoints;
-    float fitness; // Lower is better
-};
+// Centres the camera on the target, kept inside the world where the world is bigger than the view
+sf::Vector2f cameraCentre(sf::Vector2f target, sf::Vector2f viewSize, const sf::FloatRect& world, sf::Vector2f fallback) {
+    sf::Vector2f centre = fallback;
+    if (world.width > viewSize.x) {
+        centre.x = std::min(std::max(target.x, world.left + viewSize.x / 2), world.left + world.width - viewSize.x / 2);
+    }
+    if (world.height > viewSize.y) {
+        centre.y = std::min(std::max(target.y, world.top + viewSize.y / 2), world.top + world.height - viewSize.y / 2);
+    }
+    return centre;
+}
 
-// -------------------- Simulation Function --------------------
-// Simulates the AI car running through the waypoints and calculates fitness
-float simulateRun(const std::vector<sf::Vector2f>& waypoints, const std::vector<sf::RectangleShape>& borders, float aiSpeed) {
-    // Create a temporary AI car sprite for simulation
-    sf::Texture dummyTexture;
-    dummyTexture.create(40, 20); // Create a dummy texture
-    sf::Sprite tempAiCar(dummyTexture);
-    tempAiCar.setOrigin(dummyTexture.getSize().x / 2.0f, dummyTexture.getSize().y / 2.0f);
-    tempAiCar.setPosition(waypoints[0]);
-    tempAiCar.setRotation(0.f);
-
-    size_t currentWaypoint = 0;
-    float totalTime = 0.0f;
-    float speed = aiSpeed;
-    const float TIME_STEP = 1.0f / 60.0f; // Simulate at 60 FPS
-    int collisionCount = 0;
-
-    while (currentWaypoint < waypoints.size()) {
-        sf::Vector2f target = waypoints[currentWaypoint];
-        sf::Vector2f direction = target - tempAiCar.getPosition();
-        float distanceToTarget = distance(tempAiCar.getPosition(), target);
-
-        if (distanceToTarget < 10.0f) {
-            currentWaypoint++;
-            continue;
-        }
+// -------------------- Command-Line Options --------------------
+struct GameOptions {
+    std::string telemetryHost;          // empty = telemetry off
+    unsigned short telemetryPort = 0;
+    float telemetryRate = 30.0f;        // datagram bursts per second
+    std::vector<TrackLayout> tracks;    // race rotation, empty = every built-in track
+    std::string sceneryPath;            // tile pyramid drawn under the track, empty = none
+    std::vector<TrainingJob> trainJobs; // headless multi-track training, empty = play
+    std::vector<TrackLayout> styleTracks; // headless racing-style search, empty = play
+    std::string linesDir = "lines";     // exported racing lines, shared by --train and the game
+    std::string replayDir = "replays";  // recorded laps and the ghost's best lap
+    unsigned trainThreads = 0;          // 0 = one per hardware thread
+    bool noveltySearch = false;         // --train breeds from the most novel lines, not the best
+    int coordinatorPort = -1;           // headless controller training over TCP, -1 = off
+    size_t localWorkers = 0;            // workers started in this process, for testing on one machine
+    std::string workerHost;             // empty = not a worker
+    unsigned short workerPort = 0;
+};
 
-        // Normalize direction
-        if (distanceToTarget != 0) {
-            direction /= distanceToTarget;
-        }
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --telemetry HOST:PORT   stream car telemetry as UDP datagrams\n"
+              << "  --telemetry-hz N        telemetry send rate (default 30)\n"
+              << "  --tracks NAME,NAME      track rotation (default: all built-in tracks)\n"
+              << "  --scenery FILE          stream a background tile pyramid (see mktiles)\n"
+              << "  --train NAME[:W],...    train racing lines for these tracks and exit;\n"
+              << "                          W is a fair-share weight (default 1)\n"
+              << "  --novelty               with --train, use novelty search on trajectories\n"
+              << "  --styles NAME,NAME      search a roster of distinct racing styles for these\n"
+              << "                          tracks, export them to --lines and exit\n"
+              << "  --lines DIR             racing line artifacts to load and export (default lines)\n"
+              << "  --replays DIR           recorded laps; the best one races as a ghost (default replays)\n"
+              << "  --threads N             training threads, also used while the game is idle (default: all cores)\n"
+              << "  --memory-budget TAG=MB,...  warn when a subsystem's memory goes over MB\n"
+              << "                          (tags: track-geometry, collision-index, population,\n"
+              << "                          line-cache, replay-buffers, write-buffers, textures)\n"
+              << "  --coordinator PORT      evolve a driving controller on --tracks, scored by\n"
+              << "                          remote workers, export it to --lines and exit\n"
+              << "  --local-workers N       with --coordinator, also run N workers in this process\n"
+              << "  --worker HOST:PORT      score controllers for a coordinator until it finishes\n";
+}
 
-        // Move AI car
-        tempAiCar.move(direction * speed);
+static bool findTrackOrComplain(const std::string& name, TrackLayout& layout) {
+    if (findBuiltinTrack(name, layout)) return true;
+    std::cerr << "Unknown track '" << name << "'. Built-in tracks:";
+    for (const auto& builtin : builtinTrackLayouts()) std::cerr << " " << builtin.name;
+    std::cerr << "\n";
+    return false;
+}
 
-        // Set rotation towards movement direction
-        float targetAngle = radToDeg(std::atan2(direction.y, direction.x));
-        tempAiCar.setRotation(targetAngle);
+// Returns false if the program should exit (bad option or --help)
+static bool parseOptions(int argc, char* argv[], GameOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
 
-        // Check for collision
-        if (!isWithinBorders(tempAiCar, speed, borders)) {
-            collisionCount++;
-            totalTime += TIME_STEP * 2; // Penalize time for collision
+        if (arg == "--telemetry" && hasValue) {
+            if (!parseHostPort(argv[++i], options.telemetryHost, options.telemetryPort)) {
+                std::cerr << "Bad --telemetry target, expected HOST:PORT\n";
+                return false;
+            }
+        } else if (arg == "--telemetry-hz" && hasValue) {
+            options.telemetryRate = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--tracks" && hasValue) {
+            std::stringstream names(argv[++i]);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                TrackLayout layout;
+                if (!findTrackOrComplain(name, layout)) return false;
+                options.tracks.push_back(layout);
+            }
+        } else if (arg == "--scenery" && hasValue) {
+            options.sceneryPath = argv[++i];
+        } else if (arg == "--train" && hasValue) {
+            std::stringstream names(argv[++i]);
+            std::string entry;
+            while (std::getline(names, entry, ',')) {
+                TrainingJob job;
+                size_t colon = entry.find(':');
+                if (colon != std::string::npos) {
+                    job.weight = std::strtof(entry.c_str() + colon + 1, nullptr);
+                    entry.erase(colon);
+                }
+                if (!findTrackOrComplain(entry, job.layout)) return false;
+                options.trainJobs.push_back(job);
+            }
+        } else if (arg == "--styles" && hasValue) {
+            std::stringstream names(argv[++i]);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                TrackLayout layout;
+                if (!findTrackOrComplain(name, layout)) return false;
+                options.styleTracks.push_back(layout);
+            }
+        } else if (arg == "--novelty") {
+            options.noveltySearch = true;
+        } else if (arg == "--lines" && hasValue) {
+            options.linesDir = argv[++i];
+        } else if (arg == "--replays" && hasValue) {
+            options.replayDir = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            options.trainThreads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--memory-budget" && hasValue) {
+            if (!parseMemoryBudgets(argv[++i])) return false;
+        } else if (arg == "--coordinator" && hasValue) {
+            options.coordinatorPort = static_cast<int>(std::strtoul(argv[++i], nullptr, 10));
+            if (options.coordinatorPort > 65535) {
+                std::cerr << "Bad --coordinator port\n";
+                return false;
+            }
+        } else if (arg == "--local-workers" && hasValue) {
+            options.localWorkers = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--worker" && hasValue) {
+            if (!parseHostPort(argv[++i], options.workerHost, options.workerPort)) {
+                std::cerr << "Bad --worker target, expected HOST:PORT\n";
+                return false;
+            }
+        } else {
+            printUsage(argv[0]);
+            return false;
         }
-
-        totalTime += TIME_STEP;
     }
-
-    // Fitness calculation: lower time and fewer collisions are better
-    float fitness = totalTime + (collisionCount * 5.0f); // Each collision adds a penalty
-    return fitness;
+    if (options.tracks.empty()) {
+        options.tracks = builtinTrackLayouts();
+    }
+    return true;
 }
 
-// -------------------- Optimization Function --------------------
-// Optimizes the AI waypoints by running pre-races and adjusting waypoints based on performance
-std::vector<sf::Vector2f> optimizeWaypoints(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders, float aiSpeed, int generations) {
+// -------------------- Remote Controller Training --------------------
+static const size_t CONTROLLER_POPULATION = 64;
+static const size_t CONTROLLER_ELITES = 8;
+static const int CONTROLLER_GENERATIONS = 40;
+static const float CONTROLLER_MUTATION = 0.1f;
+
+// Elitist evolution of a driving controller with every generation scored by the
+// coordinator's workers. The best controller goes to linesDir/controller.sra.
+static bool trainControllerRemotely(const GameOptions& options) {
+    RemoteCoordinator coordinator;
+    if (!coordinator.listen(static_cast<unsigned short>(options.coordinatorPort))) return false;
+
+    ControllerEvalSettings eval;
+    const std::vector<size_t> layers = {eval.rig.anglesDeg.size() + 1, 32, 32, 2};
+    coordinator.setup(layers, options.tracks, eval);
+
+    // In-process workers share the machine, so each gets an even slice of the threads
+    std::vector<std::thread> localWorkers;
+    unsigned cores = options.trainThreads ? options.trainThreads : std::max(1u, std::thread::hardware_concurrency());
+    unsigned perWorker = options.localWorkers ? std::max(1u, cores / static_cast<unsigned>(options.localWorkers)) : 1;
+    unsigned short port = coordinator.port();
+    for (size_t w = 0; w < options.localWorkers; w++) {
+        localWorkers.emplace_back([port, perWorker] {
+            WorkPool pool(perWorker);
+            runRemoteWorker("127.0.0.1", port, pool);
+        });
+    }
+    if (!options.localWorkers) std::cout << "Waiting for workers (--worker HOST:" << port << ")\n";
+
     std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<float> mutationDist(-20.0f, 20.0f); // Mutation range
+    std::normal_distribution<float> noise(0.f, CONTROLLER_MUTATION);
+    AsyncWriter artifactWriter;
+    std::vector<PolicyNet> population(CONTROLLER_POPULATION, makePolicyNet(layers));
+    for (auto& genome : population) randomizePolicy(genome, rng);
+    MemoryCharge populationMemory(MemoryTag::Population); // this generation and the next
+    populationMemory.set(2 * population.size() * vectorBytes(population[0].params));
+    std::vector<float> fitness(population.size());
+    std::vector<size_t> order(population.size());
+    bool ok = true;
+
+    for (int generation = 0; generation < CONTROLLER_GENERATIONS; generation++) {
+        if (!coordinator.evaluate(population, fitness.data())) {
+            ok = false;
+            break;
+        }
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return fitness[a] > fitness[b]; });
+        std::cout << "Generation " << generation + 1 << ": best " << std::fixed << std::setprecision(3)
+                  << fitness[order[0]] << " (" << coordinator.workerCount() << " workers)\n";
+
+        // Elites survive unchanged (fitness is deterministic), the rest are mutated elites
+        std::vector<PolicyNet> next;
+        for (size_t e = 0; e < CONTROLLER_ELITES; e++) next.push_back(population[order[e]]);
+        while (next.size() < population.size()) {
+            PolicyNet child = next[rng() % CONTROLLER_ELITES];
+            for (float& param : child.params) param += noise(rng);
+            next.push_back(std::move(child));
+        }
+        if (generation + 1 == CONTROLLER_GENERATIONS) {
+            std::error_code error;
+            std::filesystem::create_directories(options.linesDir, error);
+            std::string path = options.linesDir + "/controller.sra";
+            ok = writePolicyArtifact(path, population[order[0]], fitness[order[0]], 0, &artifactWriter);
+            if (ok) std::cout << "Exported best controller to " << path << "\n";
+        }
+        population.swap(next);
+    }
 
-    float bestFitness = simulateRun(waypoints, borders, aiSpeed);
-    std::vector<sf::Vector2f> bestWaypoints = waypoints;
+    coordinator.shutdown();
+    for (auto& worker : localWorkers) worker.join();
+    if (coordinator.reissuedBatches()) {
+        std::cout << coordinator.reissuedBatches() << " batches were reissued after losing workers\n";
+    }
+    reportMemory(std::cout);
+    return ok;
+}
 
-    std::cout << "Starting AI Optimization...\n";
+// -------------------- Main Function --------------------
+int main(int argc, char* argv[]) {
+    GameOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return -1;
+    }
 
-    for (int gen = 1; gen <= generations; ++gen) {
-        // Create mutated waypoints
-        std::vector<sf::Vector2f> mutatedWaypoints = waypoints;
-        for (auto& wp : mutatedWaypoints) {
-            wp.x += mutationDist(rng);
-            wp.y += mutationDist(rng);
-        }
+    if (!options.workerHost.empty()) {
+        WorkPool pool(options.trainThreads);
+        return runRemoteWorker(options.workerHost, options.workerPort, pool) ? 0 : -1;
+    }
+    if (options.coordinatorPort >= 0) {
+        return trainControllerRemotely(options) ? 0 : -1;
+    }
 
-        // Simulate the mutated waypoints
-        float fitness = simulateRun(mutatedWaypoints, borders, aiSpeed);
-        std::cout << "Pre-Race " << gen << " - Fitness: " << fitness << " (Best: " << bestFitness << ")\n";
+    // Headless opponent roster: one MAP-Elites search per track, all on one pool
+    if (!options.styleTracks.empty()) {
+        WorkPool pool(options.trainThreads);
+        AsyncWriter artifactWriter;
+        StyleSettings settings;
+        std::error_code error;
+        std::filesystem::create_directories(options.linesDir, error);
+        for (const auto& layout : options.styleTracks) {
+            StyleArchive archive = searchRacingStyles(layout, pool, settings);
+            std::vector<StyleElite> roster = archive.roster(settings.rosterSize, settings.rosterSlack);
+            if (exportStyleRoster(layout, roster, options.linesDir, &artifactWriter) != roster.size()) return -1;
+            if (roster.empty()) {
+                std::cout << "No racing style for " << layout.name << " finishes a clean lap; none exported\n";
+                continue;
+            }
+            std::cout << "Exported " << roster.size() << " racing styles for " << layout.name << ":\n";
+            for (size_t k = 0; k < roster.size(); k++) {
+                std::cout << "  " << options.linesDir << "/" << racingStyleFileName(layout.name, k) << "  fitness " << roster[k].fitness
+                          << ", " << roster[k].innerDistance << " px from the inner wall, " << roster[k].collisions << " collisions\n";
+            }
+        }
+        reportMemory(std::cout);
+        return 0;
+    }
 
-        // If mutated waypoints are better, keep them
-        if (fitness < bestFitness) {
-            bestFitness = fitness;
-            bestWaypoints = mutatedWaypoints;
-            std::cout << "Improved waypoints in Pre-Race " << gen << "!\n";
-        } else {
-            std::cout << "No improvement in Pre-Race " << gen << ".\n";
+    // Headless season preparation: every track trains on one pool, no window
+    if (!options.trainJobs.empty()) {
+        WorkPool pool(options.trainThreads);
+        AsyncWriter artifactWriter;
+        TrainingSettings settings;
+        settings.outputDir = options.linesDir;
+        settings.writer = &artifactWriter;
+        settings.noveltySearch = options.noveltySearch;
+        std::vector<TrainingResult> results = trainTracks(options.trainJobs, pool, settings);
+        reportMemory(std::cout);
+        for (const auto& result : results) {
+            if (result.path.empty()) return -1;
         }
+        return 0;
     }
 
-    std::cout << "AI Optimization Complete! Best Fitness: " << bestFitness << "\n\n";
-    return bestWaypoints;
-}
+    // Tracks are built and their racing lines loaded (or trained) on a background thread,
+    // so the next one in the rotation is ready the moment a race ends. Whenever the game
+    // sits idle, --threads workers keep improving the lines.
+    // Replays and line exports share one writer, so neither the game loop nor the pool
+    // threads wait on the disk. Replays are a few KB per minute and a line is 8 bytes a
+    // point, so a handful of buffers is plenty.
+    AsyncWriterSettings fileWriterSettings;
+    fileWriterSettings.bufferCount = 8;
+    AsyncWriter fileWriter(fileWriterSettings);
 
-// -------------------- Main Function --------------------
-int main() {
-    // Create a simple rectangular track with rounded corners
-    std::vector<sf::Vector2f> trainingWaypoints = {
-        {200, 400}, {400, 400}, {600, 400}, {800, 400},
-        {900, 400}, {900, 300}, {900, 200}, {800, 200},
-        {600, 200}, {400, 200}, {200, 200}, {200, 300}, {200, 400}
-    };
+    float aiSpeed = 3.0f;
+    TrackManager trackManager(options.tracks, aiSpeed, GENERATIONS, 2, options.linesDir, options.trainThreads, &fileWriter);
 
-    // Define checkpoints for evaluation and visualization
-    std::vector<sf::Vector2f> checkpointPositions = {
-        {500, 400}, {900, 300}, {500, 200}, {200, 300}
-    };
+    // The first track has nothing to hide behind, so wait for its training here
+    std::unique_ptr<TrackBundle> bundle = trackManager.takeNext();
 
     // Load textures
     sf::Texture player1Texture, player2Texture;
@@ -174,34 +381,42 @@ int main() {
         std::cerr << "Error loading car textures! Make sure player1.png & player2.png exist.\n";
         return -1;
     }
+    MemoryCharge carTextureMemory(MemoryTag::Textures);
+    carTextureMemory.set(size_t(4) * (player1Texture.getSize().x * player1Texture.getSize().y +
+                                      player2Texture.getSize().x * player2Texture.getSize().y));
 
     // Create window
     sf::RenderWindow window(sf::VideoMode(1000, 800), "2D Racing - Two Player Mode");
     window.setFramerateLimit(60);
 
+    // Optional background scenery, streamed in tiles around the camera
+    SceneryStreamer scenery;
+    if (!options.sceneryPath.empty() && !scenery.open(options.sceneryPath)) {
+        std::cerr << "Continuing without scenery\n";
+    }
+
     // Player car sprite
     sf::Sprite playerCar(player1Texture);
     playerCar.setScale(40.0f / player1Texture.getSize().x, 20.0f / player1Texture.getSize().y);
     playerCar.setOrigin(player1Texture.getSize().x / 2.0f, player1Texture.getSize().y / 2.0f);
-    playerCar.setPosition(trainingWaypoints[0]);
 
     // AI car sprite
     sf::Sprite aiCar(player2Texture);
     aiCar.setScale(40.0f / player2Texture.getSize().x, 20.0f / player2Texture.getSize().y);
     aiCar.setOrigin(player2Texture.getSize().x / 2.0f, player2Texture.getSize().y / 2.0f);
-    aiCar.setPosition(trainingWaypoints[0]);
-
-    // Define AI waypoints (these should be more detailed than checkpoints)
-    std::vector<sf::Vector2f> aiWaypoints = {
-        {200, 400}, {300, 400}, {400, 400}, {500, 400}, {600, 400}, {700, 400}, {800, 400},
-        {900, 400}, {900, 350}, {900, 300}, {900, 250}, {900, 200}, {800, 200}, {700, 200},
-        {600, 200}, {500, 200}, {400, 200}, {300, 200}, {200, 200}, {200, 250}, {200, 300},
-        {200, 350}, {200, 400}
-    };
+
+    // The race's cars are drawn in one batch; each fades to its texture's mean colour when small
+    CarRenderer carRenderer;
+    const uint16_t playerSkin = carRenderer.addSkin(CarSkin{&player1Texture, {40.0f, 20.0f}, averageColour(player1Texture.copyToImage())});
+    const uint16_t aiSkin = carRenderer.addSkin(CarSkin{&player2Texture, {40.0f, 20.0f}, averageColour(player2Texture.copyToImage())});
+    std::vector<CarInstance> carInstances;
+
+    // Per-race state, reset whenever a new track is swapped in
+    std::vector<sf::Vector2f> checkpointPositions;
+    std::vector<sf::Vector2f> aiWaypoints;
 
     // AI car variables
     size_t aiCurrentWaypoint = 0;
-    float aiSpeed = 3.0f;
 
     // Checkpoint tracking
     size_t playerCurrentCheckpoint = 0;
@@ -209,89 +424,59 @@ int main() {
     size_t aiCurrentCheckpoint = 0;
     size_t aiCheckpointsHit = 0;
 
-    // Prepare track rendering
-    const float TRACK_WIDTH = 80.f;
-    std::vector<sf::ConvexShape> trackSegments;
-    for (size_t i = 0; i < trainingWaypoints.size() - 1; i++) {
-        sf::Vector2f current = trainingWaypoints[i];
-        sf::Vector2f next    = trainingWaypoints[i + 1];
-        sf::Vector2f dir     = next - current;
-        float length         = std::sqrt(dir.x * dir.x + dir.y * dir.y);
-        if (length > 0) {
-            dir /= length;
-            sf::Vector2f normal(-dir.y, dir.x);
-
-            // Make a quad for the track segment
-            sf::ConvexShape seg;
-            seg.setPointCount(4);
-            seg.setPoint(0, current + normal * (TRACK_WIDTH / 2.f));
-            seg.setPoint(1, next    + normal * (TRACK_WIDTH / 2.f));
-            seg.setPoint(2, next    - normal * (TRACK_WIDTH / 2.f));
-            seg.setPoint(3, current - normal * (TRACK_WIDTH / 2.f));
-            seg.setFillColor(sf::Color(80, 80, 80));
-            trackSegments.push_back(seg);
-        }
-    }
-
-    // Build track borders
-    std::vector<sf::RectangleShape> trackBorders;
+    // Both cars run on the vehicle model (acceleration, braking, drag, grip limit)
+    const VehicleTables vehicleTables = buildVehicleTables(VehicleParams());
+    VehicleState cars;
+    cars.resize(2);
+    CollisionCache collisionCache; // nearby borders per car, reused between ticks
+    collisionCache.resize(2);
 
-    // Function to add a border segment
-    auto addBorderSegment = [&](const sf::Vector2f& start, const sf::Vector2f& end) {
-        sf::Vector2f diff = end - start;
-        float length = std::sqrt(diff.x * diff.x + diff.y * diff.y);
-
-        sf::RectangleShape border(sf::Vector2f(length, 5.f));
-        border.setPosition(start);
-        border.setFillColor(sf::Color::Red);
-
-        // Calculate rotation
-        float rotation = std::atan2(diff.y, diff.x) * 180.f / PI;
-        border.setRotation(rotation);
-
-        trackBorders.push_back(border);
-    };
+    // Lap progress along the centreline
+    float playerProgress = 0.0f;
+    float aiProgress = 0.0f;
 
-    // Outer border coordinates (clockwise)
-    std::vector<sf::Vector2f> outerBorder = {
-        {150, 450}, {950, 450}, {950, 150}, {150, 150}, {150, 450}
-    };
+    bool raceOver = false;
+    std::string winner;
 
-    // Inner border coordinates (clockwise)
-    std::vector<sf::Vector2f> innerBorder = {
-        {250, 350}, {850, 350}, {850, 250}, {250, 250}, {250, 350}
+    // Every race is recorded; a lap faster than the best on disk becomes the next ghost
+    ReplayRecorder recorder;
+    GhostPlayer ghost;
+    std::string bestReplayPath, lastReplayPath;
+    size_t bestLapPoses = 0; // 0 = no best lap yet
+    unsigned raceTick = 0;
+
+    auto resetRace = [&]() {
+        const sf::Vector2f startPosition = bundle->track.centreline()[0];
+        checkpointPositions = bundle->track.layout().checkpoints;
+        aiWaypoints = bundle->aiWaypoints;
+
+        playerCar.setPosition(startPosition);
+        playerCar.setRotation(0.0f);
+        aiCar.setPosition(startPosition);
+        aiCar.setRotation(0.0f);
+        cars.place(PLAYER_CAR, startPosition.x, startPosition.y, 0.0f);
+        cars.place(AI_CAR, startPosition.x, startPosition.y, 0.0f);
+        collisionCache.invalidate();
+
+        aiCurrentWaypoint = 0;
+        aiSpeed = 3.0f;
+        playerCurrentCheckpoint = playerCheckpointsHit = 0;
+        aiCurrentCheckpoint = aiCheckpointsHit = 0;
+        playerProgress = aiProgress = 0.0f;
+        raceOver = false;
+        winner.clear();
+
+        recorder.finish(lastReplayPath); // a race abandoned for the next track
+        const std::string& name = bundle->track.layout().name;
+        const uint64_t hash = trackLayoutHash(bundle->track.layout());
+        bestReplayPath = options.replayDir + "/" + replayFileName(name, "best");
+        lastReplayPath = options.replayDir + "/" + replayFileName(name, "last");
+        bestLapPoses = replayPoseCount(bestReplayPath, hash);
+        ghost.start(bestReplayPath, hash);
+        recorder.begin(fileWriter, options.replayDir, hash, static_cast<uint16_t>(60 / REPLAY_TICK_EVERY));
+        raceTick = 0;
     };
-
-    // Create border segments
-    for (size_t i = 0; i < outerBorder.size() - 1; i++) {
-        addBorderSegment(outerBorder[i], outerBorder[i + 1]);
-        addBorderSegment(innerBorder[i], innerBorder[i + 1]);
-    }
-
-    // Optional "checkpoints" for visualization
-    std::vector<sf::RectangleShape> checkpointShapes;
-    for (size_t i = 0; i < checkpointPositions.size(); i++) {
-        sf::RectangleShape cp(sf::Vector2f(TRACK_WIDTH, 10.f));
-        cp.setOrigin(TRACK_WIDTH / 2.f, 5.f);
-        cp.setPosition(checkpointPositions[i]);
-        cp.setFillColor(sf::Color::Yellow);
-        // Quick orientation hack
-        if (i == 0 || i == 2)
-            cp.setRotation(90.f);
-        checkpointShapes.push_back(cp);
-    }
-
-    // Player controls
-    float playerSpeed = 0.0f;
-    float playerRotation = 0.0f;
-
-    // -------------------- AI Optimization Phase --------------------
-    // Optimize AI waypoints using simple pre-races
-    aiWaypoints = optimizeWaypoints(aiWaypoints, trackBorders, aiSpeed, GENERATIONS);
-
-    // Reset AI car position after optimization
-    aiCar.setPosition(trainingWaypoints[0]);
-    aiCurrentWaypoint = 0;
+    resetRace();
 
     // After training phase and before the game loop
     std::cout << "\nPress Enter to start countdown...";
@@ -312,9 +497,9 @@ int main() {
 
         // Draw regular scene first
         window.clear(sf::Color(0, 100, 0));
-        for (auto& seg : trackSegments) window.draw(seg);
-        for (auto& border : trackBorders) window.draw(border);
-        for (auto& cp : checkpointShapes) window.draw(cp);
+        scenery.update(window.getView(), window.getSize());
+        scenery.draw(window);
+        bundle->track.draw(window);
         window.draw(playerCar);
         window.draw(aiCar);
 
@@ -359,9 +544,6 @@ int main() {
     sf::Clock gameClock;
 
     // -------------------- Main Game Loop --------------------
-    bool raceOver = false;
-    std::string winner;
-
     // Load font for in-game text
     sf::Font font;
     if (!font.loadFromFile("arial.ttf")) {
@@ -369,35 +551,167 @@ int main() {
         // You can set SHOW_DEBUG_TEXT to false to avoid displaying text
     }
 
+    // Optional live telemetry (records go through a lock-free queue to the sender thread)
+    TelemetrySender telemetry;
+    if (!options.telemetryHost.empty()) {
+        telemetry.start(options.telemetryHost, options.telemetryPort, options.telemetryRate);
+    }
+    uint32_t frameNumber = 0;
+    float lastSimMs = 0.0f, lastRenderMs = 0.0f, lastFrameMs = 0.0f;
+    auto frameStart = std::chrono::steady_clock::now();
+
+    // Track editor: E toggles edit mode (race paused), drag centreline points with the mouse.
+    // The AI line is pinned to the centreline on the way in and follows it on the way out.
+    bool editMode = false;
+    size_t draggedPoint = NO_POINT;
+    std::vector<LineAnchor> aiAnchors;
+    std::vector<uint32_t> movedBorders;
+
+    // N after a race asks for the next track; it is swapped in once preloaded
+    bool nextRequested = false;
+
+    // M toggles the memory overlay under the checkpoint status
+    bool showMemory = false;
+
+    // World view; the HUD is drawn with the default view on top. The mouse wheel zooms it.
+    sf::View camera = window.getDefaultView();
+    float cameraZoom = 1.0f;
+
+    // Sheds optional work (HUD text, telemetry, scenery streaming) when frames run long
+    FrameGovernor governor;
+    sf::Text checkpointStatus;
+    checkpointStatus.setFont(font);
+    checkpointStatus.setCharacterSize(24);
+    checkpointStatus.setFillColor(sf::Color::White);
+    checkpointStatus.setPosition(10.f, 10.f);
+
     while (window.isOpen()) {
+        governor.beginFrame();
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed)
                 window.close();
+
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::E) {
+                editMode = !editMode;
+                draggedPoint = NO_POINT;
+                if (editMode) {
+                    aiAnchors.clear();
+                    for (const auto& waypoint : bundle->aiWaypoints) aiAnchors.push_back(anchorTo(bundle->trackLine, waypoint));
+                } else {
+                    // Progress queries and the AI follow the edited track; the borders already do
+                    bundle->trackLine.build(bundle->track.centreline());
+                    for (size_t i = 0; i < aiAnchors.size(); i++) {
+                        bundle->aiWaypoints[i] = anchoredPoint(bundle->trackLine, aiAnchors[i]);
+                    }
+                    bundle->aiLine.build(bundle->aiWaypoints);
+                    aiWaypoints = bundle->aiWaypoints;
+                }
+                std::cout << (editMode ? "Track editor on\n" : "Track editor off\n");
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::M) {
+                showMemory = !showMemory;
+            }
+            if (event.type == sf::Event::MouseWheelScrolled && event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel) {
+                float step = event.mouseWheelScroll.delta > 0 ? 1.0f / CAMERA_ZOOM_STEP : CAMERA_ZOOM_STEP;
+                cameraZoom = std::min(std::max(cameraZoom * step, CAMERA_MIN_ZOOM), CAMERA_MAX_ZOOM);
+                camera.setSize(window.getDefaultView().getSize() * cameraZoom);
+            }
+
+            // N after a race: swap in the preloaded next track
+            if (raceOver && !editMode && !nextRequested && event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::N) {
+                nextRequested = true;
+                if (!trackManager.nextReady()) {
+                    std::cout << "Next track is still training, switching when it is ready...\n";
+                }
+            }
+
+            if (editMode && event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                sf::Vector2f mouse = window.mapPixelToCoords(sf::Vector2i(event.mouseButton.x, event.mouseButton.y), camera);
+                float bestDistance = EDIT_PICK_RADIUS;
+                for (size_t i = 0; i < bundle->track.centreline().size(); i++) {
+                    float d = distance(mouse, bundle->track.centreline()[i]);
+                    if (d < bestDistance) {
+                        bestDistance = d;
+                        draggedPoint = i;
+                    }
+                }
+            }
+            if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left) {
+                draggedPoint = NO_POINT;
+            }
+            if (editMode && draggedPoint != NO_POINT && event.type == sf::Event::MouseMoved) {
+                sf::Vector2f mouse = window.mapPixelToCoords(sf::Vector2i(event.mouseMove.x, event.mouseMove.y), camera);
+                bundle->track.moveCentrelinePoint(draggedPoint, mouse, &movedBorders);
+                for (uint32_t id : movedBorders) {
+                    const sf::RectangleShape& border = bundle->track.borders()[id];
+                    bundle->borderGrid.update(id, orientedBox(border.getTransform(), border.getLocalBounds()));
+                }
+                collisionCache.invalidate();
+            }
         }
 
-        if (!raceOver) {
-            // Player Controls (WASD)
-            playerSpeed = 0.0f;
-            playerRotation = 0.0f;
+        // The swap happens once the next track is built, so the results screen never freezes
+        if (nextRequested && trackManager.nextReady()) {
+            nextRequested = false;
+            bundle = trackManager.takeNext();
+            resetRace();
+            std::cout << "Now racing on " << bundle->track.layout().name << "\n";
+        }
+
+        // Paused in the editor or done racing: background refinement may have every core.
+        // Resuming parks it, and its pre-races in flight give up on their next step.
+        trackManager.setIdle(raceOver || editMode);
 
+        if (!raceOver && !editMode) {
+            // Player Controls (WASD)
+            float throttle[2] = {0.0f, 0.0f};
+            float steer[2] = {0.0f, 0.0f};
             if (sf::Keyboard::isKeyPressed(sf::Keyboard::W))
-                playerSpeed = 5.0f;
+                throttle[PLAYER_CAR] += 1.0f;
             if (sf::Keyboard::isKeyPressed(sf::Keyboard::S))
-                playerSpeed = -3.0f;
+                throttle[PLAYER_CAR] -= 1.0f;
             if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-                playerRotation = -3.0f;
+                steer[PLAYER_CAR] -= 1.0f;
             if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-                playerRotation = 3.0f;
+                steer[PLAYER_CAR] += 1.0f;
 
-            // Update player car position
-            playerCar.rotate(playerRotation);
-            float angle = degToRad(playerCar.getRotation());
-            playerCar.move(std::cos(angle) * playerSpeed, std::sin(angle) * playerSpeed);
+            // AI car logic: steer towards the next waypoint, easing off for sharp turns
+            if (aiCurrentWaypoint < aiWaypoints.size()) {
+                if (distance(aiCar.getPosition(), aiWaypoints[aiCurrentWaypoint]) < AI_WAYPOINT_RADIUS) {
+                    aiCurrentWaypoint++;
+                    if (aiCurrentWaypoint >= aiWaypoints.size()) {
+                        aiCurrentWaypoint = 0; // Loop back to the first waypoint
+                    }
+                }
+                sf::Vector2f toTarget = aiWaypoints[aiCurrentWaypoint] - aiCar.getPosition();
+                float cross = cars.dirX[AI_CAR] * toTarget.y - cars.dirY[AI_CAR] * toTarget.x;
+                float dot = cars.dirX[AI_CAR] * toTarget.x + cars.dirY[AI_CAR] * toTarget.y;
+                float headingError = std::atan2(cross, dot);
+                float targetSpeed = aiSpeed * std::max(0.15f, std::cos(headingError));
+                steer[AI_CAR] = std::clamp(headingError / AI_FULL_LOCK_ANGLE, -1.0f, 1.0f);
+                throttle[AI_CAR] = std::clamp(2.0f * (targetSpeed - cars.speed[AI_CAR]), -1.0f, 1.0f);
+            }
 
-            // Check for collision and adjust position if necessary
-            if (!isWithinBorders(playerCar, playerSpeed, trackBorders)) {
-                // Collision handled in isWithinBorders
+            stepVehicles(vehicleTables, cars, throttle, steer);
+            playerCar.setPosition(cars.x[PLAYER_CAR], cars.y[PLAYER_CAR]);
+            playerCar.setRotation(cars.headingDeg(PLAYER_CAR));
+            aiCar.setPosition(cars.x[AI_CAR], cars.y[AI_CAR]);
+            aiCar.setRotation(cars.headingDeg(AI_CAR));
+
+            // Collisions stop the car and back it off; the model carries on from there
+            if (!isWithinBorders(playerCar, cars.speed[PLAYER_CAR], collisionCache, PLAYER_CAR, bundle->borderGrid)) {
+                cars.x[PLAYER_CAR] = playerCar.getPosition().x;
+                cars.y[PLAYER_CAR] = playerCar.getPosition().y;
+            }
+            if (!isWithinBorders(aiCar, cars.speed[AI_CAR], collisionCache, AI_CAR, bundle->borderGrid)) {
+                cars.x[AI_CAR] = aiCar.getPosition().x;
+                cars.y[AI_CAR] = aiCar.getPosition().y;
+                aiSpeed = std::max(1.0f, aiSpeed - 0.5f);
+                // Head for the closest point ahead instead of backtracking to a missed waypoint
+                aiCurrentWaypoint = reacquireWaypoint(bundle->aiLine, aiCar.getPosition(), aiCurrentWaypoint, RECOVERY_LOOKAHEAD);
+            } else {
+                aiSpeed = std::min(4.0f, aiSpeed + 0.1f);
             }
 
             // Check if player hits checkpoint
@@ -412,32 +726,6 @@ int main() {
                 }
             }
 
-            // AI car logic: move towards the next waypoint
-            if (aiCurrentWaypoint < aiWaypoints.size()) {
-                sf::Vector2f target = aiWaypoints[aiCurrentWaypoint];
-                sf::Vector2f direction = target - aiCar.getPosition();
-                float distanceToTarget = distance(aiCar.getPosition(), target);
-
-                if (distanceToTarget < 10.0f) {
-                    aiCurrentWaypoint++;
-                    if (aiCurrentWaypoint >= aiWaypoints.size()) {
-                        aiCurrentWaypoint = 0; // Loop back to the first waypoint
-                    }
-                } else {
-                    direction /= distanceToTarget;
-                    aiCar.move(direction * aiSpeed);
-                    float targetAngle = radToDeg(std::atan2(direction.y, direction.x));
-                    aiCar.setRotation(targetAngle);
-                    
-                    // Modified speed limits here
-                    if (!isWithinBorders(aiCar, aiSpeed, trackBorders)) {
-                        aiSpeed = std::max(1.0f, aiSpeed - 0.5f);
-                    } else {
-                        aiSpeed = std::min(4.0f, aiSpeed + 0.1f);  // Changed from 5.0f to 4.5f
-                    }
-                }
-            }
-
             // Check if AI hits checkpoint
             if (aiCurrentCheckpoint < checkpointPositions.size()) {
                 if (hasHitCheckpoint(aiCar.getPosition(), checkpointPositions[aiCurrentCheckpoint])) {
@@ -450,70 +738,169 @@ int main() {
                 }
             }
 
+            // Lap progress along the centreline (windowed so the shared start/finish point can't jump to 100%)
+            playerProgress = bundle->trackLine.closest(playerCar.getPosition(), playerProgress - 100.0f, playerProgress + 200.0f).arcLength;
+            aiProgress = bundle->trackLine.closest(aiCar.getPosition(), aiProgress - 100.0f, aiProgress + 200.0f).arcLength;
+
+            if (raceTick % REPLAY_TICK_EVERY == 0) {
+                recorder.record(playerCar.getPosition().x, playerCar.getPosition().y, playerCar.getRotation());
+            }
+            raceTick++;
+
             // Check if the race is over
             if (playerCheckpointsHit >= checkpointPositions.size()) {
                 raceOver = true;
                 winner = "Player";
                 std::cout << "Player Wins!\n";
+                if (bestLapPoses == 0 || recorder.poses() < bestLapPoses) {
+                    // A recording with dropped poses would make a ghost faster than the lap
+                    if (recorder.intact()) {
+                        recorder.finish(bestReplayPath);
+                        std::cout << "New best lap, saved as the ghost for this track\n";
+                    } else {
+                        std::cout << "New best lap, but its recording is incomplete; not saved as the ghost\n";
+                    }
+                }
             } else if (aiCheckpointsHit >= checkpointPositions.size()) {
                 raceOver = true;
                 winner = "AI";
                 std::cout << "AI Wins!\n";
             }
+            if (raceOver) recorder.finish(lastReplayPath);
         }
 
+        if (telemetry.running() && governor.allow(OptionalWork::Telemetry)) {
+            TelemetryRecord record = {};
+            record.frame = frameNumber;
+            record.governorLevel = static_cast<uint8_t>(governor.level());
+            record.simMs = lastSimMs;
+            record.renderMs = lastRenderMs;
+            record.frameMs = lastFrameMs;
+            record.memoryKB = static_cast<uint32_t>(memoryTotal() >> 10);
+
+            record.car = 0;
+            record.checkpoint = static_cast<uint8_t>(playerCheckpointsHit);
+            record.x = playerCar.getPosition().x;
+            record.y = playerCar.getPosition().y;
+            record.speed = cars.speed[PLAYER_CAR];
+            record.heading = playerCar.getRotation();
+            telemetry.push(record);
+
+            record.car = 1;
+            record.checkpoint = static_cast<uint8_t>(aiCheckpointsHit);
+            record.x = aiCar.getPosition().x;
+            record.y = aiCar.getPosition().y;
+            record.speed = cars.speed[AI_CAR];
+            record.heading = aiCar.getRotation();
+            telemetry.push(record);
+            governor.done(OptionalWork::Telemetry);
+        }
+        warnMemoryBudgets(std::cerr);
+        auto simEnd = std::chrono::steady_clock::now();
+
         // Draw everything
         window.clear(sf::Color(0, 100, 0)); // Green background
 
-        // Track
-        for (auto& seg : trackSegments) {
-            window.draw(seg);
+        // Camera follows the player over scenery bigger than the view (or the window's area, zoomed in)
+        {
+            const sf::View& screen = window.getDefaultView();
+            sf::FloatRect world = scenery.isOpen() ? scenery.worldBounds()
+                                                   : sf::FloatRect(screen.getCenter() - screen.getSize() / 2.0f, screen.getSize());
+            camera.setCenter(cameraCentre(playerCar.getPosition(), camera.getSize(), world, screen.getCenter()));
         }
-
-        // Borders
-        for (auto& border : trackBorders) {
-            window.draw(border);
+        window.setView(camera);
+        if (scenery.isOpen() && governor.allow(OptionalWork::Scenery)) {
+            scenery.update(camera, window.getSize()); // skipped: resident tiles are drawn as they are
+            governor.done(OptionalWork::Scenery);
         }
-
-        // Checkpoints
-        for (size_t i = 0; i < checkpointShapes.size(); i++) {
-            window.draw(checkpointShapes[i]);
+        scenery.draw(window);
+
+        // Track, borders and checkpoints
+        bundle->track.draw(window);
+
+        // Editor handles on the centreline
+        if (editMode) {
+            for (size_t i = 0; i < bundle->track.centreline().size(); i++) {
+                sf::CircleShape handle(EDIT_HANDLE_RADIUS);
+                handle.setOrigin(EDIT_HANDLE_RADIUS, EDIT_HANDLE_RADIUS);
+                handle.setPosition(bundle->track.centreline()[i]);
+                handle.setFillColor(i == draggedPoint ? sf::Color::Cyan : sf::Color::White);
+                window.draw(handle);
+            }
         }
 
-        // Player car
-        window.draw(playerCar);
+        // Cars: the ghost goes first and wears the player's skin, so it stays under the live
+        // ones, and is kept out of the on-screen merge so it never hides the player when
+        // zoomed out. Its pose comes from the streamed ring, no file access here.
+        carInstances.clear();
+        ReplayPose ghostPose;
+        // (raceTick has already moved past the tick the player was drawn at)
+        float ghostTick = raceTick ? (raceTick - 1.0f) / REPLAY_TICK_EVERY : 0.0f;
+        if (!editMode && ghost.pose(ghostTick, ghostPose)) {
+            carInstances.push_back(CarInstance{{ghostPose.x, ghostPose.y}, ghostPose.heading, playerSkin, sf::Color(255, 255, 255, GHOST_ALPHA), false});
+        }
+        carInstances.push_back(CarInstance{playerCar.getPosition(), playerCar.getRotation(), playerSkin, sf::Color::White});
+        carInstances.push_back(CarInstance{aiCar.getPosition(), aiCar.getRotation(), aiSkin, sf::Color::White});
+        carRenderer.extract(carInstances, camera, window.getSize());
+        carRenderer.draw(window);
 
-        // AI car
-        window.draw(aiCar);
+        // Text overlays stay fixed on screen
+        window.setView(window.getDefaultView());
 
         // Display race results if finished
         if (raceOver && font.getInfo().family != "") {
             sf::Text resultText;
             resultText.setFont(font);
-            resultText.setString(winner + " Wins!");
+            std::string result = winner + " Wins!";
+            if (nextRequested) {
+                result += "\nNext track is still training...";
+            } else if (trackManager.rotationSize() > 1) {
+                result += "\nPress N for the next track";
+            }
+            resultText.setString(result);
             resultText.setCharacterSize(48);
             resultText.setFillColor(sf::Color::White);
             resultText.setPosition(400.f, 350.f);
             window.draw(resultText);
         }
 
-        // Display checkpoint status
-        if (font.getInfo().family != "") {
-            sf::Text checkpointStatus;
-            checkpointStatus.setFont(font);
-            checkpointStatus.setCharacterSize(24);
-            checkpointStatus.setFillColor(sf::Color::White);
-            checkpointStatus.setPosition(10.f, 10.f);
-
-            std::string status = "Player: " + std::to_string(playerCheckpointsHit) + "/" + std::to_string(checkpointPositions.size()) + "\n";
-            status += "AI: " + std::to_string(aiCheckpointsHit) + "/" + std::to_string(checkpointPositions.size());
+        // Display checkpoint status (the text is only rebuilt when the governor allows)
+        if (font.getInfo().family != "" && governor.allow(OptionalWork::HudText)) {
+            auto percent = [&](float progress) {
+                return std::to_string(static_cast<int>(100.0f * progress / bundle->trackLine.length())) + "%";
+            };
+            std::string status = "Player: " + std::to_string(playerCheckpointsHit) + "/" + std::to_string(checkpointPositions.size()) + "  (" + percent(playerProgress) + ")\n";
+            status += "AI: " + std::to_string(aiCheckpointsHit) + "/" + std::to_string(checkpointPositions.size()) + "  (" + percent(aiProgress) + ")";
+            if (showMemory) {
+                std::ostringstream memory;
+                reportMemory(memory);
+                status += "\n" + memory.str();
+            }
 
             checkpointStatus.setString(status);
-            window.draw(checkpointStatus);
+            governor.done(OptionalWork::HudText);
         }
+        window.draw(checkpointStatus);
 
+        // Frame timings (display() is excluded from render time since it waits on the frame limit)
+        auto renderEnd = std::chrono::steady_clock::now();
+        governor.endFrame();
         window.display();
+        auto frameEnd = std::chrono::steady_clock::now();
+
+        lastSimMs = std::chrono::duration<float, std::milli>(simEnd - frameStart).count();
+        lastRenderMs = std::chrono::duration<float, std::milli>(renderEnd - simEnd).count();
+        lastFrameMs = std::chrono::duration<float, std::milli>(frameEnd - frameStart).count();
+        frameStart = frameEnd;
+        frameNumber++;
     }
 
+    telemetry.stop();
+    governor.report(std::cout);
+    std::cout << "Idle refinement: " << trackManager.refineGenerations() << " generations of racing line pre-races\n";
+    reportMemory(std::cout);
+    recorder.finish(lastReplayPath);
+    ghost.stop();
+
     return 0;
 }
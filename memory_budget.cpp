@@ -0,0 +1,148 @@
+/******************************************************
+ *  Memory Budget - bytes attributed to subsystems, with high-water marks and budgets
+ ******************************************************/
+
+#include "memory_budget.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+static const char* const MEMORY_TAG_NAMES[MEMORY_TAG_COUNT] = {
+    "track-geometry", "collision-index", "population", "line-cache", "replay-buffers", "write-buffers", "textures",
+};
+
+// One cache line per tag, so subsystems allocating on different threads don't contend
+struct alignas(64) TagCounters {
+    std::atomic<uint64_t> current{0};
+    std::atomic<uint64_t> peak{0};
+    std::atomic<uint64_t> budget{0};
+    std::atomic<bool> over{false};   // currently above budget
+    std::atomic<bool> warned{false}; // this crossing has been reported
+};
+static TagCounters counters[MEMORY_TAG_COUNT];
+
+const char* memoryTagName(MemoryTag tag) {
+    return MEMORY_TAG_NAMES[static_cast<size_t>(tag)];
+}
+
+// -------------------- Counters --------------------
+void memoryAllocated(MemoryTag tag, size_t bytes) {
+    TagCounters& c = counters[static_cast<size_t>(tag)];
+    uint64_t now = c.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = c.peak.load(std::memory_order_relaxed);
+    while (now > peak && !c.peak.compare_exchange_weak(peak, now, std::memory_order_relaxed)) {
+    }
+    uint64_t budget = c.budget.load(std::memory_order_relaxed);
+    if (budget && now > budget) c.over.store(true, std::memory_order_relaxed);
+}
+
+void memoryFreed(MemoryTag tag, size_t bytes) {
+    TagCounters& c = counters[static_cast<size_t>(tag)];
+    uint64_t now = c.current.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+    if (c.over.load(std::memory_order_relaxed) && now <= c.budget.load(std::memory_order_relaxed)) {
+        c.over.store(false, std::memory_order_relaxed);
+        c.warned.store(false, std::memory_order_relaxed); // the next crossing is news again
+    }
+}
+
+MemoryUsage memoryUsage(MemoryTag tag) {
+    const TagCounters& c = counters[static_cast<size_t>(tag)];
+    MemoryUsage usage;
+    usage.current = c.current.load(std::memory_order_relaxed);
+    usage.peak = c.peak.load(std::memory_order_relaxed);
+    usage.budget = c.budget.load(std::memory_order_relaxed);
+    return usage;
+}
+
+uint64_t memoryTotal() {
+    uint64_t total = 0;
+    for (const auto& c : counters) total += c.current.load(std::memory_order_relaxed);
+    return total;
+}
+
+// -------------------- Budgets --------------------
+void setMemoryBudget(MemoryTag tag, uint64_t bytes) {
+    TagCounters& c = counters[static_cast<size_t>(tag)];
+    c.budget.store(bytes, std::memory_order_relaxed);
+    c.over.store(bytes && c.current.load(std::memory_order_relaxed) > bytes, std::memory_order_relaxed);
+    c.warned.store(false, std::memory_order_relaxed);
+}
+
+bool parseMemoryBudgets(const std::string& spec) {
+    std::stringstream entries(spec);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        size_t equals = entry.find('=');
+        std::string name = entry.substr(0, equals);
+        size_t t = 0;
+        while (t < MEMORY_TAG_COUNT && name != MEMORY_TAG_NAMES[t]) t++;
+        if (equals == std::string::npos || t == MEMORY_TAG_COUNT) {
+            std::cerr << "Bad memory budget '" << entry << "', expected TAG=MB with TAG one of:";
+            for (const char* known : MEMORY_TAG_NAMES) std::cerr << " " << known;
+            std::cerr << "\n";
+            return false;
+        }
+        const char* value = entry.c_str() + equals + 1;
+        char* end = nullptr;
+        double megabytes = std::strtod(value, &end);
+        if (end == value || *end != '\0' || !std::isfinite(megabytes) || megabytes < 0.0 || megabytes * (1 << 20) >= 1.8e19) {
+            std::cerr << "Bad memory budget '" << entry << "', expected a size in MB\n";
+            return false;
+        }
+        setMemoryBudget(static_cast<MemoryTag>(t), static_cast<uint64_t>(megabytes * (1 << 20)));
+    }
+    return true;
+}
+
+// "12.3 MB" or "45.6 KB", without touching the caller's stream flags
+std::string formatMemoryBytes(uint64_t bytes) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    if (bytes >= (1u << 20)) {
+        text << bytes / double(1 << 20) << " MB";
+    } else {
+        text << bytes / 1024.0 << " KB";
+    }
+    return text.str();
+}
+
+void warnMemoryBudgets(std::ostream& out) {
+    for (size_t t = 0; t < MEMORY_TAG_COUNT; t++) {
+        TagCounters& c = counters[t];
+        if (!c.over.load(std::memory_order_relaxed) || c.warned.exchange(true, std::memory_order_relaxed)) continue;
+        MemoryUsage usage = memoryUsage(static_cast<MemoryTag>(t));
+        out << "Memory budget exceeded: " << MEMORY_TAG_NAMES[t] << " at " << formatMemoryBytes(usage.current) << ", budget "
+            << formatMemoryBytes(usage.budget) << "\n";
+    }
+}
+
+void reportMemory(std::ostream& out) {
+    out << "Memory by subsystem (current / peak / budget):\n";
+    for (size_t t = 0; t < MEMORY_TAG_COUNT; t++) {
+        MemoryUsage usage = memoryUsage(static_cast<MemoryTag>(t));
+        std::string budget = usage.budget ? formatMemoryBytes(usage.budget) : "none";
+        if (usage.budget && usage.current > usage.budget) budget += "  OVER";
+        out << "  " << std::left << std::setw(16) << MEMORY_TAG_NAMES[t] << std::right << formatMemoryBytes(usage.current) << " / "
+            << formatMemoryBytes(usage.peak) << " / " << budget << "\n";
+    }
+}
+
+// -------------------- Charges --------------------
+MemoryCharge& MemoryCharge::operator=(const MemoryCharge& other) {
+    if (this != &other) {
+        set(0);
+        tag = other.tag;
+        set(other.charged);
+    }
+    return *this;
+}
+
+void MemoryCharge::set(size_t bytes) {
+    if (bytes > charged) memoryAllocated(tag, bytes - charged);
+    if (bytes < charged) memoryFreed(tag, charged - bytes);
+    charged = bytes;
+}
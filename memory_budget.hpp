@@ -0,0 +1,106 @@
+/******************************************************
+ *  Memory Budget - bytes attributed to subsystems, with high-water marks and budgets
+ ******************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <new>
+#include <string>
+#include <vector>
+
+// -------------------- Tags --------------------
+enum class MemoryTag : uint8_t {
+    TrackGeometry,  // corners, gate placement and shapes of built tracks
+    CollisionIndex, // wall grids and border grids
+    Population,     // candidates and archives of the optimizers
+    LineCache,      // trained racing lines kept per layout
+    ReplayBuffers,  // ghost read-ahead rings
+    WriteBuffers,   // AsyncWriter buffer pools
+    Textures,       // car textures and scenery tiles, counted at 4 bytes per texel
+    Count
+};
+static const size_t MEMORY_TAG_COUNT = static_cast<size_t>(MemoryTag::Count);
+
+const char* memoryTagName(MemoryTag tag); // e.g. "collision-index"
+
+struct MemoryUsage {
+    uint64_t current = 0;
+    uint64_t peak = 0;   // high-water mark since start
+    uint64_t budget = 0; // 0 = none
+};
+
+// Counters are lock-free and may be updated from any thread
+void memoryAllocated(MemoryTag tag, size_t bytes);
+void memoryFreed(MemoryTag tag, size_t bytes);
+MemoryUsage memoryUsage(MemoryTag tag);
+uint64_t memoryTotal();
+
+// A budget is a soft limit: going over it never fails an allocation, it is reported
+// (once per crossing) by warnMemoryBudgets() and flagged in reportMemory().
+void setMemoryBudget(MemoryTag tag, uint64_t bytes);
+// "population=64,textures=32" in MB; false (with a message) on an unknown tag or a
+// size that is not a plain non-negative number
+bool parseMemoryBudgets(const std::string& spec);
+
+// Prints the tags that went over budget since the last call. Cheap enough for every frame.
+void warnMemoryBudgets(std::ostream& out);
+// One line per tag: current, peak and budget
+void reportMemory(std::ostream& out);
+std::string formatMemoryBytes(uint64_t bytes); // "12.3 MB", "45.6 KB"
+
+// -------------------- Tagged Allocator --------------------
+// std::allocator that counts every byte it hands out against Tag. For containers whose
+// type stays private to their owner; see MemoryCharge for the rest.
+template <class T, MemoryTag Tag>
+struct TaggedAllocator {
+    using value_type = T;
+    template <class U> struct rebind { using other = TaggedAllocator<U, Tag>; };
+
+    TaggedAllocator() = default;
+    template <class U> TaggedAllocator(const TaggedAllocator<U, Tag>&) {}
+
+    T* allocate(size_t n) {
+        T* p = static_cast<T*>(::operator new(n * sizeof(T)));
+        memoryAllocated(Tag, n * sizeof(T));
+        return p;
+    }
+    void deallocate(T* p, size_t n) {
+        memoryFreed(Tag, n * sizeof(T));
+        ::operator delete(p);
+    }
+};
+
+template <class T, class U, MemoryTag Tag>
+bool operator==(const TaggedAllocator<T, Tag>&, const TaggedAllocator<U, Tag>&) { return true; }
+template <class T, class U, MemoryTag Tag>
+bool operator!=(const TaggedAllocator<T, Tag>&, const TaggedAllocator<U, Tag>&) { return false; }
+
+template <class T, MemoryTag Tag>
+using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+
+// -------------------- Charges --------------------
+// Bytes held on a tag's account by an owner whose storage can't use TaggedAllocator
+// (textures, containers that are part of a public interface). set() moves the charge
+// to a new total; copies charge the same bytes again, destruction releases them.
+class MemoryCharge {
+public:
+    explicit MemoryCharge(MemoryTag tag) : tag(tag) {}
+    MemoryCharge(const MemoryCharge& other) : tag(other.tag) { set(other.charged); }
+    MemoryCharge& operator=(const MemoryCharge& other);
+    ~MemoryCharge() { set(0); }
+
+    void set(size_t bytes);
+    size_t bytes() const { return charged; }
+
+private:
+    MemoryTag tag;
+    size_t charged = 0;
+};
+
+// Bytes reserved by a vector, for MemoryCharge::set
+template <class Vector>
+size_t vectorBytes(const Vector& v) {
+    return v.capacity() * sizeof(typename Vector::value_type);
+}
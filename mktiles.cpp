@@ -0,0 +1,53 @@
+/******************************************************
+ *  Speed Racers - scenery tile pyramid builder (make mktiles)
+ ******************************************************/
+
+#include "scenery.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " INPUT_IMAGE OUTPUT.srtp [options]\n"
+              << "  --tile N          tile size in pixels (default 256)\n"
+              << "  --scale S         world units per image pixel (default 1)\n"
+              << "  --origin X Y      world position of the image's top-left corner (default 0 0)\n"
+              << "  --raw             store uncompressed RGBA tiles instead of PNG\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    unsigned tileSize = 256;
+    float scale = 1.0f;
+    sf::Vector2f origin(0.f, 0.f);
+    TileEncoding encoding = TileEncoding::Png;
+
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tile" && i + 1 < argc) {
+            tileSize = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--scale" && i + 1 < argc) {
+            scale = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--origin" && i + 2 < argc) {
+            origin.x = std::strtof(argv[++i], nullptr);
+            origin.y = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--raw") {
+            encoding = TileEncoding::Rgba;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    sf::Image image;
+    if (!image.loadFromFile(argv[1])) {
+        std::cerr << "Cannot load " << argv[1] << "\n";
+        return -1;
+    }
+    return writeTilePyramid(image, argv[2], tileSize, encoding, origin, scale) ? 0 : -1;
+}
@@ -0,0 +1,148 @@
+/******************************************************
+ *  Novelty Archive - behaviour descriptors indexed for k-nearest-neighbour queries
+ ******************************************************/
+
+#include "novelty_archive.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+static const size_t NOVELTY_BLOCK = 64;    // descriptors scanned linearly before they get a tree
+static const uint32_t NOVELTY_LEAF = 8;    // descriptors per k-d tree leaf
+static const uint32_t LEAF = ~0u;
+
+NoveltyArchive::NoveltyArchive(size_t dims) : dims(std::max<size_t>(1, dims)) {
+    pending.reserve(NOVELTY_BLOCK * this->dims);
+}
+
+size_t NoveltyArchive::treeCount() const {
+    size_t built = 0;
+    for (const auto& tree : trees) built += tree.count > 0;
+    return built;
+}
+
+// -------------------- Insertion --------------------
+void NoveltyArchive::insert(const float* descriptor) {
+    pending.insert(pending.end(), descriptor, descriptor + dims);
+    count++;
+    if (pending.size() < NOVELTY_BLOCK * dims) return;
+
+    // Carry the full block up through the occupied levels
+    std::vector<float> carry(pending.begin(), pending.end());
+    pending.clear();
+    for (size_t level = 0;; level++) {
+        if (level == trees.size()) trees.emplace_back();
+        Tree& tree = trees[level];
+        if (tree.count == 0) {
+            buildTree(tree, carry);
+            return;
+        }
+        carry.insert(carry.end(), tree.points.begin(), tree.points.end());
+        tree = Tree();
+    }
+}
+
+void NoveltyArchive::buildTree(Tree& tree, const std::vector<float>& source) {
+    tree.count = source.size() / dims;
+    std::vector<uint32_t> order(tree.count);
+    std::iota(order.begin(), order.end(), 0u);
+    tree.nodes.clear();
+    tree.nodes.reserve(2 * (tree.count / NOVELTY_LEAF + 1));
+    buildNode(tree, source, order, 0, static_cast<uint32_t>(tree.count));
+
+    // Leaves scan contiguous memory
+    tree.points.resize(source.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        std::copy_n(&source[order[i] * dims], dims, &tree.points[i * dims]);
+    }
+}
+
+// Splits at the median of the axis with the widest spread
+uint32_t NoveltyArchive::buildNode(Tree& tree, const std::vector<float>& source, std::vector<uint32_t>& order, uint32_t begin,
+                                   uint32_t end) {
+    const uint32_t index = static_cast<uint32_t>(tree.nodes.size());
+    tree.nodes.push_back(Node{0.f, LEAF, begin, end, 0});
+    if (end - begin <= NOVELTY_LEAF) return index;
+
+    uint32_t axis = 0;
+    float widest = -1.f;
+    for (uint32_t a = 0; a < dims; a++) {
+        float lo = source[order[begin] * dims + a], hi = lo;
+        for (uint32_t i = begin + 1; i < end; i++) {
+            float v = source[order[i] * dims + a];
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+        if (hi - lo > widest) {
+            widest = hi - lo;
+            axis = a;
+        }
+    }
+    const uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&](uint32_t x, uint32_t y) { return source[x * dims + axis] < source[y * dims + axis]; });
+
+    // Left holds coordinates <= split, right >= split
+    const float split = source[order[mid] * dims + axis];
+    buildNode(tree, source, order, begin, mid);
+    const uint32_t right = buildNode(tree, source, order, mid, end);
+    tree.nodes[index].split = split;
+    tree.nodes[index].axis = axis;
+    tree.nodes[index].right = right;
+    return index;
+}
+
+// -------------------- Queries --------------------
+// heap is a max-heap of the k smallest squared distances seen so far
+void NoveltyArchive::consider(const float* point, const float* query, size_t k, std::vector<float>& heap) const {
+    float d = 0.f;
+    for (size_t a = 0; a < dims; a++) {
+        float diff = point[a] - query[a];
+        d += diff * diff;
+    }
+    if (heap.size() < k) {
+        heap.push_back(d);
+        std::push_heap(heap.begin(), heap.end());
+    } else if (d < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = d;
+        std::push_heap(heap.begin(), heap.end());
+    }
+}
+
+void NoveltyArchive::search(const Tree& tree, uint32_t index, const float* query, size_t k, std::vector<float>& heap) const {
+    const Node& node = tree.nodes[index];
+    if (node.axis == LEAF) {
+        for (uint32_t i = node.begin; i < node.end; i++) consider(&tree.points[i * dims], query, k, heap);
+        return;
+    }
+    const float diff = query[node.axis] - node.split;
+    const uint32_t nearChild = diff < 0.f ? index + 1 : node.right;
+    const uint32_t farChild = diff < 0.f ? node.right : index + 1;
+    search(tree, nearChild, query, k, heap);
+    // Everything across the split is at least |diff| away
+    if (heap.size() < k || diff * diff < heap.front()) search(tree, farChild, query, k, heap);
+}
+
+void NoveltyArchive::nearest(const float* descriptor, size_t k, std::vector<float>& distancesSq) const {
+    distancesSq.clear();
+    if (k == 0) return;
+    for (size_t i = 0; i < pending.size(); i += dims) consider(&pending[i], descriptor, k, distancesSq);
+    // Biggest tree first: it holds most of the neighbours, so the bound tightens early
+    for (size_t level = trees.size(); level-- > 0;) {
+        if (trees[level].count) search(trees[level], 0, descriptor, k, distancesSq);
+    }
+    std::sort_heap(distancesSq.begin(), distancesSq.end());
+}
+
+float NoveltyArchive::novelty(const float* descriptor, size_t k, bool inArchive) const {
+    thread_local std::vector<float> distancesSq;
+    // Its own entry is the nearest, at distance 0
+    const size_t skip = inArchive ? 1 : 0;
+    nearest(descriptor, k + skip, distancesSq);
+    if (distancesSq.size() <= skip) return 0.f;
+    float sum = 0.f;
+    for (size_t i = skip; i < distancesSq.size(); i++) sum += std::sqrt(distancesSq[i]);
+    return sum / (distancesSq.size() - skip);
+}
@@ -0,0 +1,61 @@
+/******************************************************
+ *  Novelty Archive - behaviour descriptors indexed for k-nearest-neighbour queries
+ ******************************************************/
+#pragma once
+
+#include "memory_budget.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Every descriptor ever inserted, for novelty search: a candidate's novelty is its mean
+// distance to the k nearest descriptors already in the archive.
+//
+// The index is a forest of static k-d trees of doubling sizes (the logarithmic method).
+// New descriptors collect in a small pending block that is scanned linearly; when it
+// fills, it is merged with every tree it would collide with into one new tree, like
+// carrying in a binary counter. Each descriptor is rebuilt O(log n) times, so an insert
+// is amortized O(log^2 n), and a query searches O(log n) trees that share one
+// k-best bound. The archive can grow to hundreds of thousands of entries while a query
+// stays in the microseconds.
+class NoveltyArchive {
+public:
+    explicit NoveltyArchive(size_t dims);
+
+    void insert(const float* descriptor);
+    size_t size() const { return count; }
+    size_t dimensions() const { return dims; }
+    size_t treeCount() const;
+
+    // Squared distances to the k nearest descriptors, nearest first; fewer if the
+    // archive holds fewer than k
+    void nearest(const float* descriptor, size_t k, std::vector<float>& distancesSq) const;
+
+    // Mean distance to the k nearest descriptors, 0 for an empty archive. With inArchive,
+    // the descriptor has been inserted already and its own entry is not counted.
+    float novelty(const float* descriptor, size_t k, bool inArchive = false) const;
+
+private:
+    struct Node {
+        float split;
+        uint32_t axis;        // LEAF for a leaf
+        uint32_t begin, end;  // leaf: its descriptors, contiguous in the tree's points
+        uint32_t right;       // inner node: right child (the left one follows the node)
+    };
+    struct Tree {
+        TaggedVector<float, MemoryTag::Population> points; // in leaf order
+        TaggedVector<Node, MemoryTag::Population> nodes;
+        size_t count = 0;
+    };
+
+    void buildTree(Tree& tree, const std::vector<float>& source);
+    uint32_t buildNode(Tree& tree, const std::vector<float>& source, std::vector<uint32_t>& order, uint32_t begin, uint32_t end);
+    void search(const Tree& tree, uint32_t node, const float* query, size_t k, std::vector<float>& heap) const;
+    void consider(const float* point, const float* query, size_t k, std::vector<float>& heap) const;
+
+    size_t dims;
+    size_t count = 0;
+    TaggedVector<float, MemoryTag::Population> pending; // fewer than a block, not in any tree
+    std::vector<Tree> trees; // trees[i] holds (block << i) descriptors, or none
+};
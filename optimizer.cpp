@@ -0,0 +1,590 @@
+/******************************************************
+ *  Optimizer - training simulation and racing-line optimization
+ ******************************************************/
+
+#include "optimizer.hpp"
+#include "geometry.hpp"
+#include "racing_line.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+static const float SIM_CAR_LENGTH = 40.0f;
+static const float SIM_CAR_WIDTH = 20.0f;
+static const float SIM_FPS = 60.0f;
+static const float COLLISION_PENALTY = 5.0f; // seconds per collision
+static const float MIN_CORNER_SPEED = 0.2f;  // floor for kinks tighter than the car can turn at any speed
+static const float PROFILE_STEP = 8.0f;      // pixels per integration step along a segment
+
+// -------------------- Car Geometry --------------------
+// Strict overlap, matching sf::Rect::intersects
+static bool overlaps(const sf::FloatRect& a, const sf::FloatRect& b) {
+    return std::max(a.left, b.left) < std::min(a.left + a.width, b.left + b.width) &&
+           std::max(a.top, b.top) < std::min(a.top + a.height, b.top + b.height);
+}
+
+OrientedBox orientedBox(const sf::Transform& transform, const sf::FloatRect& local) {
+    const sf::Vector2f topLeft = transform.transformPoint(sf::Vector2f(local.left, local.top));
+    const sf::Vector2f topRight = transform.transformPoint(sf::Vector2f(local.left + local.width, local.top));
+    const sf::Vector2f bottomRight = transform.transformPoint(sf::Vector2f(local.left + local.width, local.top + local.height));
+    OrientedBox box;
+    box.centre = 0.5f * (topLeft + bottomRight);
+    box.halfU = 0.5f * (topRight - topLeft);
+    box.halfV = 0.5f * (bottomRight - topRight);
+    const float reachX = std::fabs(box.halfU.x) + std::fabs(box.halfV.x), reachY = std::fabs(box.halfU.y) + std::fabs(box.halfV.y);
+    box.bounds = sf::FloatRect(box.centre.x - reachX, box.centre.y - reachY, 2 * reachX, 2 * reachY);
+    return box;
+}
+
+static float dot(sf::Vector2f a, sf::Vector2f b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+// Is there a gap between the boxes along axis? Each box projects to its centre's
+// projection plus or minus its two half edges' projections; offset is b's centre
+// minus a's.
+static bool separatedAlong(sf::Vector2f axis, const OrientedBox& a, const OrientedBox& b, sf::Vector2f offset) {
+    const float reach = std::fabs(dot(axis, a.halfU)) + std::fabs(dot(axis, a.halfV)) + std::fabs(dot(axis, b.halfU)) +
+                        std::fabs(dot(axis, b.halfV));
+    return std::fabs(dot(axis, offset)) >= reach;
+}
+
+bool boxesOverlap(const OrientedBox& a, const OrientedBox& b) {
+    if (!overlaps(a.bounds, b.bounds)) return false;
+    // Two rectangles are apart exactly when a gap shows along one of their edge directions
+    const sf::Vector2f offset = b.centre - a.centre;
+    return !separatedAlong(a.halfU, a, b, offset) && !separatedAlong(a.halfV, a, b, offset) &&
+           !separatedAlong(b.halfU, a, b, offset) && !separatedAlong(b.halfV, a, b, offset);
+}
+
+// A 40x20 car centred on position, like the game's car sprite
+static OrientedBox carBox(sf::Vector2f position, float rotationDeg) {
+    sf::Transform transform;
+    transform.translate(position);
+    transform.rotate(rotationDeg);
+    return orientedBox(transform, sf::FloatRect(-0.5f * SIM_CAR_LENGTH, -0.5f * SIM_CAR_WIDTH, SIM_CAR_LENGTH, SIM_CAR_WIDTH));
+}
+
+std::vector<OrientedBox> borderBoxes(const std::vector<sf::RectangleShape>& borders) {
+    std::vector<OrientedBox> boxes;
+    boxes.reserve(borders.size());
+    for (const auto& border : borders) boxes.push_back(orientedBox(border.getTransform(), border.getLocalBounds()));
+    return boxes;
+}
+
+// -------------------- Border Grid --------------------
+static const size_t BORDER_GRID_MAX_CELLS = 1 << 20;
+static const uint32_t BORDER_GRID_CELL_SLACK = 4; // spare slots per cell, so edits rarely re-lay the grid
+
+void BorderGrid::build(const std::vector<OrientedBox>& borders) {
+    boxes.assign(borders.begin(), borders.end());
+    index();
+}
+
+template <typename Visit>
+void BorderGrid::forEachCell(const sf::FloatRect& r, Visit visit) const {
+    int x0 = static_cast<int>((r.left - origin.x) / cell), x1 = static_cast<int>((r.left + r.width - origin.x) / cell);
+    int y0 = static_cast<int>((r.top - origin.y) / cell), y1 = static_cast<int>((r.top + r.height - origin.y) / cell);
+    for (int cy = std::max(0, y0); cy <= std::min(rows - 1, y1); cy++) {
+        for (int cx = std::max(0, x0); cx <= std::min(cols - 1, x1); cx++) visit(static_cast<size_t>(cy) * cols + cx);
+    }
+}
+
+void BorderGrid::index() {
+    cellStart.assign(1, 0);
+    cellCount.clear();
+    cellItems.clear();
+    cols = rows = 0;
+    if (boxes.empty()) return;
+
+    float minX = boxes[0].bounds.left, minY = boxes[0].bounds.top;
+    float maxX = minX, maxY = minY;
+    for (const auto& box : boxes) {
+        const sf::FloatRect& r = box.bounds;
+        minX = std::min(minX, r.left);
+        minY = std::min(minY, r.top);
+        maxX = std::max(maxX, r.left + r.width);
+        maxY = std::max(maxY, r.top + r.height);
+    }
+
+    // Big maps get bigger cells rather than an unbounded grid. A cell of padding all round
+    // lets the track editor push walls outwards without re-laying the grid.
+    cell = std::max(64.f, std::sqrt((maxX - minX) * (maxY - minY) / BORDER_GRID_MAX_CELLS));
+    origin = sf::Vector2f(minX - cell, minY - cell);
+    cols = static_cast<int>((maxX - minX) / cell) + 3;
+    rows = static_cast<int>((maxY - minY) / cell) + 3;
+
+    cellCount.assign(static_cast<size_t>(cols) * rows, 0);
+    for (const auto& box : boxes) forEachCell(box.bounds, [&](size_t c) { cellCount[c]++; });
+    cellStart.assign(cellCount.size() + 1, 0);
+    for (size_t c = 0; c < cellCount.size(); c++) {
+        cellStart[c + 1] = cellStart[c] + cellCount[c] + BORDER_GRID_CELL_SLACK;
+        cellCount[c] = 0;
+    }
+    cellItems.resize(cellStart.back());
+    for (uint32_t i = 0; i < boxes.size(); i++) forEachCell(boxes[i].bounds, [&](size_t c) { cellItems[cellStart[c] + cellCount[c]++] = i; });
+}
+
+bool BorderGrid::covers(const sf::FloatRect& r) const {
+    return cols > 0 && r.left >= origin.x && r.top >= origin.y && r.left + r.width < origin.x + cols * cell &&
+           r.top + r.height < origin.y + rows * cell;
+}
+
+void BorderGrid::update(uint32_t border, const OrientedBox& box) {
+    const sf::FloatRect& bounds = box.bounds;
+    forEachCell(boxes[border].bounds, [&](size_t c) {
+        uint32_t* items = cellItems.data() + cellStart[c];
+        for (uint32_t k = 0; k < cellCount[c]; k++) {
+            if (items[k] != border) continue;
+            items[k] = items[--cellCount[c]];
+            break;
+        }
+    });
+    boxes[border] = box;
+
+    // A cell out of slack, or a border leaving the covered area, needs a fresh layout
+    bool placed = covers(bounds);
+    if (placed) {
+        forEachCell(bounds, [&](size_t c) { placed = placed && cellStart[c] + cellCount[c] < cellStart[c + 1]; });
+    }
+    if (!placed) {
+        index();
+        return;
+    }
+    forEachCell(bounds, [&](size_t c) { cellItems[cellStart[c] + cellCount[c]++] = border; });
+}
+
+bool BorderGrid::overlapsAny(const OrientedBox& box) const {
+    if (cols == 0) return false;
+    const sf::FloatRect& r = box.bounds;
+    int x0 = std::max(0, static_cast<int>(std::floor((r.left - origin.x) / cell)));
+    int x1 = std::min(cols - 1, static_cast<int>(std::floor((r.left + r.width - origin.x) / cell)));
+    int y0 = std::max(0, static_cast<int>(std::floor((r.top - origin.y) / cell)));
+    int y1 = std::min(rows - 1, static_cast<int>(std::floor((r.top + r.height - origin.y) / cell)));
+
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            size_t c = static_cast<size_t>(cy) * cols + cx;
+            for (uint32_t k = cellStart[c]; k < cellStart[c] + cellCount[c]; k++) {
+                if (boxesOverlap(box, boxes[cellItems[k]])) return true;
+            }
+        }
+    }
+    return false;
+}
+
+void BorderGrid::query(const sf::FloatRect& region, std::vector<uint32_t>& out) const {
+    out.clear();
+    if (cols == 0) return;
+    int x0 = std::max(0, static_cast<int>(std::floor((region.left - origin.x) / cell)));
+    int x1 = std::min(cols - 1, static_cast<int>(std::floor((region.left + region.width - origin.x) / cell)));
+    int y0 = std::max(0, static_cast<int>(std::floor((region.top - origin.y) / cell)));
+    int y1 = std::min(rows - 1, static_cast<int>(std::floor((region.top + region.height - origin.y) / cell)));
+
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            size_t c = static_cast<size_t>(cy) * cols + cx;
+            out.insert(out.end(), cellItems.begin() + cellStart[c], cellItems.begin() + cellStart[c] + cellCount[c]);
+        }
+    }
+    // Borders spanning several cells were listed once per cell
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// -------------------- Simulation Function --------------------
+// Shared by the full-lap and windowed simulations; collides(box) is the wall test.
+// A run whose fitness so far reaches cutoff stops there: it can no longer beat the
+// line that set the cutoff, and a car stuck on a wall would otherwise run to the limit.
+// The car starts as entry says, or on waypoints[0] at aiSpeed. handOverState, if
+// given, receives the car's state once it has passed waypoints[handOver]. A run that
+// finds *abandon set gives up on its next step and returns infinity.
+template <typename Collides>
+static float simulateLine(const std::vector<sf::Vector2f>& waypoints, Collides collides, float aiSpeed, int* collisions = nullptr,
+                          float cutoff = std::numeric_limits<float>::infinity(), float* trajectory = nullptr,
+                          const SimCarState* entry = nullptr, size_t handOver = 0, SimCarState* handOverState = nullptr,
+                          const std::atomic<bool>* abandon = nullptr) {
+    sf::Vector2f position = entry ? entry->position : waypoints[0];
+    float rotation = entry ? entry->rotation : 0.f;
+
+    RacingLine line;
+    line.build(waypoints);
+
+    size_t currentWaypoint = 0;
+    float totalTime = 0.0f;
+    float speed = entry ? entry->speed : aiSpeed;
+    const float TIME_STEP = 1.0f / SIM_FPS;
+    int collisionCount = 0;
+    size_t sampled = 0; // trajectory samples taken
+
+    while (currentWaypoint < waypoints.size() && totalTime < MAX_SIM_TIME && totalTime + collisionCount * COLLISION_PENALTY < cutoff) {
+        if (abandon && abandon->load(std::memory_order_relaxed)) return std::numeric_limits<float>::infinity();
+        sf::Vector2f target = waypoints[currentWaypoint];
+        sf::Vector2f direction = target - position;
+        float distanceToTarget = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+
+        if (distanceToTarget < 10.0f) {
+            if (handOverState && currentWaypoint == handOver) *handOverState = SimCarState{position, rotation, speed};
+            currentWaypoint++;
+            continue;
+        }
+
+        // Normalize direction
+        if (distanceToTarget != 0) {
+            direction /= distanceToTarget;
+        }
+
+        // Move AI car and face the movement direction
+        position += direction * speed;
+        rotation = std::atan2(direction.y, direction.x) * 180.0f / GEO_PI;
+
+        // Check for collision: stop and back off, like isWithinBorders in the race
+        if (collides(carBox(position, rotation))) {
+            speed = 0.0f;
+            position -= sf::Vector2f(std::cos(rotation * GEO_PI / 180.0f), std::sin(rotation * GEO_PI / 180.0f)) * 5.f;
+
+            collisionCount++;
+            totalTime += TIME_STEP * 2; // Penalize time for collision
+            currentWaypoint = reacquireWaypoint(line, position, currentWaypoint, RECOVERY_LOOKAHEAD);
+        }
+
+        totalTime += TIME_STEP;
+        for (; trajectory && sampled < TRAJECTORY_SAMPLES && totalTime >= (sampled + 1) * TRAJECTORY_INTERVAL; sampled++) {
+            trajectory[2 * sampled] = position.x;
+            trajectory[2 * sampled + 1] = position.y;
+        }
+    }
+    // Finished or gave up early: the car stays where it stopped
+    for (; trajectory && sampled < TRAJECTORY_SAMPLES; sampled++) {
+        trajectory[2 * sampled] = position.x;
+        trajectory[2 * sampled + 1] = position.y;
+    }
+
+    if (collisions) *collisions = collisionCount;
+
+    // Fitness calculation: lower time and fewer collisions are better
+    float fitness = totalTime + (collisionCount * COLLISION_PENALTY); // Each collision adds a penalty
+    return fitness;
+}
+
+// Wall test that checks every border
+static auto scanBorders(const std::vector<OrientedBox>& borders) {
+    return [&borders](const OrientedBox& box) {
+        for (const auto& border : borders) {
+            if (boxesOverlap(box, border)) return true;
+        }
+        return false;
+    };
+}
+
+float simulateRun(const std::vector<sf::Vector2f>& waypoints, const std::vector<OrientedBox>& borders, float aiSpeed) {
+    return simulateLine(waypoints, scanBorders(borders), aiSpeed);
+}
+
+float simulateRun(const std::vector<sf::Vector2f>& waypoints, const std::vector<sf::RectangleShape>& borders, float aiSpeed) {
+    return simulateRun(waypoints, borderBoxes(borders), aiSpeed);
+}
+
+float simulateRun(const std::vector<sf::Vector2f>& waypoints, const BorderGrid& borders, float aiSpeed, int* collisions,
+                  const std::atomic<bool>* abandon) {
+    return simulateLine(waypoints, [&](const OrientedBox& box) { return borders.overlapsAny(box); }, aiSpeed, collisions,
+                        std::numeric_limits<float>::infinity(), nullptr, nullptr, 0, nullptr, abandon);
+}
+
+float simulateWindow(const std::vector<sf::Vector2f>& points, const BorderGrid& borders, const SimCarState& entry, size_t handOver,
+                     SimCarState* handOverState) {
+    return simulateLine(points, [&](const OrientedBox& box) { return borders.overlapsAny(box); }, entry.speed, nullptr,
+                        std::numeric_limits<float>::infinity(), nullptr, &entry, handOver, handOverState);
+}
+
+SimCarState windowHandOver(const std::vector<sf::Vector2f>& points, const BorderGrid& borders, const SimCarState& entry,
+                           size_t stride, float aiSpeed) {
+    const SimCarState fresh{points[stride], 0.f, aiSpeed};
+    SimCarState next = fresh;
+    simulateWindow(points, borders, entry, stride, &next);
+    // Only a wall hit stops the car, and nothing in the run gets it moving again: a
+    // window entered at speed 0 would just run out the clock
+    return next.speed > 0.f ? next : fresh;
+}
+
+float simulateTrajectory(const std::vector<sf::Vector2f>& waypoints, const std::vector<OrientedBox>& borders, float aiSpeed,
+                         float* trajectory) {
+    return simulateLine(waypoints, scanBorders(borders), aiSpeed, nullptr, std::numeric_limits<float>::infinity(), trajectory);
+}
+
+float simulateTrajectory(const std::vector<sf::Vector2f>& waypoints, const BorderGrid& borders, float aiSpeed, float* trajectory) {
+    return simulateLine(waypoints, [&](const OrientedBox& box) { return borders.overlapsAny(box); }, aiSpeed, nullptr,
+                        std::numeric_limits<float>::infinity(), trajectory);
+}
+
+// -------------------- Lap Time Estimate --------------------
+static float length(sf::Vector2f v) {
+    return std::sqrt(v.x * v.x + v.y * v.y);
+}
+
+// Discrete curvature at b: the heading change there, spread over the half segments on
+// either side. Unlike the circle through a, b and c, this stays large for kinks.
+static float curvature(sf::Vector2f a, sf::Vector2f b, sf::Vector2f c) {
+    sf::Vector2f u = b - a, w = c - b;
+    float ab = length(u), bc = length(w);
+    if (ab == 0.f || bc == 0.f) return 0.f; // duplicate point, no direction change
+    float turn = std::atan2(std::fabs(u.x * w.y - u.y * w.x), u.x * w.x + u.y * w.y);
+    return 2.f * turn / (ab + bc);
+}
+
+// Fastest speed that holds curvature k: stepVehicles caps the yaw rate (curvature
+// times speed) at min(maxYawRate * min(1, speed / fullLockSpeed), lateralGrip / speed)
+static float cornerSpeed(const VehicleParams& params, float k, float cap) {
+    if (k <= 0.f) return cap;
+    if (k > params.maxYawRate / params.fullLockSpeed) return MIN_CORNER_SPEED;
+    float speed = std::min(std::sqrt(params.lateralGrip / k), params.maxYawRate / k);
+    return std::clamp(speed, MIN_CORNER_SPEED, cap);
+}
+
+float estimateLapTime(const std::vector<sf::Vector2f>& waypoints, const VehicleParams& params, float maxSpeed,
+                      std::vector<float>* speeds) {
+    const size_t n = waypoints.size();
+    std::vector<float> local;
+    std::vector<float>& v = speeds ? *speeds : local;
+    v.assign(n, 0.f);
+    if (n < 2) return 0.f;
+
+    const float cap = maxSpeed > 0.f ? std::min(maxSpeed, vehicleTopSpeed(params)) : vehicleTopSpeed(params);
+    v[0] = 0.f; // standing start, like the race
+    for (size_t i = 1; i + 1 < n; i++) v[i] = cornerSpeed(params, curvature(waypoints[i - 1], waypoints[i], waypoints[i + 1]), cap);
+    v[n - 1] = cap;
+
+    // Accelerations depend on speed, so each segment is integrated in v^2 with a few
+    // midpoint (RK2) steps of at most PROFILE_STEP pixels. Stops as soon as the speed
+    // passes limit, since only min(limit, reach) is kept; most segments stop at once.
+    auto reach = [](float from, float ds, float limit, auto accel) {
+        const int steps = std::max(1, static_cast<int>(std::ceil(ds / PROFILE_STEP)));
+        const float h = ds / steps;
+        float v2 = from * from;
+        for (int k = 0; k < steps && v2 < limit * limit; k++) {
+            float mid = std::sqrt(std::max(0.f, v2 + accel(std::sqrt(v2)) * h));
+            v2 = std::max(0.f, v2 + 2.f * accel(mid) * h);
+        }
+        return std::min(limit, std::sqrt(v2));
+    };
+    auto drive = [&](float speed) { return vehicleEngineAccel(params, speed) - vehicleResistance(params, speed); };
+    auto brake = [&](float speed) { return params.brakeDecel + vehicleResistance(params, speed); };
+
+    for (size_t i = 1; i < n; i++) {
+        v[i] = reach(v[i - 1], length(waypoints[i] - waypoints[i - 1]), v[i], drive);
+    }
+    for (size_t i = n - 1; i-- > 1;) {
+        v[i] = reach(v[i + 1], length(waypoints[i + 1] - waypoints[i]), v[i], brake);
+    }
+
+    // Constant acceleration within a segment: time = distance / mean speed
+    float frames = 0.f;
+    for (size_t i = 1; i < n; i++) {
+        frames += 2.f * length(waypoints[i] - waypoints[i - 1]) / std::max(v[i - 1] + v[i], 2.f * MIN_CORNER_SPEED);
+    }
+    return frames / SIM_FPS;
+}
+
+float estimateLineFitness(const std::vector<sf::Vector2f>& waypoints, const BorderGrid& borders, const VehicleParams& params,
+                          float maxSpeed) {
+    int collisionCount = 0;
+    float rotation = 0.f;
+    for (size_t i = 0; i < waypoints.size(); i++) {
+        if (i + 1 < waypoints.size()) {
+            sf::Vector2f d = waypoints[i + 1] - waypoints[i];
+            rotation = std::atan2(d.y, d.x) * 180.0f / GEO_PI;
+            if (borders.overlapsAny(carBox(waypoints[i] + 0.5f * d, rotation))) collisionCount++;
+        }
+        if (borders.overlapsAny(carBox(waypoints[i], rotation))) collisionCount++;
+    }
+    return estimateLapTime(waypoints, params, maxSpeed) + collisionCount * COLLISION_PENALTY;
+}
+
+// -------------------- Optimization Function --------------------
+std::vector<sf::Vector2f> optimizeWaypoints(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders,
+                                            float aiSpeed, int generations, bool verbose, LineFitness fitnessKind) {
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<float> mutationDist(-20.0f, 20.0f); // Mutation range
+    const std::vector<OrientedBox> boxes = borderBoxes(borders);
+    BorderGrid grid;
+    if (fitnessKind == LineFitness::LapTimeEstimate) grid.build(boxes);
+    const VehicleParams vehicle;
+    auto evaluate = [&](const std::vector<sf::Vector2f>& line) {
+        if (fitnessKind == LineFitness::LapTimeEstimate) return estimateLineFitness(line, grid, vehicle, aiSpeed);
+        return simulateRun(line, boxes, aiSpeed);
+    };
+
+    float bestFitness = evaluate(waypoints);
+    std::vector<sf::Vector2f> bestWaypoints = waypoints;
+
+    if (verbose) std::cout << "Starting AI Optimization...\n";
+
+    for (int gen = 1; gen <= generations; ++gen) {
+        // Create mutated waypoints
+        std::vector<sf::Vector2f> mutatedWaypoints = waypoints;
+        for (auto& wp : mutatedWaypoints) {
+            wp.x += mutationDist(rng);
+            wp.y += mutationDist(rng);
+        }
+
+        // Simulate the mutated waypoints
+        float fitness = evaluate(mutatedWaypoints);
+        if (verbose) std::cout << "Pre-Race " << gen << " - Fitness: " << fitness << " (Best: " << bestFitness << ")\n";
+
+        // If mutated waypoints are better, keep them
+        if (fitness < bestFitness) {
+            bestFitness = fitness;
+            bestWaypoints = mutatedWaypoints;
+            if (verbose) std::cout << "Improved waypoints in Pre-Race " << gen << "!\n";
+        } else {
+            if (verbose) std::cout << "No improvement in Pre-Race " << gen << ".\n";
+        }
+    }
+
+    if (verbose) std::cout << "AI Optimization Complete! Best Fitness: " << bestFitness << "\n\n";
+    return bestWaypoints;
+}
+
+// -------------------- Coarse-to-Fine Optimization --------------------
+// Moves every waypoint by the displacement interpolated from the control points at
+// 0, stride, 2 * stride, ..., with the last waypoint always a control point
+static void applyDisplacements(const std::vector<sf::Vector2f>& base, const std::vector<sf::Vector2f>& displacement, size_t stride,
+                               std::vector<sf::Vector2f>& out) {
+    const size_t n = base.size();
+    out.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        size_t k = std::min(i / stride, displacement.size() - 1);
+        size_t from = k * stride;
+        size_t to = std::min(from + stride, n - 1);
+        float t = to > from ? static_cast<float>(i - from) / (to - from) : 0.f;
+        sf::Vector2f d = k + 1 < displacement.size() ? displacement[k] + (displacement[k + 1] - displacement[k]) * t : displacement[k];
+        out[i] = base[i] + d;
+    }
+}
+
+std::vector<sf::Vector2f> optimizeWaypointsProgressive(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders,
+                                                       float aiSpeed, int generations, const ProgressiveSettings& settings, bool verbose) {
+    const size_t n = waypoints.size();
+    if (n < 3) return optimizeWaypoints(waypoints, borders, aiSpeed, generations, verbose);
+
+    // Strides from the coarsest level down to 1, halving each time
+    std::vector<size_t> strides;
+    size_t stride = (n - 1 + std::max<size_t>(2, settings.coarsestPoints) - 2) / (std::max<size_t>(2, settings.coarsestPoints) - 1);
+    for (; stride > 1; stride = (stride + 1) / 2) strides.push_back(stride);
+    strides.push_back(1);
+
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<float> mutationDist(-20.0f, 20.0f); // Mutation range
+    BorderGrid grid;
+    grid.build(borderBoxes(borders));
+    auto collides = [&](const OrientedBox& box) { return grid.overlapsAny(box); };
+
+    std::vector<sf::Vector2f> base = waypoints, candidateLine;
+    float bestFitness = simulateRun(waypoints, grid, aiSpeed);
+    const float initialFitness = bestFitness;
+    if (verbose) std::cout << "Starting coarse-to-fine AI Optimization (" << strides.size() << " levels)...\n";
+
+    for (size_t level = 0; level < strides.size(); level++) {
+        // The best line so far becomes the base, so the level starts at zero displacement
+        const size_t s = strides[level];
+        const size_t controls = (n - 2) / s + 2;
+        std::vector<sf::Vector2f> best(controls, sf::Vector2f(0.f, 0.f)), candidate;
+        base = waypoints;
+
+        const int levelGenerations = generations / static_cast<int>(strides.size()) +
+                                     (static_cast<int>(level) < generations % static_cast<int>(strides.size()) ? 1 : 0);
+        for (int gen = 1; gen <= levelGenerations; ++gen) {
+            candidate = best;
+            for (auto& d : candidate) {
+                d.x += mutationDist(rng);
+                d.y += mutationDist(rng);
+            }
+            applyDisplacements(base, candidate, s, candidateLine);
+
+            float fitness = simulateLine(candidateLine, collides, aiSpeed, nullptr, bestFitness);
+            if (fitness < bestFitness) {
+                bestFitness = fitness;
+                best.swap(candidate);
+                waypoints = candidateLine;
+            }
+        }
+        if (verbose) {
+            std::cout << "Level " << level + 1 << " (" << controls << " control points, " << levelGenerations
+                      << " pre-races) - Best: " << bestFitness << "\n";
+        }
+    }
+
+    if (verbose) std::cout << "Coarse-to-fine AI Optimization Complete! Fitness: " << initialFitness << " -> " << bestFitness << "\n\n";
+    return waypoints;
+}
+
+// -------------------- Sliding-Window Optimization --------------------
+std::vector<sf::Vector2f> optimizeWaypointsWindowed(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders,
+                                                    float aiSpeed, const WindowSettings& settings, bool verbose) {
+    const size_t n = waypoints.size();
+    const size_t window = std::max<size_t>(3, settings.window);
+    if (n <= window) {
+        return optimizeWaypoints(waypoints, borders, aiSpeed, settings.generationsPerWindow, verbose);
+    }
+    const size_t stride = std::clamp<size_t>(settings.stride, 1, window - 2);
+    const size_t windowCount = (n - window + stride - 1) / stride + 1;
+
+    std::mt19937 rng(std::random_device{}());
+    std::uniform_real_distribution<float> mutationDist(-20.0f, 20.0f); // Mutation range
+    BorderGrid grid;
+    grid.build(borderBoxes(borders));
+
+    // The only per-candidate storage, sized by the window
+    std::vector<sf::Vector2f> best, candidate;
+    best.reserve(window);
+    candidate.reserve(window);
+
+    if (verbose) std::cout << "Starting windowed AI Optimization (" << n << " waypoints, " << windowCount << " windows of " << window << ")...\n";
+
+    // How the car enters each window: the first like a full lap, the others as the
+    // previous window's best line delivered it to their first waypoint
+    SimCarState entry{waypoints[0], 0.f, aiSpeed};
+    float totalBefore = 0.0f, totalAfter = 0.0f;
+    size_t windowIndex = 0;
+    for (size_t start = 0;; start += stride) {
+        const size_t count = std::min(window, n - start);
+        best.assign(waypoints.begin() + start, waypoints.begin() + start + count);
+        float bestFitness = simulateWindow(best, grid, entry);
+        const float initialFitness = bestFitness;
+
+        for (int gen = 1; gen <= settings.generationsPerWindow; ++gen) {
+            // The window's end points are its boundary states and never move
+            candidate = best;
+            for (size_t i = 1; i + 1 < count; i++) {
+                candidate[i].x += mutationDist(rng);
+                candidate[i].y += mutationDist(rng);
+            }
+
+            float fitness = simulateWindow(candidate, grid, entry);
+            if (fitness < bestFitness) {
+                bestFitness = fitness;
+                best.swap(candidate);
+            }
+        }
+
+        std::copy(best.begin(), best.end(), waypoints.begin() + start);
+        totalBefore += initialFitness;
+        totalAfter += bestFitness;
+        windowIndex++;
+
+        if (verbose && (windowIndex % std::max<size_t>(1, windowCount / 10) == 0 || start + count >= n)) {
+            std::cout << "Window " << windowIndex << "/" << windowCount << " - Fitness: " << initialFitness << " -> " << bestFitness << "\n";
+        }
+        if (start + count >= n) break;
+
+        // A car stalled on a wall hands over nothing; the next window then starts fresh
+        // rather than optimizing a car that can't move
+        entry = windowHandOver(best, grid, entry, stride, aiSpeed);
+    }
+
+    if (verbose) std::cout << "Windowed AI Optimization Complete! Summed window fitness: " << totalBefore << " -> " << totalAfter << "\n\n";
+    return waypoints;
+}
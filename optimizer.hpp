@@ -0,0 +1,169 @@
+/******************************************************
+ *  Optimizer - training simulation and racing-line optimization
+ ******************************************************/
+#pragma once
+
+#include "memory_budget.hpp"
+#include "vehicle.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// -------------------- Constants --------------------
+static const int GENERATIONS = 100; // Number of pre-races for optimization
+static const float MAX_SIM_TIME = 120.0f; // A car stopped by a wall never restarts; give up instead of spinning
+static const float RECOVERY_LOOKAHEAD = 200.0f; // How far ahead along the line a car may re-acquire after a collision
+static const size_t LONG_TRACK_WAYPOINTS = 256; // Beyond this, train with the sliding-window optimizer
+
+// A rectangle at any rotation: its centre, two half edges at right angles, and the
+// axis-aligned box around it for broad-phase tests
+struct OrientedBox {
+    sf::Vector2f centre;
+    sf::Vector2f halfU, halfV;
+    sf::FloatRect bounds;
+};
+
+// The box a local rectangle covers once transformed, e.g. a sprite's getTransform()
+// and getLocalBounds()
+OrientedBox orientedBox(const sf::Transform& transform, const sf::FloatRect& local);
+
+// Strict overlap like sf::Rect::intersects, exact for rotated boxes (separating axes)
+bool boxesOverlap(const OrientedBox& a, const OrientedBox& b);
+
+// The borders as the car collides against them, rotation included. Computing these
+// needs no textures or GL context, so training can run on any thread.
+std::vector<OrientedBox> borderBoxes(const std::vector<sf::RectangleShape>& borders);
+
+// Uniform grid over the borders' bounds, so collision checks only look at nearby borders
+class BorderGrid {
+public:
+    void build(const std::vector<OrientedBox>& borders);
+    bool overlapsAny(const OrientedBox& box) const;
+
+    // Moves one border, touching only the cells it leaves and enters. Each cell keeps a
+    // little slack for this; a full cell, or a border leaving the grid, re-lays it all.
+    void update(uint32_t border, const OrientedBox& box);
+
+    // Indices of every border whose cells touch region, each once (a superset of the
+    // borders overlapping it)
+    void query(const sf::FloatRect& region, std::vector<uint32_t>& out) const;
+    const OrientedBox& border(uint32_t index) const { return boxes[index]; }
+
+private:
+    void index();
+    bool covers(const sf::FloatRect& r) const;
+    template <typename Visit>
+    void forEachCell(const sf::FloatRect& r, Visit visit) const;
+
+    TaggedVector<OrientedBox, MemoryTag::CollisionIndex> boxes;
+    TaggedVector<uint32_t, MemoryTag::CollisionIndex> cellStart; // CSR offsets, size cols * rows + 1
+    TaggedVector<uint32_t, MemoryTag::CollisionIndex> cellCount; // items in use from cellStart; the rest is slack
+    TaggedVector<uint32_t, MemoryTag::CollisionIndex> cellItems; // box indices
+    sf::Vector2f origin;
+    float cell = 64.f;
+    int cols = 0;
+    int rows = 0;
+};
+
+// -------------------- Simulation Function --------------------
+// Simulates the AI car running through the waypoints and calculates fitness
+float simulateRun(const std::vector<sf::Vector2f>& waypoints, const std::vector<OrientedBox>& borders, float aiSpeed);
+float simulateRun(const std::vector<sf::Vector2f>& waypoints, const std::vector<sf::RectangleShape>& borders, float aiSpeed);
+
+// Same run against a BorderGrid; collisions, if given, receives how many times the car hit a wall.
+// A run that finds *abandon set gives up within one step and returns infinity.
+float simulateRun(const std::vector<sf::Vector2f>& waypoints, const BorderGrid& borders, float aiSpeed, int* collisions = nullptr,
+                  const std::atomic<bool>* abandon = nullptr);
+
+// A simulated car's state, handed from one window's run to the next
+struct SimCarState {
+    sf::Vector2f position;
+    float rotation = 0.f; // degrees
+    float speed = 0.f;    // pixels per step
+};
+
+// Drives only points[0..count): starts as entry says and finishes on points[count - 1].
+// Cost depends on count, not on the length of the track the points come from.
+// handOverState, if given, receives the car's state as it passes points[handOver].
+float simulateWindow(const std::vector<sf::Vector2f>& points, const BorderGrid& borders, const SimCarState& entry,
+                     size_t handOver = 0, SimCarState* handOverState = nullptr);
+
+// How the car enters the window that starts at points[stride], as a run over points from
+// entry leaves it there. A car that never gets there, or gets there stopped on a wall,
+// hands over nothing: the next window starts it on points[stride] at aiSpeed instead.
+SimCarState windowHandOver(const std::vector<sf::Vector2f>& points, const BorderGrid& borders, const SimCarState& entry,
+                           size_t stride, float aiSpeed);
+
+// -------------------- Trajectory Descriptors --------------------
+// Where simulateRun's car is every TRAJECTORY_INTERVAL seconds, as x, y pairs. A car
+// that finishes or gives up early stays where it stopped, so lines that stall at the
+// same corner, or take the same route, get descriptors close together.
+static const size_t TRAJECTORY_SAMPLES = 5;
+static const float TRAJECTORY_INTERVAL = 2.5f; // seconds
+static const size_t TRAJECTORY_DIMS = 2 * TRAJECTORY_SAMPLES;
+
+// simulateRun that also writes the TRAJECTORY_DIMS floats of the run's descriptor
+float simulateTrajectory(const std::vector<sf::Vector2f>& waypoints, const std::vector<OrientedBox>& borders, float aiSpeed,
+                         float* trajectory);
+float simulateTrajectory(const std::vector<sf::Vector2f>& waypoints, const BorderGrid& borders, float aiSpeed, float* trajectory);
+
+// -------------------- Lap Time Estimate --------------------
+// Quasi-steady-state lap time in seconds for a car with the given limits driving the
+// line from a standing start, with no time stepping. Each waypoint's corner speed comes
+// from the line's curvature there (lateral grip, steering lock, capped at maxSpeed;
+// <= 0 means the car's top speed). A forward pass then limits every point to what full
+// throttle can reach from the point before, and a backward pass to what braking can
+// shed before the point after. O(waypoints). Walls are not considered.
+// speeds, if given, receives the resulting speed profile (pixels per frame).
+float estimateLapTime(const std::vector<sf::Vector2f>& waypoints, const VehicleParams& params, float maxSpeed = 0.f,
+                      std::vector<float>* speeds = nullptr);
+
+// estimateLapTime plus simulateRun's collision penalty for every waypoint and segment
+// midpoint where the car, facing along the line, would touch a wall
+float estimateLineFitness(const std::vector<sf::Vector2f>& waypoints, const BorderGrid& borders, const VehicleParams& params,
+                          float maxSpeed = 0.f);
+
+// -------------------- Optimization Function --------------------
+enum class LineFitness {
+    Simulated,       // simulateRun: steps a constant-speed car through the line
+    LapTimeEstimate, // estimateLineFitness with default VehicleParams, capped at aiSpeed
+};
+
+// Optimizes the AI waypoints by running pre-races and adjusting waypoints based on performance
+std::vector<sf::Vector2f> optimizeWaypoints(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders,
+                                            float aiSpeed, int generations, bool verbose = true,
+                                            LineFitness fitnessKind = LineFitness::Simulated);
+
+// -------------------- Coarse-to-Fine Optimization --------------------
+struct ProgressiveSettings {
+    size_t coarsestPoints = 5; // control points at the first level, ends included
+};
+
+// optimizeWaypoints over a multi-resolution schedule. The genome is a displacement per
+// control point, and every waypoint moves by the displacement interpolated between
+// the control points either side of it. The first level has coarsestPoints controls.
+// Each following level halves the spacing, so a level starts from exactly the previous
+// level's best line. The last level moves every waypoint independently. generations is
+// the total budget, split evenly across the levels.
+std::vector<sf::Vector2f> optimizeWaypointsProgressive(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders,
+                                                       float aiSpeed, int generations,
+                                                       const ProgressiveSettings& settings = ProgressiveSettings(),
+                                                       bool verbose = true);
+
+// -------------------- Sliding-Window Optimization --------------------
+struct WindowSettings {
+    size_t window = 32;            // waypoints per window (K), including the two fixed ends
+    size_t stride = 16;            // how far the window slides; < window so windows overlap
+    int generationsPerWindow = 20;
+};
+
+// Receding-window version of optimizeWaypoints for very long tracks. Each window of K
+// waypoints is optimized with its first and last waypoint held fixed (the car enters
+// and leaves through them), then the window slides forward. Each window's car enters
+// with the position, heading and speed the previous window's best line gave it there
+// (see windowHandOver). Candidate buffers and simulation cost depend on K only.
+std::vector<sf::Vector2f> optimizeWaypointsWindowed(std::vector<sf::Vector2f> waypoints, const std::vector<sf::RectangleShape>& borders,
+                                                    float aiSpeed, const WindowSettings& settings, bool verbose = true);
@@ -0,0 +1,312 @@
+/******************************************************
+ *  Policy - small MLP controllers and int8 inference
+ ******************************************************/
+
+#include "policy.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POLICY_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+static const size_t QUANT_ALIGN = 32; // bytes per AVX2 register
+static const int ACTIVATION_MAX = 127; // 7-bit activations, see policy.hpp
+
+// -------------------- Float Network --------------------
+size_t policyParamCount(const std::vector<size_t>& layers) {
+    size_t count = 0;
+    for (size_t l = 0; l + 1 < layers.size(); l++) {
+        count += layers[l] * layers[l + 1] + layers[l + 1];
+    }
+    return count;
+}
+
+PolicyNet makePolicyNet(const std::vector<size_t>& layers) {
+    PolicyNet net;
+    net.layers = layers;
+    net.params.assign(policyParamCount(layers), 0.f);
+    return net;
+}
+
+void randomizePolicy(PolicyNet& net, std::mt19937& rng) {
+    float* p = net.params.data();
+    for (size_t l = 0; l + 1 < net.layers.size(); l++) {
+        size_t in = net.layers[l], out = net.layers[l + 1];
+        std::normal_distribution<float> weightDist(0.f, std::sqrt(2.f / in));
+        for (size_t i = 0; i < in * out; i++) *p++ = weightDist(rng);
+        for (size_t i = 0; i < out; i++) *p++ = 0.f;
+    }
+}
+
+// Runs one sample through the float network. If ranges is given, it widens
+// ranges[2*l .. 2*l+1] with the min/max of layer l's input (for calibration).
+static void forwardSample(const PolicyNet& net, const float* input, float* output,
+                          std::vector<float>& a, std::vector<float>& b, float* ranges) {
+    const size_t layerCount = net.layers.size() - 1;
+    a.assign(input, input + net.layers[0]);
+    const float* p = net.params.data();
+
+    for (size_t l = 0; l < layerCount; l++) {
+        size_t in = net.layers[l], out = net.layers[l + 1];
+        if (ranges) {
+            for (size_t i = 0; i < in; i++) {
+                ranges[2 * l]     = std::min(ranges[2 * l], a[i]);
+                ranges[2 * l + 1] = std::max(ranges[2 * l + 1], a[i]);
+            }
+        }
+
+        const float* w = p;
+        const float* bias = p + in * out;
+        b.resize(out);
+        for (size_t j = 0; j < out; j++) {
+            float sum = bias[j];
+            const float* row = w + j * in;
+            for (size_t i = 0; i < in; i++) sum += row[i] * a[i];
+            b[j] = (l + 1 == layerCount) ? std::tanh(sum) : std::max(0.f, sum);
+        }
+        p += in * out + out;
+        a.swap(b);
+    }
+    std::copy(a.begin(), a.end(), output);
+}
+
+void evaluatePolicy(const PolicyNet& net, const float* inputs, size_t batch, float* outputs) {
+    std::vector<float> a, b;
+    const size_t in = net.layers.front(), out = net.layers.back();
+    for (size_t s = 0; s < batch; s++) {
+        forwardSample(net, inputs + s * in, outputs + s * out, a, b, nullptr);
+    }
+}
+
+void evaluatePolicyInterleaved(const PolicyNet& net, const float* inputs, size_t batch, float* outputs,
+                               std::vector<float>& scratch) {
+    const size_t layerCount = net.layers.size() - 1;
+    size_t widest = 0;
+    for (size_t width : net.layers) widest = std::max(widest, width);
+    scratch.resize(2 * widest * batch);
+    float* a = scratch.data();
+    float* b = a + widest * batch;
+    std::copy(inputs, inputs + net.layers[0] * batch, a);
+    const float* p = net.params.data();
+
+    for (size_t l = 0; l < layerCount; l++) {
+        size_t in = net.layers[l], out = net.layers[l + 1];
+        const float* w = p;
+        const float* bias = p + in * out;
+        bool last = l + 1 == layerCount;
+        float* dst = last ? outputs : b;
+
+        for (size_t j = 0; j < out; j++) {
+            float* acc = dst + j * batch;
+            const float* row = w + j * in;
+            for (size_t s = 0; s < batch; s++) acc[s] = bias[j];
+            for (size_t i = 0; i < in; i++) {
+                const float weight = row[i];
+                const float* x = a + i * batch;
+                for (size_t s = 0; s < batch; s++) acc[s] += weight * x[s];
+            }
+            for (size_t s = 0; s < batch; s++) acc[s] = last ? std::tanh(acc[s]) : std::max(0.f, acc[s]);
+        }
+        p += in * out + out;
+        std::swap(a, b);
+    }
+}
+
+// -------------------- Quantization --------------------
+QuantizedPolicy quantizePolicy(const PolicyNet& net, const float* calibrationInputs, size_t calibrationCount) {
+    const size_t layerCount = net.layers.size() - 1;
+
+    // Activation ranges always include 0 so the zero point is representable
+    std::vector<float> ranges(2 * layerCount, 0.f);
+    std::vector<float> a, b, out(net.layers.back());
+    for (size_t s = 0; s < calibrationCount; s++) {
+        forwardSample(net, calibrationInputs + s * net.layers[0], out.data(), a, b, ranges.data());
+    }
+
+    QuantizedPolicy policy;
+    const float* p = net.params.data();
+    for (size_t l = 0; l < layerCount; l++) {
+        QuantizedLayer q;
+        q.in = net.layers[l];
+        q.out = net.layers[l + 1];
+        q.stride = (q.in + QUANT_ALIGN - 1) / QUANT_ALIGN * QUANT_ALIGN;
+
+        float lo = ranges[2 * l], hi = ranges[2 * l + 1];
+        q.inputScale = hi > lo ? (hi - lo) / ACTIVATION_MAX : 1.f;
+        q.inputZero = std::clamp(static_cast<int>(std::lround(-lo / q.inputScale)), 0, ACTIVATION_MAX);
+
+        q.weights.assign(q.out * q.stride, 0);
+        q.rowSums.assign(q.out, 0);
+        q.rowScales.resize(q.out);
+        q.bias.assign(p + q.in * q.out, p + q.in * q.out + q.out);
+
+        for (size_t j = 0; j < q.out; j++) {
+            const float* row = p + j * q.in;
+            float maxAbs = 0.f;
+            for (size_t i = 0; i < q.in; i++) maxAbs = std::max(maxAbs, std::fabs(row[i]));
+            float weightScale = maxAbs > 0.f ? maxAbs / 127.f : 1.f;
+
+            for (size_t i = 0; i < q.in; i++) {
+                int w = std::clamp(static_cast<int>(std::lround(row[i] / weightScale)), -127, 127);
+                q.weights[j * q.stride + i] = static_cast<int8_t>(w);
+                q.rowSums[j] += w;
+            }
+            q.rowScales[j] = q.inputScale * weightScale;
+        }
+
+        p += q.in * q.out + q.out;
+        policy.layers.push_back(std::move(q));
+    }
+    return policy;
+}
+
+// -------------------- Int8 Kernels --------------------
+// Each kernel writes acc[j] = dot(activations, row j) over the padded stride
+static void layerDotsScalar(const QuantizedLayer& q, const uint8_t* act, int32_t* acc) {
+    for (size_t j = 0; j < q.out; j++) {
+        const int8_t* row = &q.weights[j * q.stride];
+        int32_t sum = 0;
+        for (size_t i = 0; i < q.in; i++) sum += static_cast<int32_t>(act[i]) * row[i];
+        acc[j] = sum;
+    }
+}
+
+#ifdef POLICY_X86_DISPATCH
+// Reduces four row accumulators to {sum(a), sum(b), sum(c), sum(d)}
+__attribute__((target("avx2")))
+static __m128i horizontalSum4(__m256i a, __m256i b, __m256i c, __m256i d) {
+    __m256i ab = _mm256_hadd_epi32(a, b);
+    __m256i cd = _mm256_hadd_epi32(c, d);
+    __m256i abcd = _mm256_hadd_epi32(ab, cd);
+    return _mm_add_epi32(_mm256_castsi256_si128(abcd), _mm256_extracti128_si256(abcd, 1));
+}
+
+// u8 x s8 pairs -> saturating i16 (safe with 7-bit activations) -> i32.
+// Rows are processed four at a time so each activation load is shared.
+__attribute__((target("avx2")))
+static inline __m256i dotStepAvx2(__m256i sum, __m256i a, const int8_t* row) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+    return _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), ones));
+}
+
+// VNNI fuses the multiply, pairwise add and accumulate into one instruction
+__attribute__((target("avx2,avxvnni")))
+static inline __m256i dotStepVnni(__m256i sum, __m256i a, const int8_t* row) {
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row));
+    return _mm256_dpbusd_avx_epi32(sum, a, w);
+}
+
+#define POLICY_LAYER_DOTS(NAME, TARGET, STEP)                                                   \
+    __attribute__((target(TARGET)))                                                            \
+    static void NAME(const QuantizedLayer& q, const uint8_t* act, int32_t* acc) {              \
+        const size_t stride = q.stride;                                                        \
+        size_t j = 0;                                                                          \
+        for (; j + 4 <= q.out; j += 4) {                                                       \
+            const int8_t* row = &q.weights[j * stride];                                        \
+            __m256i s0 = _mm256_setzero_si256(), s1 = s0, s2 = s0, s3 = s0;                    \
+            for (size_t i = 0; i < stride; i += QUANT_ALIGN) {                                 \
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(act + i));     \
+                s0 = STEP(s0, a, row + i);                                                     \
+                s1 = STEP(s1, a, row + stride + i);                                            \
+                s2 = STEP(s2, a, row + 2 * stride + i);                                        \
+                s3 = STEP(s3, a, row + 3 * stride + i);                                        \
+            }                                                                                  \
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + j), horizontalSum4(s0, s1, s2, s3)); \
+        }                                                                                      \
+        for (; j < q.out; j++) {                                                               \
+            const int8_t* row = &q.weights[j * stride];                                        \
+            __m256i s0 = _mm256_setzero_si256();                                               \
+            for (size_t i = 0; i < stride; i += QUANT_ALIGN) {                                 \
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(act + i));     \
+                s0 = STEP(s0, a, row + i);                                                     \
+            }                                                                                  \
+            acc[j] = _mm_cvtsi128_si32(horizontalSum4(s0, s0, s0, s0));                        \
+        }                                                                                      \
+    }
+
+POLICY_LAYER_DOTS(layerDotsAvx2, "avx2", dotStepAvx2)
+POLICY_LAYER_DOTS(layerDotsAvxVnni, "avx2,avxvnni", dotStepVnni)
+#undef POLICY_LAYER_DOTS
+#endif
+
+Int8Kernel detectInt8Kernel() {
+#ifdef POLICY_X86_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avxvnni")) return Int8Kernel::AvxVnni;
+    if (__builtin_cpu_supports("avx2")) return Int8Kernel::Avx2;
+#endif
+    return Int8Kernel::Scalar;
+}
+
+const char* int8KernelName(Int8Kernel kernel) {
+    switch (kernel) {
+        case Int8Kernel::AvxVnni: return "avx-vnni";
+        case Int8Kernel::Avx2:    return "avx2";
+        default:                  return "scalar";
+    }
+}
+
+static void layerDots(Int8Kernel kernel, const QuantizedLayer& q, const uint8_t* act, int32_t* acc) {
+#ifdef POLICY_X86_DISPATCH
+    if (kernel == Int8Kernel::AvxVnni) return layerDotsAvxVnni(q, act, acc);
+    if (kernel == Int8Kernel::Avx2) return layerDotsAvx2(q, act, acc);
+#endif
+    layerDotsScalar(q, act, acc);
+}
+
+// Round-to-nearest in float and truncate; the clamp keeps the value non-negative so
+// truncation is floor and no libm call is needed on the hot path
+static inline uint8_t quantizeActivation(float x, float invScale, int zero) {
+    float q = std::clamp(x * invScale + (zero + 0.5f), 0.f, ACTIVATION_MAX + 0.5f);
+    return static_cast<uint8_t>(q);
+}
+
+void evaluateQuantizedPolicy(const QuantizedPolicy& policy, const float* inputs, size_t batch, float* outputs,
+                             Int8Kernel kernel) {
+#ifndef POLICY_X86_DISPATCH
+    kernel = Int8Kernel::Scalar;
+#endif
+    size_t widest = 0, widestOut = 0;
+    for (const auto& q : policy.layers) {
+        widest = std::max(widest, q.stride);
+        widestOut = std::max(widestOut, q.out);
+    }
+    std::vector<uint8_t> act(widest, 0);
+    std::vector<int32_t> acc(widestOut);
+
+    std::vector<float> invScales;
+    for (const auto& q : policy.layers) invScales.push_back(1.f / q.inputScale);
+
+    const size_t in = policy.layers.front().in, out = policy.layers.back().out;
+    for (size_t s = 0; s < batch; s++) {
+        const QuantizedLayer& first = policy.layers.front();
+        const float* x = inputs + s * in;
+        for (size_t i = 0; i < in; i++) act[i] = quantizeActivation(x[i], invScales[0], first.inputZero);
+
+        for (size_t l = 0; l < policy.layers.size(); l++) {
+            const QuantizedLayer& q = policy.layers[l];
+            layerDots(kernel, q, act.data(), acc.data());
+
+            // Padding lanes meet zero weights, so stale activations there are harmless
+            const bool last = l + 1 == policy.layers.size();
+            for (size_t j = 0; j < q.out; j++) {
+                float y = q.rowScales[j] * static_cast<float>(acc[j] - q.inputZero * q.rowSums[j]) + q.bias[j];
+                if (last) {
+                    outputs[s * out + j] = std::tanh(y);
+                } else {
+                    const QuantizedLayer& next = policy.layers[l + 1];
+                    act[j] = quantizeActivation(std::max(0.f, y), invScales[l + 1], next.inputZero);
+                }
+            }
+        }
+    }
+}
+
+void evaluateQuantizedPolicy(const QuantizedPolicy& policy, const float* inputs, size_t batch, float* outputs) {
+    static const Int8Kernel kernel = detectInt8Kernel();
+    evaluateQuantizedPolicy(policy, inputs, batch, outputs, kernel);
+}
@@ -0,0 +1,62 @@
+/******************************************************
+ *  Policy - small MLP controllers and int8 inference
+ ******************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Fully connected network: ReLU hidden layers, tanh outputs.
+// For driving, inputs are sensor distances / maxRange followed by speed / max speed,
+// and outputs are {steer, throttle}, both in [-1, 1].
+struct PolicyNet {
+    std::vector<size_t> layers; // e.g. {9, 32, 32, 2}
+    std::vector<float> params;  // per layer: weights [out][in] row-major, then biases [out]
+};
+
+size_t policyParamCount(const std::vector<size_t>& layers);
+PolicyNet makePolicyNet(const std::vector<size_t>& layers);
+void randomizePolicy(PolicyNet& net, std::mt19937& rng);
+
+// Float reference kernel. inputs[batch * layers.front()] -> outputs[batch * layers.back()]
+void evaluatePolicy(const PolicyNet& net, const float* inputs, size_t batch, float* outputs);
+
+// Same network with samples interleaved: inputs[feature * batch + sample] ->
+// outputs[output * batch + sample]. Each weight is loaded once and applied to every
+// sample, so the loops vectorize across samples. Results match evaluatePolicy exactly
+// (same summation order per sample). scratch is resized as needed and can be reused.
+void evaluatePolicyInterleaved(const PolicyNet& net, const float* inputs, size_t batch, float* outputs,
+                               std::vector<float>& scratch);
+
+// -------------------- Int8 Quantization --------------------
+// Post-training quantization: weights are symmetric int8 per output row, activations
+// are unsigned 7-bit (0..127) with a per-layer scale and zero point taken from a
+// calibration pass. Keeping activations to 7 bits means the AVX2 maddubs path can
+// never saturate, so every kernel produces bit-identical results.
+struct QuantizedLayer {
+    size_t in = 0, out = 0, stride = 0; // stride = in rounded up to 32
+    std::vector<int8_t> weights;        // [out][stride], padding is zero
+    std::vector<int32_t> rowSums;       // sum of each row, for the zero-point correction
+    std::vector<float> rowScales;       // inputScale * weightScale per row
+    std::vector<float> bias;
+    float inputScale = 1.f;
+    int inputZero = 0;
+};
+
+struct QuantizedPolicy {
+    std::vector<QuantizedLayer> layers;
+};
+
+enum class Int8Kernel { Scalar, Avx2, AvxVnni };
+
+QuantizedPolicy quantizePolicy(const PolicyNet& net, const float* calibrationInputs, size_t calibrationCount);
+
+// Best kernel the running CPU supports
+Int8Kernel detectInt8Kernel();
+const char* int8KernelName(Int8Kernel kernel);
+
+void evaluateQuantizedPolicy(const QuantizedPolicy& policy, const float* inputs, size_t batch, float* outputs);
+void evaluateQuantizedPolicy(const QuantizedPolicy& policy, const float* inputs, size_t batch, float* outputs,
+                             Int8Kernel kernel);
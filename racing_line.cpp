@@ -0,0 +1,158 @@
+/******************************************************
+ *  Racing Line - closest-point and arc-length queries
+ ******************************************************/
+
+#include "racing_line.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void RacingLine::build(const std::vector<sf::Vector2f>& linePoints, float cellSize) {
+    points = linePoints;
+    cell = cellSize;
+    cumulative.assign(points.size(), 0.f);
+    cellStart.clear();
+    cellItems.clear();
+    cols = rows = 0;
+    if (points.size() < 2) return;
+
+    float minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
+    for (size_t i = 0; i < points.size(); i++) {
+        minX = std::min(minX, points[i].x);
+        maxX = std::max(maxX, points[i].x);
+        minY = std::min(minY, points[i].y);
+        maxY = std::max(maxY, points[i].y);
+        if (i > 0) {
+            sf::Vector2f d = points[i] - points[i - 1];
+            cumulative[i] = cumulative[i - 1] + std::sqrt(d.x * d.x + d.y * d.y);
+        }
+    }
+
+    // About two segments per cell along the line, within sane bounds
+    if (cell <= 0.f) {
+        cell = std::clamp(2.f * length() / (points.size() - 1), 16.f, 256.f);
+    }
+    // Keep the grid itself bounded for very large, sparse layouts
+    while (((maxX - minX) / cell + 1) * ((maxY - minY) / cell + 1) > 4e6f) cell *= 2.f;
+
+    origin = sf::Vector2f(minX, minY);
+    cols = static_cast<int>((maxX - minX) / cell) + 1;
+    rows = static_cast<int>((maxY - minY) / cell) + 1;
+
+    // Each segment goes into the cells covered by its bounding box (two passes: count, fill)
+    auto forEachCell = [&](size_t s, auto&& fn) {
+        const sf::Vector2f& a = points[s];
+        const sf::Vector2f& b = points[s + 1];
+        int x0 = static_cast<int>((std::min(a.x, b.x) - origin.x) / cell);
+        int x1 = static_cast<int>((std::max(a.x, b.x) - origin.x) / cell);
+        int y0 = static_cast<int>((std::min(a.y, b.y) - origin.y) / cell);
+        int y1 = static_cast<int>((std::max(a.y, b.y) - origin.y) / cell);
+        for (int cy = y0; cy <= y1; cy++)
+            for (int cx = x0; cx <= x1; cx++)
+                fn(static_cast<size_t>(cy) * cols + cx);
+    };
+
+    cellStart.assign(static_cast<size_t>(cols) * rows + 1, 0);
+    for (size_t s = 0; s + 1 < points.size(); s++) {
+        forEachCell(s, [&](size_t c) { cellStart[c + 1]++; });
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) cellStart[c] += cellStart[c - 1];
+
+    cellItems.resize(cellStart.back());
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t s = 0; s + 1 < points.size(); s++) {
+        forEachCell(s, [&](size_t c) { cellItems[fill[c]++] = static_cast<uint32_t>(s); });
+    }
+}
+
+void RacingLine::testSegment(uint32_t s, sf::Vector2f p, float minArc, float maxArc, LinePoint& best) const {
+    if (cumulative[s + 1] < minArc || cumulative[s] > maxArc) return;
+
+    const sf::Vector2f& a = points[s];
+    sf::Vector2f ab = points[s + 1] - a;
+    float len2 = ab.x * ab.x + ab.y * ab.y;
+    float t = len2 > 0.f ? ((p.x - a.x) * ab.x + (p.y - a.y) * ab.y) / len2 : 0.f;
+
+    // Clamp to the part of the segment inside the arc window
+    float segLen = cumulative[s + 1] - cumulative[s];
+    float tMin = segLen > 0.f ? std::max(0.f, (minArc - cumulative[s]) / segLen) : 0.f;
+    float tMax = segLen > 0.f ? std::min(1.f, (maxArc - cumulative[s]) / segLen) : 1.f;
+    t = std::clamp(t, tMin, tMax);
+
+    sf::Vector2f q = a + ab * t;
+    sf::Vector2f d = p - q;
+    float dist = std::sqrt(d.x * d.x + d.y * d.y);
+    if (dist < best.distance) {
+        best.point = q;
+        best.segment = s;
+        best.t = t;
+        best.arcLength = cumulative[s] + segLen * t;
+        best.distance = dist;
+    }
+}
+
+LinePoint RacingLine::closest(sf::Vector2f p, float minArc, float maxArc) const {
+    LinePoint best;
+    if (empty()) return best;
+
+    int cx = static_cast<int>(std::floor((p.x - origin.x) / cell));
+    int cy = static_cast<int>(std::floor((p.y - origin.y) / cell));
+
+    // Far outside the grid the ring bound below does not hold; just scan everything
+    if (cx < 0 || cy < 0 || cx >= cols || cy >= rows) {
+        for (uint32_t s = 0; s + 1 < points.size(); s++) testSegment(s, p, minArc, maxArc, best);
+        return best;
+    }
+
+    // Expand square rings of cells. Anything outside ring r is at least r * cell away.
+    const int maxRing = std::max(cols, rows);
+    for (int r = 0; r <= maxRing; r++) {
+        for (int y = cy - r; y <= cy + r; y++) {
+            if (y < 0 || y >= rows) continue;
+            bool edgeRow = (y == cy - r || y == cy + r);
+            for (int x = cx - r; x <= cx + r; x += (edgeRow ? 1 : 2 * r)) {
+                if (x >= 0 && x < cols) {
+                    size_t c = static_cast<size_t>(y) * cols + x;
+                    for (uint32_t i = cellStart[c]; i < cellStart[c + 1]; i++) {
+                        testSegment(cellItems[i], p, minArc, maxArc, best);
+                    }
+                }
+                if (r == 0) break;
+            }
+        }
+        if (best.distance <= r * cell) break;
+    }
+    return best;
+}
+
+static sf::Vector2f segmentNormal(const RacingLine& line, size_t s) {
+    sf::Vector2f d = line.point(s + 1) - line.point(s);
+    float len = std::sqrt(d.x * d.x + d.y * d.y);
+    return len > 0.f ? sf::Vector2f(-d.y / len, d.x / len) : sf::Vector2f(0.f, 0.f);
+}
+
+LineAnchor anchorTo(const RacingLine& line, sf::Vector2f p) {
+    LineAnchor anchor;
+    if (line.empty()) return anchor;
+    LinePoint hit = line.closest(p);
+    sf::Vector2f n = segmentNormal(line, hit.segment);
+    anchor.segment = hit.segment;
+    anchor.t = hit.t;
+    anchor.offset = (p.x - hit.point.x) * n.x + (p.y - hit.point.y) * n.y;
+    return anchor;
+}
+
+sf::Vector2f anchoredPoint(const RacingLine& line, const LineAnchor& anchor) {
+    if (line.empty() || anchor.segment + 1 >= line.size()) return sf::Vector2f();
+    sf::Vector2f a = line.point(anchor.segment), b = line.point(anchor.segment + 1);
+    return a + (b - a) * anchor.t + segmentNormal(line, anchor.segment) * anchor.offset;
+}
+
+size_t reacquireWaypoint(const RacingLine& line, sf::Vector2f position, size_t currentWaypoint, float lookahead) {
+    if (line.empty() || currentWaypoint == 0 || currentWaypoint >= line.size()) return currentWaypoint;
+
+    float from = line.arcLengthAt(currentWaypoint - 1);
+    LinePoint hit = line.closest(position, from, from + lookahead);
+    size_t next = hit.segment + 1;
+    return next > currentWaypoint ? next : currentWaypoint;
+}
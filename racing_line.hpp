@@ -0,0 +1,66 @@
+/******************************************************
+ *  Racing Line - closest-point and arc-length queries
+ ******************************************************/
+#pragma once
+
+#include <SFML/System.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Result of a closest-point query
+struct LinePoint {
+    sf::Vector2f point;   // closest point on the line
+    size_t segment = 0;   // segment index (points[segment] -> points[segment + 1])
+    float t = 0.f;        // position along that segment, 0..1
+    float arcLength = 0.f; // distance along the line from points[0]
+    float distance = std::numeric_limits<float>::max();
+};
+
+// Polyline with a uniform grid of segment indices, so closest-point lookups only
+// touch the few cells around the query point (O(1) on average).
+class RacingLine {
+public:
+    // cellSize <= 0 picks one from the mean segment length
+    void build(const std::vector<sf::Vector2f>& points, float cellSize = 0.f);
+
+    // Closest point whose arc length lies in [minArc, maxArc]
+    LinePoint closest(sf::Vector2f p, float minArc = 0.f,
+                      float maxArc = std::numeric_limits<float>::max()) const;
+
+    float arcLengthAt(size_t pointIndex) const { return cumulative[pointIndex]; }
+    sf::Vector2f point(size_t pointIndex) const { return points[pointIndex]; }
+    float length() const { return cumulative.empty() ? 0.f : cumulative.back(); }
+    size_t size() const { return points.size(); }
+    bool empty() const { return points.size() < 2; }
+
+private:
+    void testSegment(uint32_t s, sf::Vector2f p, float minArc, float maxArc, LinePoint& best) const;
+
+    std::vector<sf::Vector2f> points;
+    std::vector<float> cumulative;     // arc length at each point
+    std::vector<uint32_t> cellStart;   // CSR offsets, size cols * rows + 1
+    std::vector<uint32_t> cellItems;   // segment indices
+    sf::Vector2f origin;
+    float cell = 64.f;
+    int cols = 0;
+    int rows = 0;
+};
+
+// A point pinned to a line: a spot on one of its segments plus a signed offset along
+// that segment's normal. The line's points may move (the track editor), and the
+// anchored point follows them as long as the point count stays the same.
+struct LineAnchor {
+    size_t segment = 0;
+    float t = 0.f;
+    float offset = 0.f;
+};
+
+LineAnchor anchorTo(const RacingLine& line, sf::Vector2f p);
+sf::Vector2f anchoredPoint(const RacingLine& line, const LineAnchor& anchor);
+
+// Recovery steering: if the car is closest to a later part of the line (within
+// lookahead of the segment it is driving), returns the waypoint after that point.
+// Otherwise returns currentWaypoint unchanged. Never moves the target backwards.
+size_t reacquireWaypoint(const RacingLine& line, sf::Vector2f position, size_t currentWaypoint, float lookahead);
@@ -0,0 +1,562 @@
+/******************************************************
+ *  Remote Evaluation - controller genomes scored by worker nodes over TCP
+ ******************************************************/
+
+#include "remote_eval.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// The format is little-endian; every platform we ship on is too
+static bool hostLittleEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// -------------------- Encoding --------------------
+template <typename T>
+static void put(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void putFloats(std::vector<char>& out, const float* values, size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(values);
+    out.insert(out.end(), bytes, bytes + count * sizeof(float));
+}
+
+static void putPoints(std::vector<char>& out, const std::vector<sf::Vector2f>& points) {
+    put(out, static_cast<uint32_t>(points.size()));
+    for (const auto& p : points) {
+        put(out, p.x);
+        put(out, p.y);
+    }
+}
+
+// Bounds-checked reads from a received payload; any short read poisons the reader
+class Reader {
+public:
+    explicit Reader(const std::vector<char>& payload) : data(payload.data()), left(payload.size()) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (!take(&value, sizeof(T))) value = T();
+        return ok;
+    }
+
+    bool getFloats(float* values, size_t count) {
+        return take(values, count * sizeof(float));
+    }
+
+    bool getPoints(std::vector<sf::Vector2f>& points) {
+        uint32_t count = 0;
+        if (!get(count) || count > left / (2 * sizeof(float))) return ok = false;
+        points.resize(count);
+        for (auto& p : points) {
+            get(p.x);
+            get(p.y);
+        }
+        return ok;
+    }
+
+    bool finished() const { return ok && left == 0; }
+
+private:
+    bool take(void* out, size_t size) {
+        if (!ok || size > left) return ok = false;
+        std::memcpy(out, data, size);
+        data += size;
+        left -= size;
+        return true;
+    }
+
+    const char* data;
+    size_t left;
+    bool ok = true;
+};
+
+static std::vector<char> encodeSetup(const std::vector<size_t>& layers, const std::vector<TrackLayout>& tracks,
+                                     const ControllerEvalSettings& eval) {
+    std::vector<char> out;
+    put(out, static_cast<uint32_t>(layers.size()));
+    for (size_t width : layers) put(out, static_cast<uint32_t>(width));
+
+    put(out, static_cast<uint32_t>(eval.rig.anglesDeg.size()));
+    putFloats(out, eval.rig.anglesDeg.data(), eval.rig.anglesDeg.size());
+    put(out, eval.rig.maxRange);
+    put(out, static_cast<int32_t>(eval.maxSteps));
+    put(out, eval.maxSpeed);
+    put(out, eval.maxReverse);
+    put(out, eval.turnRateDeg);
+    put(out, eval.carRadius);
+    put(out, static_cast<uint32_t>(eval.aggregate));
+
+    put(out, static_cast<uint32_t>(tracks.size()));
+    for (const auto& layout : tracks) {
+        put(out, static_cast<uint32_t>(layout.name.size()));
+        out.insert(out.end(), layout.name.begin(), layout.name.end());
+        putPoints(out, layout.centreline);
+        putPoints(out, layout.checkpoints);
+        put(out, layout.width);
+        put(out, layout.wallOffset);
+    }
+    return out;
+}
+
+static bool decodeSetup(const std::vector<char>& payload, std::vector<size_t>& layers, std::vector<EvalTrack>& tracks,
+                        ControllerEvalSettings& eval) {
+    Reader in(payload);
+    uint32_t count = 0;
+    if (!in.get(count) || count < 2 || count > 64) return false;
+    layers.assign(count, 0);
+    for (auto& width : layers) {
+        uint32_t w = 0;
+        if (!in.get(w) || w == 0 || w > 65536) return false;
+        width = w;
+    }
+
+    uint32_t rays = 0, aggregate = 0;
+    int32_t maxSteps = 0;
+    if (!in.get(rays) || rays > 1024) return false;
+    eval.rig.anglesDeg.resize(rays);
+    in.getFloats(eval.rig.anglesDeg.data(), rays);
+    in.get(eval.rig.maxRange);
+    in.get(maxSteps);
+    in.get(eval.maxSpeed);
+    in.get(eval.maxReverse);
+    in.get(eval.turnRateDeg);
+    in.get(eval.carRadius);
+    if (!in.get(aggregate) || aggregate > static_cast<uint32_t>(FitnessAggregate::WorstHalfMean)) return false;
+    eval.maxSteps = maxSteps;
+    eval.aggregate = static_cast<FitnessAggregate>(aggregate);
+    if (layers.front() != rays + 1 || layers.back() != 2) return false; // rays + speed in, steer + throttle out
+
+    if (!in.get(count) || count == 0 || count > 256) return false;
+    tracks.clear();
+    for (uint32_t t = 0; t < count; t++) {
+        TrackLayout layout;
+        uint32_t nameSize = 0;
+        if (!in.get(nameSize) || nameSize > 256) return false;
+        layout.name.resize(nameSize);
+        for (auto& c : layout.name) in.get(c);
+        in.getPoints(layout.centreline);
+        in.getPoints(layout.checkpoints);
+        in.get(layout.width);
+        if (!in.get(layout.wallOffset) || layout.centreline.size() < 2) return false;
+
+        Track track;
+        track.build(layout);
+        tracks.push_back(makeEvalTrack(track));
+    }
+    return in.finished();
+}
+
+// -------------------- Framing --------------------
+static void frameMessage(std::vector<char>& out, RemoteMessage type, uint32_t batch, const std::vector<char>& payload) {
+    RemoteHeader header = {};
+    header.magic = REMOTE_MAGIC;
+    header.version = REMOTE_VERSION;
+    header.type = static_cast<uint16_t>(type);
+    header.batch = batch;
+    header.payloadSize = static_cast<uint32_t>(payload.size());
+    put(out, header);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// Blocking send, for the worker's one connection
+static bool sendMessage(sf::TcpSocket& socket, RemoteMessage type, uint32_t batch, const std::vector<char>& payload,
+                        std::vector<char>& buffer) {
+    buffer.clear();
+    frameMessage(buffer, type, batch, payload);
+    return socket.send(buffer.data(), buffer.size()) == sf::Socket::Done;
+}
+
+// Appends whatever has arrived. Only called once the selector reports the socket
+// ready, so the receive returns at once; false if the peer is gone.
+static bool receiveInto(sf::TcpSocket& socket, std::vector<char>& inbox) {
+    char chunk[16384];
+    size_t received = 0;
+    const sf::Socket::Status status = socket.receive(chunk, sizeof(chunk), received);
+    if (status == sf::Socket::NotReady) return true; // non-blocking socket woken for nothing
+    if (status != sf::Socket::Done) return false;
+    inbox.insert(inbox.end(), chunk, chunk + received);
+    return true;
+}
+
+// Pulls the first complete message off inbox: 1 = got one, 0 = need more bytes, -1 = garbage
+static int takeMessage(std::vector<char>& inbox, RemoteHeader& header, std::vector<char>& payload) {
+    if (inbox.size() < sizeof(RemoteHeader)) return 0;
+    std::memcpy(&header, inbox.data(), sizeof(header));
+    if (header.magic != REMOTE_MAGIC || header.version != REMOTE_VERSION || header.payloadSize > REMOTE_MAX_PAYLOAD) return -1;
+    const size_t total = sizeof(header) + header.payloadSize;
+    if (inbox.size() < total) return 0;
+    payload.assign(inbox.begin() + sizeof(header), inbox.begin() + total);
+    inbox.erase(inbox.begin(), inbox.begin() + total);
+    return 1;
+}
+
+// -------------------- Coordinator --------------------
+RemoteCoordinator::RemoteCoordinator(const RemoteSettings& settings) : settings(settings) {}
+
+RemoteCoordinator::~RemoteCoordinator() {
+    shutdown();
+}
+
+bool RemoteCoordinator::listen(unsigned short listenPort) {
+    if (!hostLittleEndian()) {
+        std::cerr << "Remote: big-endian hosts are not supported\n";
+        return false;
+    }
+    if (listener.listen(listenPort) != sf::Socket::Done) {
+        std::cerr << "Remote: cannot listen on port " << listenPort << "\n";
+        return false;
+    }
+    selector.add(listener);
+    std::cout << "Remote: coordinator listening on port " << port() << "\n";
+    return true;
+}
+
+void RemoteCoordinator::setup(const std::vector<size_t>& layers, const std::vector<TrackLayout>& tracks,
+                              const ControllerEvalSettings& eval) {
+    setupPayload = encodeSetup(layers, tracks, eval);
+    paramCount = policyParamCount(layers);
+    trackCount = tracks.size();
+    for (size_t w = 0; w < workers.size();) {
+        if (sendTo(*workers[w], RemoteMessage::Setup, 0, setupPayload)) {
+            w++;
+        } else {
+            dropWorker(w, "setup failed");
+        }
+    }
+}
+
+// Queues the message behind anything still unsent and sends what the socket will take.
+// False only if the connection has failed.
+bool RemoteCoordinator::sendTo(Worker& worker, RemoteMessage type, uint32_t batch, const std::vector<char>& payload) {
+    if (worker.outbox.empty()) worker.lastSent = Clock::now();
+    frameMessage(worker.outbox, type, batch, payload);
+    return flush(worker);
+}
+
+bool RemoteCoordinator::flush(Worker& worker) {
+    if (worker.outbox.empty()) return true;
+    size_t sent = 0;
+    const sf::Socket::Status status = worker.socket.send(worker.outbox.data(), worker.outbox.size(), sent);
+    if (status == sf::Socket::Disconnected || status == sf::Socket::Error) return false;
+    if (sent > 0) {
+        worker.outbox.erase(worker.outbox.begin(), worker.outbox.begin() + sent);
+        worker.lastSent = Clock::now();
+    }
+    return true;
+}
+
+void RemoteCoordinator::acceptWorker() {
+    auto worker = std::make_unique<Worker>();
+    if (listener.accept(worker->socket) != sf::Socket::Done) return;
+    worker->socket.setBlocking(false);
+    if (!setupPayload.empty() && !sendTo(*worker, RemoteMessage::Setup, 0, setupPayload)) return;
+    selector.add(worker->socket);
+    workers.push_back(std::move(worker));
+}
+
+void RemoteCoordinator::dropWorker(size_t index, const char* reason) {
+    Worker& worker = *workers[index];
+    size_t requeued = 0;
+    for (auto it = worker.inFlight.rbegin(); it != worker.inFlight.rend(); ++it) {
+        if (genomes && !done[it->batch]) {
+            todo.push_front(it->batch);
+            requeued++;
+        }
+    }
+    reissued += requeued;
+    std::cerr << "Remote: dropped a worker (" << reason << "), reissuing " << requeued << " batches\n";
+
+    selector.remove(worker.socket);
+    worker.socket.disconnect();
+    workers.erase(workers.begin() + index);
+}
+
+// Sends what it can of every outbox, waits for traffic, then reads every ready worker
+// and takes new connections. The selector can't wait for a socket to take more, so
+// while anything is queued the wait is kept short.
+void RemoteCoordinator::poll(float timeoutSeconds) {
+    const auto now = Clock::now();
+    bool queued = false;
+    for (size_t w = 0; w < workers.size();) {
+        Worker& worker = *workers[w];
+        if (!flush(worker)) {
+            dropWorker(w, "send failed");
+        } else if (!worker.outbox.empty() && std::chrono::duration<float>(now - worker.lastSent).count() > settings.sendTimeout) {
+            dropWorker(w, "not reading");
+        } else {
+            queued = queued || !worker.outbox.empty();
+            w++;
+        }
+    }
+    if (!selector.wait(sf::seconds(queued ? std::min(timeoutSeconds, 0.002f) : timeoutSeconds))) return;
+
+    RemoteHeader header;
+    std::vector<char> payload;
+    for (size_t w = 0; w < workers.size();) {
+        Worker& worker = *workers[w];
+        if (!selector.isReady(worker.socket)) {
+            w++;
+            continue;
+        }
+        if (!receiveInto(worker.socket, worker.inbox)) {
+            dropWorker(w, "disconnected");
+            continue;
+        }
+
+        int got;
+        bool bad = false;
+        while (!bad && (got = takeMessage(worker.inbox, header, payload)) == 1) {
+            if (header.type == static_cast<uint16_t>(RemoteMessage::Hello)) {
+                Reader in(payload);
+                uint32_t threads = 0;
+                bad = !in.get(threads);
+                if (!bad) std::cout << "Remote: worker joined with " << threads << " threads (" << workers.size() << " connected)\n";
+                continue;
+            }
+            if (header.type != static_cast<uint16_t>(RemoteMessage::Result)) {
+                bad = true;
+                continue;
+            }
+
+            // Results for batches this worker no longer holds (an earlier call) are dropped
+            auto it = std::find_if(worker.inFlight.begin(), worker.inFlight.end(),
+                                   [&](const InFlight& f) { return f.id == header.batch; });
+            if (it == worker.inFlight.end() || !genomes) continue;
+
+            const size_t first = it->batch * batchSize;
+            const size_t count = std::min(batchSize, genomes->size() - first);
+            Reader in(payload);
+            uint32_t gotCount = 0, gotTracks = 0;
+            in.get(gotCount);
+            in.get(gotTracks);
+            if (gotCount != count || gotTracks != trackCount) {
+                bad = true;
+                continue;
+            }
+            in.getFloats(fitnessOut + first, count);
+            scratch.resize(count * trackCount);
+            in.getFloats(scratch.data(), scratch.size());
+            if (!in.finished()) {
+                bad = true;
+                continue;
+            }
+            if (scoresOut) std::copy(scratch.begin(), scratch.end(), scoresOut + first * trackCount);
+
+            done[it->batch] = true;
+            remaining--;
+            worker.inFlight.erase(it);
+            // The next queued batch starts now, so its timeout does too
+            if (!worker.inFlight.empty()) worker.inFlight.front().sent = Clock::now();
+        }
+        if (bad || got < 0) {
+            dropWorker(w, "malformed message");
+            continue;
+        }
+        w++;
+    }
+
+    // After the workers, so a socket accepted now is never checked against this wait
+    if (selector.isReady(listener)) acceptWorker();
+}
+
+bool RemoteCoordinator::evaluate(const std::vector<PolicyNet>& list, float* fitness, float* trackScores) {
+    if (setupPayload.empty()) {
+        std::cerr << "Remote: evaluate() before setup()\n";
+        return false;
+    }
+    for (const auto& genome : list) {
+        if (genome.params.size() != paramCount) {
+            std::cerr << "Remote: genome does not match the setup's layers\n";
+            return false;
+        }
+    }
+
+    batchSize = std::max<size_t>(1, settings.genomesPerBatch);
+    const size_t batchCount = (list.size() + batchSize - 1) / batchSize;
+    todo.clear();
+    for (size_t b = 0; b < batchCount; b++) todo.push_back(b);
+    done.assign(batchCount, false);
+    remaining = batchCount;
+    genomes = &list;
+    fitnessOut = fitness;
+    scoresOut = trackScores;
+    for (auto& worker : workers) worker->inFlight.clear(); // anything left over belongs to an earlier call
+
+    const auto seconds = [](Clock::duration d) { return std::chrono::duration<float>(d).count(); };
+    auto lastWorkerSeen = Clock::now();
+    std::vector<char> payload;
+    while (remaining > 0) {
+        // Keep every worker's pipeline full
+        for (size_t w = 0; w < workers.size();) {
+            Worker& worker = *workers[w];
+            bool sent = true;
+            while (sent && worker.inFlight.size() < std::max<size_t>(1, settings.pipelineDepth) && !todo.empty()) {
+                const size_t b = todo.front();
+                todo.pop_front();
+                if (done[b]) continue;
+
+                const size_t first = b * batchSize;
+                const size_t count = std::min(batchSize, list.size() - first);
+                payload.clear();
+                put(payload, static_cast<uint32_t>(count));
+                for (size_t g = first; g < first + count; g++) putFloats(payload, list[g].params.data(), paramCount);
+
+                worker.inFlight.push_back({nextBatchId, b, Clock::now()});
+                sent = sendTo(worker, RemoteMessage::Batch, nextBatchId++, payload);
+            }
+            if (sent) {
+                w++;
+            } else {
+                dropWorker(w, "send failed");
+            }
+        }
+
+        const auto now = Clock::now();
+        if (!workers.empty()) {
+            lastWorkerSeen = now;
+        } else if (seconds(now - lastWorkerSeen) > settings.workerWaitTimeout) {
+            std::cerr << "Remote: no workers connected for " << settings.workerWaitTimeout << " s, giving up\n";
+            genomes = nullptr;
+            return false;
+        }
+
+        poll(0.1f);
+
+        for (size_t w = 0; w < workers.size();) {
+            const auto& inFlight = workers[w]->inFlight;
+            if (!inFlight.empty() && seconds(Clock::now() - inFlight.front().sent) > settings.batchTimeout) {
+                dropWorker(w, "batch timed out");
+            } else {
+                w++;
+            }
+        }
+    }
+    genomes = nullptr;
+    return true;
+}
+
+bool RemoteCoordinator::waitForWorkers(size_t count, float timeoutSeconds) {
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(timeoutSeconds));
+    while (workers.size() < count && Clock::now() < deadline) poll(0.1f);
+    return workers.size() >= count;
+}
+
+// Best effort: a worker with a backlog may only see the connection close
+void RemoteCoordinator::shutdown() {
+    for (auto& worker : workers) {
+        sendTo(*worker, RemoteMessage::Shutdown, 0, {});
+        selector.remove(worker->socket);
+        worker->socket.disconnect();
+    }
+    workers.clear();
+}
+
+// -------------------- Worker --------------------
+bool runRemoteWorker(const std::string& host, unsigned short port, WorkPool& pool, const std::atomic<bool>* stop) {
+    if (!hostLittleEndian()) {
+        std::cerr << "Remote worker: big-endian hosts are not supported\n";
+        return false;
+    }
+    sf::TcpSocket socket;
+    if (socket.connect(sf::IpAddress(host), port, sf::seconds(5.f)) != sf::Socket::Done) {
+        std::cerr << "Remote worker: cannot reach " << host << ":" << port << "\n";
+        return false;
+    }
+
+    std::vector<char> inbox, payload, reply, buffer;
+    put(reply, static_cast<uint32_t>(pool.threadCount()));
+    if (!sendMessage(socket, RemoteMessage::Hello, 0, reply, buffer)) return false;
+    std::cout << "Remote worker: connected to " << host << ":" << port << "\n";
+
+    const int group = pool.addGroup("remote");
+    sf::SocketSelector selector;
+    selector.add(socket);
+    std::vector<size_t> layers;
+    std::vector<EvalTrack> tracks;
+    ControllerEvalSettings eval;
+    std::vector<PolicyNet> genomes;
+    std::vector<float> fitness, scores;
+    auto stopped = [&] { return stop && stop->load(); };
+
+    for (;;) {
+        if (stopped()) {
+            socket.disconnect();
+            return false;
+        }
+        if (!selector.wait(sf::milliseconds(100))) continue;
+        if (!receiveInto(socket, inbox)) {
+            std::cerr << "Remote worker: coordinator closed the connection\n";
+            return false;
+        }
+
+        RemoteHeader header;
+        int got;
+        while ((got = takeMessage(inbox, header, payload)) == 1) {
+            const auto type = static_cast<RemoteMessage>(header.type);
+            if (type == RemoteMessage::Shutdown) {
+                std::cout << "Remote worker: shut down by coordinator\n";
+                return true;
+            }
+            if (type == RemoteMessage::Setup) {
+                if (!decodeSetup(payload, layers, tracks, eval)) {
+                    std::cerr << "Remote worker: bad setup\n";
+                    return false;
+                }
+                std::cout << "Remote worker: evaluating on " << tracks.size() << " tracks\n";
+                continue;
+            }
+            if (type != RemoteMessage::Batch || tracks.empty()) {
+                std::cerr << "Remote worker: unexpected message\n";
+                return false;
+            }
+
+            Reader in(payload);
+            uint32_t count = 0;
+            const size_t params = policyParamCount(layers);
+            if (!in.get(count) || count == 0 || count > payload.size() / (params * sizeof(float))) {
+                std::cerr << "Remote worker: bad batch\n";
+                return false;
+            }
+            genomes.resize(count);
+            for (auto& genome : genomes) {
+                genome.layers = layers;
+                genome.params.resize(params);
+                in.getFloats(genome.params.data(), params);
+            }
+            if (!in.finished()) {
+                std::cerr << "Remote worker: bad batch\n";
+                return false;
+            }
+
+            fitness.resize(count);
+            scores.resize(count * tracks.size());
+            evaluateControllers(pool, group, genomes, tracks, eval, fitness.data(), scores.data());
+            if (stopped()) {
+                socket.disconnect();
+                return false;
+            }
+
+            reply.clear();
+            put(reply, count);
+            put(reply, static_cast<uint32_t>(tracks.size()));
+            putFloats(reply, fitness.data(), fitness.size());
+            putFloats(reply, scores.data(), scores.size());
+            if (!sendMessage(socket, RemoteMessage::Result, header.batch, reply, buffer)) {
+                std::cerr << "Remote worker: lost the coordinator\n";
+                return false;
+            }
+        }
+        if (got < 0) {
+            std::cerr << "Remote worker: malformed message\n";
+            return false;
+        }
+    }
+}
@@ -0,0 +1,139 @@
+/******************************************************
+ *  Remote Evaluation - controller genomes scored by worker nodes over TCP
+ ******************************************************/
+#pragma once
+
+#include "controller_eval.hpp"
+#include "policy.hpp"
+#include "track.hpp"
+#include "work_pool.hpp"
+
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// -------------------- Wire Format --------------------
+// Every message is a header followed by payloadSize bytes, little-endian:
+//   Hello     worker -> coordinator   u32 threads
+//   Setup     coordinator -> worker   layer widths, evaluation settings, track layouts
+//   Batch     coordinator -> worker   u32 count, then count * paramCount floats
+//   Result    worker -> coordinator   u32 count, u32 tracks, count fitness, count * tracks scores
+//   Shutdown  coordinator -> worker   empty
+// Genomes travel as bare parameters; the layer widths go out once, in Setup.
+struct RemoteHeader {
+    uint32_t magic;       // REMOTE_MAGIC
+    uint16_t version;     // REMOTE_VERSION
+    uint16_t type;        // RemoteMessage
+    uint32_t batch;       // batch id for Batch and Result, 0 otherwise
+    uint32_t payloadSize;
+};
+static_assert(sizeof(RemoteHeader) == 16, "RemoteHeader layout is part of the wire format");
+
+static const uint32_t REMOTE_MAGIC = 0x4E525253; // "SRRN"
+static const uint16_t REMOTE_VERSION = 1;
+static const uint32_t REMOTE_MAX_PAYLOAD = 64u << 20;
+
+enum class RemoteMessage : uint16_t {
+    Hello = 1,
+    Setup = 2,
+    Batch = 3,
+    Result = 4,
+    Shutdown = 5,
+};
+
+struct RemoteSettings {
+    size_t genomesPerBatch = 8;
+    size_t pipelineDepth = 2;       // batches in flight per worker, so the next one is queued while a result travels back
+    float batchTimeout = 60.f;      // seconds; a worker sitting on a batch longer is dropped and its batches reissued
+    float sendTimeout = 10.f;       // seconds a worker may leave what it was sent unread before it is dropped
+    float workerWaitTimeout = 30.f; // evaluate() gives up after this long without any worker connected
+};
+
+// -------------------- Coordinator --------------------
+// Hands genome batches to whichever workers are connected and collects their
+// fitness. Workers can join at any time. A worker that disconnects, sits on a batch
+// past the timeout or stops reading what it is sent is dropped, and everything it held
+// goes back to the front of the queue for the others. Single-threaded: all the work
+// happens inside evaluate(). Worker sockets don't block; a message the socket can't
+// take at once waits in the worker's outbox, so a stalled worker holds up nobody.
+class RemoteCoordinator {
+public:
+    explicit RemoteCoordinator(const RemoteSettings& settings = RemoteSettings());
+    ~RemoteCoordinator();
+
+    // Port 0 picks a free one, see port()
+    bool listen(unsigned short port);
+    unsigned short port() const { return listener.getLocalPort(); }
+
+    // What the workers evaluate against. Goes to every worker now and to each one that joins later.
+    void setup(const std::vector<size_t>& layers, const std::vector<TrackLayout>& tracks, const ControllerEvalSettings& eval);
+
+    // Same contract as evaluateControllers; every genome must have the setup's layers.
+    // Blocks until every genome is scored. False if no worker was connected for workerWaitTimeout.
+    bool evaluate(const std::vector<PolicyNet>& genomes, float* fitness, float* trackScores = nullptr);
+
+    // Accepts connections until at least count workers are in, or the timeout passes
+    bool waitForWorkers(size_t count, float timeoutSeconds);
+
+    // Tells every worker to exit and closes the connections
+    void shutdown();
+
+    size_t workerCount() const { return workers.size(); }
+    size_t reissuedBatches() const { return reissued; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct InFlight {
+        uint32_t id;    // wire batch id
+        size_t batch;   // index into the current evaluate() call's batches
+        Clock::time_point sent;
+    };
+
+    struct Worker {
+        sf::TcpSocket socket;
+        std::vector<char> inbox;    // received bytes not yet parsed into messages
+        std::vector<char> outbox;   // framed messages the socket has not taken yet
+        Clock::time_point lastSent; // when the socket last took bytes from a non-empty outbox
+        std::deque<InFlight> inFlight;
+    };
+
+    void acceptWorker();
+    void dropWorker(size_t index, const char* reason);
+    bool sendTo(Worker& worker, RemoteMessage type, uint32_t batch, const std::vector<char>& payload);
+    bool flush(Worker& worker);
+    void poll(float timeoutSeconds);
+
+    RemoteSettings settings;
+    sf::TcpListener listener;
+    sf::SocketSelector selector;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<char> setupPayload; // empty until setup()
+    size_t paramCount = 0;
+    size_t trackCount = 0;
+
+    // State of the current evaluate() call
+    std::deque<size_t> todo; // batch indices waiting for a worker
+    std::vector<bool> done;
+    size_t remaining = 0;
+    size_t batchSize = 0;
+    const std::vector<PolicyNet>* genomes = nullptr;
+    float* fitnessOut = nullptr;
+    float* scoresOut = nullptr;
+
+    uint32_t nextBatchId = 1;
+    size_t reissued = 0;
+    std::vector<float> scratch;
+};
+
+// -------------------- Worker --------------------
+// Connects to a coordinator and scores its batches on the pool until told to shut
+// down (true) or the connection fails or drops (false). Setting stop makes the
+// worker hang up at once without returning its batches, exactly as if the node died.
+bool runRemoteWorker(const std::string& host, unsigned short port, WorkPool& pool, const std::atomic<bool>* stop = nullptr);
@@ -0,0 +1,170 @@
+/******************************************************
+ *  Replay - recorded laps on disk and a ghost car streamed from them
+ ******************************************************/
+
+#include "replay.hpp"
+#include "artifact.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+// -------------------- Files --------------------
+static bool readReplayHeader(std::ifstream& in, uint64_t trackHash, ReplayHeader& header) {
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    return header.magic == REPLAY_MAGIC && header.version == REPLAY_VERSION && header.tickRate > 0 &&
+           header.trackHash == trackHash;
+}
+
+size_t replayPoseCount(const std::string& path, uint64_t trackHash) {
+    std::ifstream in(path, std::ios::binary);
+    ReplayHeader header;
+    if (!in || !readReplayHeader(in, trackHash, header)) return 0;
+    in.seekg(0, std::ios::end);
+    return (static_cast<size_t>(in.tellg()) - sizeof(ReplayHeader)) / sizeof(ReplayPose);
+}
+
+std::string replayFileName(const std::string& trackName, const char* kind) {
+    std::string file = racingLineFileName(trackName);
+    return file.substr(0, file.size() - 4) + "." + kind + ".srrp";
+}
+
+// -------------------- Recording --------------------
+bool ReplayRecorder::begin(AsyncWriter& target, const std::string& directory, uint64_t trackHash, uint16_t tickRate) {
+    if (recording()) finish(""); // an unfinished recording is left under its scratch name
+    writer = &target;
+    count = 0;
+    dropped = false;
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    // Nothing is synced: a replay lost in a crash is just a lap not saved
+    WriterStreamSettings streamSettings;
+    streamSettings.syncOnClose = false;
+    stream = writer->open(directory + "/recording" + std::to_string(serial++ % 4) + ".tmp", streamSettings);
+    if (stream < 0) return false;
+
+    ReplayHeader header{REPLAY_MAGIC, REPLAY_VERSION, tickRate, trackHash};
+    if (!writer->write(stream, &header, sizeof(header))) dropped = true;
+    return true;
+}
+
+void ReplayRecorder::record(float x, float y, float headingDeg) {
+    if (!recording()) return;
+    ReplayPose pose{x, y, headingDeg};
+    if (!writer->write(stream, &pose, sizeof(pose))) dropped = true;
+    count++;
+}
+
+void ReplayRecorder::finish(const std::string& finalPath) {
+    if (!recording()) return;
+    writer->close(stream, finalPath);
+    stream = -1;
+}
+
+// -------------------- Ghost --------------------
+GhostPlayer::GhostPlayer(size_t readAhead) {
+    size_t capacity = 16;
+    while (capacity < readAhead) capacity <<= 1;
+    ring.resize(capacity);
+    mask = capacity - 1;
+    chunk = capacity / 4;
+}
+
+GhostPlayer::~GhostPlayer() {
+    stop();
+}
+
+void GhostPlayer::start(const std::string& path, uint64_t trackHash) {
+    stop();
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    ended.store(false, std::memory_order_relaxed);
+    rate.store(0, std::memory_order_relaxed);
+    readerWaiting.store(false, std::memory_order_relaxed);
+    underrunCount = 0;
+    stopping = false;
+    reader = std::thread(&GhostPlayer::run, this, path, trackHash);
+}
+
+void GhostPlayer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    space.notify_one();
+    if (reader.joinable()) reader.join();
+}
+
+// Reader thread: decodes straight into the ring, a contiguous run at a time, then
+// sleeps until pose() has freed a chunk
+void GhostPlayer::run(std::string path, uint64_t trackHash) {
+    std::ifstream in(path, std::ios::binary);
+    ReplayHeader header;
+    if (!in || !readReplayHeader(in, trackHash, header)) {
+        ended.store(true, std::memory_order_release);
+        return;
+    }
+    rate.store(header.tickRate, std::memory_order_release);
+
+    const size_t capacity = ring.size();
+    size_t h = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readerWaiting.store(true);
+            space.wait(lock, [&] { return stopping || capacity - (h - tail.load()) >= chunk; });
+            readerWaiting.store(false);
+            if (stopping) return;
+        }
+        size_t free = capacity - (h - tail.load(std::memory_order_acquire));
+        size_t span = std::min(free, capacity - (h & mask));
+        in.read(reinterpret_cast<char*>(&ring[h & mask]), span * sizeof(ReplayPose));
+        size_t got = static_cast<size_t>(in.gcount()) / sizeof(ReplayPose);
+        h += got;
+        head.store(h, std::memory_order_release);
+        if (got < span) {
+            ended.store(true, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+bool GhostPlayer::pose(float tick, ReplayPose& out) {
+    const size_t h = head.load(std::memory_order_acquire);
+    if (h == 0 || tick < 0.f) return false;
+    const size_t want = static_cast<size_t>(tick);
+    const bool over = ended.load(std::memory_order_acquire) && head.load(std::memory_order_acquire) == h;
+    if (over && (want > h - 1 || (want == h - 1 && tick > static_cast<float>(want)))) return false;
+
+    // Release everything before the pose we need, keeping the newest decoded one
+    const size_t t = tail.load(std::memory_order_relaxed);
+    const size_t newTail = std::max(t, std::min(want, h - 1));
+    if (newTail != t) {
+        tail.store(newTail);
+        if (readerWaiting.load() && ring.size() - (h - newTail) >= chunk) {
+            std::lock_guard<std::mutex> lock(mutex);
+            space.notify_one();
+        }
+    }
+
+    const ReplayPose& a = ring[newTail & mask];
+    if (newTail == want && want + 1 < h) {
+        const ReplayPose& b = ring[(want + 1) & mask];
+        const float f = tick - static_cast<float>(want);
+        float turn = std::fmod(b.heading - a.heading, 360.f);
+        if (turn > 180.f) turn -= 360.f;
+        if (turn < -180.f) turn += 360.f;
+        out = {a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f, a.heading + turn * f};
+        return true;
+    }
+    if (!over) underrunCount++; // the reader is behind: hold the newest pose
+    out = a;
+    return true;
+}
+
+bool GhostPlayer::ready(float tick) const {
+    if (ended.load(std::memory_order_acquire)) return true;
+    return head.load(std::memory_order_acquire) > static_cast<size_t>(std::max(0.f, tick)) + 1;
+}
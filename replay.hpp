@@ -0,0 +1,115 @@
+/******************************************************
+ *  Replay - recorded laps on disk and a ghost car streamed from them
+ ******************************************************/
+#pragma once
+
+#include "async_writer.hpp"
+#include "memory_budget.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// -------------------- File Format --------------------
+// [ReplayHeader][ReplayPose x N], little-endian. There is no count: the file is
+// written front to back without seeking, and N follows from the file size.
+struct ReplayHeader {
+    uint32_t magic;    // REPLAY_MAGIC
+    uint16_t version;  // REPLAY_VERSION
+    uint16_t tickRate; // poses per second of race
+    uint64_t trackHash; // trackLayoutHash() of the layout it was driven on
+};
+static_assert(sizeof(ReplayHeader) == 16, "ReplayHeader layout is part of the file format");
+
+struct ReplayPose {
+    float x, y;
+    float heading; // degrees
+};
+static_assert(sizeof(ReplayPose) == 12, "ReplayPose layout is part of the file format");
+
+static const uint32_t REPLAY_MAGIC = 0x50525253; // "SRRP"
+static const uint16_t REPLAY_VERSION = 1;
+
+// Poses in a replay file, 0 if it is missing or wasn't driven on this layout
+size_t replayPoseCount(const std::string& path, uint64_t trackHash);
+
+// File name under the replay directory, e.g. ("L-Shape", "best") -> "l-shape.best.srrp"
+std::string replayFileName(const std::string& trackName, const char* kind);
+
+// -------------------- Recording --------------------
+// Appends one pose per call through an AsyncWriter, so recording costs a copy into
+// the writer's buffers and nothing else. The file is written under a scratch name and
+// only renamed to its final name once the writer has finished it.
+class ReplayRecorder {
+public:
+    bool begin(AsyncWriter& writer, const std::string& directory, uint64_t trackHash, uint16_t tickRate);
+    void record(float x, float y, float headingDeg);
+    void finish(const std::string& finalPath); // rename target, e.g. best or last lap
+    bool recording() const { return stream >= 0; }
+    // Poses recorded, counted per call so the lap's length doesn't depend on the writer
+    size_t poses() const { return count; }
+    // False once the writer has refused any part of the file: it has a gap, and played
+    // back it would run faster than the lap was driven
+    bool intact() const { return recording() && !dropped; }
+
+private:
+    AsyncWriter* writer = nullptr;
+    int stream = -1;
+    size_t count = 0;
+    bool dropped = false;
+    unsigned serial = 0; // scratch names stay unique while an earlier one is still being renamed
+};
+
+// -------------------- Ghost --------------------
+// Plays a replay back from disk in constant memory. A worker thread reads and decodes
+// poses into a fixed ring (readAhead poses) and refills it whenever a chunk has been
+// consumed, so memory is the same for a ten-second lap and a ten-minute one. The game
+// thread only reads the ring: pose() is a couple of loads and an interpolation.
+class GhostPlayer {
+public:
+    explicit GhostPlayer(size_t readAhead = 256);
+    ~GhostPlayer();
+    GhostPlayer(const GhostPlayer&) = delete;
+    GhostPlayer& operator=(const GhostPlayer&) = delete;
+
+    // Streams path from its first pose. A missing file, or one recorded on another
+    // layout, just means no ghost.
+    void start(const std::string& path, uint64_t trackHash);
+    void stop();
+
+    // Pose at a fractional replay tick, interpolated between the two poses around it.
+    // Ticks must not go backwards between start() calls. If the reader has fallen behind,
+    // the newest decoded pose is held (and counted). False before the first pose is
+    // decoded, after the lap is over, or without a ghost.
+    bool pose(float tick, ReplayPose& out);
+
+    // True once pose(tick) can interpolate without holding (or the lap is over)
+    bool ready(float tick) const;
+
+    uint16_t tickRate() const { return rate.load(std::memory_order_acquire); }
+    size_t underruns() const { return underrunCount; }
+    size_t bufferBytes() const { return ring.size() * sizeof(ReplayPose); }
+
+private:
+    void run(std::string path, uint64_t trackHash);
+
+    TaggedVector<ReplayPose, MemoryTag::ReplayBuffers> ring;
+    size_t mask;
+    size_t chunk; // the reader tops the ring up once this many poses are free
+    alignas(64) std::atomic<size_t> head{0}; // poses decoded, written by the reader
+    alignas(64) std::atomic<size_t> tail{0}; // index of the oldest pose still needed, written by pose()
+    std::atomic<bool> ended{false};          // the reader reached the end of the file
+    std::atomic<uint16_t> rate{0};           // 0 until the header checked out
+    std::atomic<bool> readerWaiting{false};  // lets pose() skip the lock unless the reader sleeps
+    size_t underrunCount = 0;
+
+    std::mutex mutex;
+    std::condition_variable space;
+    bool stopping = false;
+    std::thread reader;
+};
@@ -0,0 +1,401 @@
+/******************************************************
+ *  Scenery - tiled background streamed from a memory-mapped pyramid
+ ******************************************************/
+
+#include "scenery.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+static const size_t MAX_UPLOADS_PER_FRAME = 4; // texture uploads stall the GPU queue, spread them out
+static const float PREFETCH_TILES = 1.0f;      // ring of tiles requested beyond the view edges
+
+// Level in the top 8 bits, then 28 bits each for row and column
+static uint64_t tileKey(size_t level, uint32_t column, uint32_t row) {
+    return (static_cast<uint64_t>(level) << 56) | (static_cast<uint64_t>(row) << 28) | column;
+}
+static size_t keyLevel(uint64_t key) { return static_cast<size_t>(key >> 56); }
+static uint32_t keyRow(uint64_t key) { return static_cast<uint32_t>((key >> 28) & 0xFFFFFFF); }
+static uint32_t keyColumn(uint64_t key) { return static_cast<uint32_t>(key & 0xFFFFFFF); }
+
+// -------------------- Writing --------------------
+// 2x2 box filter, odd edges repeat the last row/column
+static sf::Image halveImage(const sf::Image& source) {
+    sf::Vector2u size = source.getSize();
+    unsigned w = std::max(1u, (size.x + 1) / 2), h = std::max(1u, (size.y + 1) / 2);
+    sf::Image result;
+    result.create(w, h);
+    for (unsigned y = 0; y < h; y++) {
+        for (unsigned x = 0; x < w; x++) {
+            unsigned r = 0, g = 0, b = 0, a = 0;
+            for (unsigned k = 0; k < 4; k++) {
+                sf::Color c = source.getPixel(std::min(2 * x + (k & 1), size.x - 1), std::min(2 * y + (k >> 1), size.y - 1));
+                r += c.r; g += c.g; b += c.b; a += c.a;
+            }
+            result.setPixel(x, y, sf::Color(r / 4, g / 4, b / 4, a / 4));
+        }
+    }
+    return result;
+}
+
+// Copies one tile out of a level image, padding with transparent pixels.
+// Returns false if the tile is fully transparent.
+static bool extractTile(const sf::Image& level, unsigned tileSize, unsigned column, unsigned row, std::vector<uint8_t>& rgba) {
+    sf::Vector2u size = level.getSize();
+    rgba.assign(static_cast<size_t>(tileSize) * tileSize * 4, 0);
+    bool visible = false;
+    for (unsigned y = 0; y < tileSize && row * tileSize + y < size.y; y++) {
+        for (unsigned x = 0; x < tileSize && column * tileSize + x < size.x; x++) {
+            sf::Color c = level.getPixel(column * tileSize + x, row * tileSize + y);
+            uint8_t* out = &rgba[(static_cast<size_t>(y) * tileSize + x) * 4];
+            out[0] = c.r; out[1] = c.g; out[2] = c.b; out[3] = c.a;
+            visible = visible || c.a != 0;
+        }
+    }
+    return visible;
+}
+
+// SFML 2.5 can only encode images to a file, so PNG tiles go through a scratch file
+static bool encodePng(const std::vector<uint8_t>& rgba, unsigned tileSize, const std::string& scratchPath, std::vector<uint8_t>& out) {
+    sf::Image tile;
+    tile.create(tileSize, tileSize, rgba.data());
+    if (!tile.saveToFile(scratchPath)) return false;
+    std::ifstream in(scratchPath, std::ios::binary);
+    out.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !out.empty();
+}
+
+bool writeTilePyramid(const sf::Image& image, const std::string& path, unsigned tileSize,
+                      TileEncoding encoding, sf::Vector2f origin, float worldScale) {
+    sf::Vector2u size = image.getSize();
+    if (tileSize == 0 || size.x == 0 || size.y == 0) {
+        std::cerr << "Tile pyramid: empty image or tile size\n";
+        return false;
+    }
+
+    std::vector<sf::Image> levelImages(1, image);
+    while (levelImages.back().getSize().x > tileSize || levelImages.back().getSize().y > tileSize) {
+        levelImages.push_back(halveImage(levelImages.back()));
+    }
+
+    TilePyramidHeader header = {};
+    header.magic = TILE_PYRAMID_MAGIC;
+    header.version = TILE_PYRAMID_VERSION;
+    header.encoding = static_cast<uint16_t>(encoding);
+    header.tileSize = tileSize;
+    header.levelCount = static_cast<uint32_t>(levelImages.size());
+    header.width = size.x;
+    header.height = size.y;
+    header.originX = origin.x;
+    header.originY = origin.y;
+    header.worldScale = worldScale;
+
+    std::vector<TilePyramidLevel> levels;
+    uint32_t tileCount = 0;
+    for (const auto& level : levelImages) {
+        TilePyramidLevel entry = {};
+        entry.columns = (level.getSize().x + tileSize - 1) / tileSize;
+        entry.rows = (level.getSize().y + tileSize - 1) / tileSize;
+        entry.firstTile = tileCount;
+        tileCount += entry.columns * entry.rows;
+        levels.push_back(entry);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Tile pyramid: cannot write " << path << "\n";
+        return false;
+    }
+    std::vector<TilePyramidEntry> entries(tileCount, TilePyramidEntry{});
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(levels.data()), levels.size() * sizeof(TilePyramidLevel));
+    const std::streamoff tableOffset = out.tellp();
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TilePyramidEntry));
+
+    const std::string scratchPath = path + ".tile.png";
+    std::vector<uint8_t> rgba, payload;
+    for (size_t l = 0; l < levelImages.size(); l++) {
+        for (uint32_t row = 0; row < levels[l].rows; row++) {
+            for (uint32_t column = 0; column < levels[l].columns; column++) {
+                if (!extractTile(levelImages[l], tileSize, column, row, rgba)) continue;
+
+                if (encoding == TileEncoding::Png) {
+                    if (!encodePng(rgba, tileSize, scratchPath, payload)) {
+                        std::cerr << "Tile pyramid: PNG encoding failed\n";
+                        std::remove(scratchPath.c_str());
+                        return false;
+                    }
+                } else {
+                    payload.swap(rgba);
+                }
+
+                TilePyramidEntry& entry = entries[levels[l].firstTile + row * levels[l].columns + column];
+                entry.offset = static_cast<uint64_t>(out.tellp());
+                entry.size = static_cast<uint32_t>(payload.size());
+                out.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+            }
+        }
+    }
+    std::remove(scratchPath.c_str());
+
+    out.seekp(tableOffset);
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TilePyramidEntry));
+    if (!out) {
+        std::cerr << "Tile pyramid: write to " << path << " failed\n";
+        return false;
+    }
+    std::cout << "Tile pyramid: " << levelImages.size() << " levels, " << tileCount << " tiles -> " << path << "\n";
+    return true;
+}
+
+// -------------------- Reading --------------------
+bool TilePyramid::open(const std::string& path) {
+    levels.clear();
+    entries = nullptr;
+    if (!file.open(path)) return false;
+
+    auto fail = [&](const char* reason) {
+        std::cerr << "Tile pyramid " << path << ": " << reason << "\n";
+        file.close();
+        return false;
+    };
+
+    if (file.size() < sizeof(TilePyramidHeader)) return fail("truncated header");
+    std::memcpy(&head, file.data(), sizeof(head));
+    if (head.magic != TILE_PYRAMID_MAGIC || head.version != TILE_PYRAMID_VERSION) return fail("not a version 1 tile pyramid");
+    if (head.tileSize == 0 || head.levelCount == 0 || head.levelCount > 32 || head.worldScale <= 0.f) return fail("bad header");
+
+    size_t offset = sizeof(TilePyramidHeader);
+    if (file.size() < offset + head.levelCount * sizeof(TilePyramidLevel)) return fail("truncated level table");
+    levels.resize(head.levelCount);
+    std::memcpy(levels.data(), file.data() + offset, head.levelCount * sizeof(TilePyramidLevel));
+    offset += head.levelCount * sizeof(TilePyramidLevel);
+
+    uint64_t tileCount = 0;
+    for (const auto& level : levels) {
+        if (level.firstTile != tileCount || level.columns >= (1u << 28) || level.rows >= (1u << 28)) return fail("bad level table");
+        tileCount += static_cast<uint64_t>(level.columns) * level.rows;
+    }
+    if (file.size() < offset + tileCount * sizeof(TilePyramidEntry)) return fail("truncated tile table");
+    entries = reinterpret_cast<const TilePyramidEntry*>(file.data() + offset);
+    for (uint64_t i = 0; i < tileCount; i++) {
+        if (entries[i].offset + entries[i].size > file.size()) return fail("tile outside the file");
+    }
+    return true;
+}
+
+float TilePyramid::tileWorldSize(size_t level) const {
+    return static_cast<float>(head.tileSize) * static_cast<float>(1u << level) * head.worldScale;
+}
+
+sf::FloatRect TilePyramid::worldBounds() const {
+    return sf::FloatRect(head.originX, head.originY, head.width * head.worldScale, head.height * head.worldScale);
+}
+
+const uint8_t* TilePyramid::tileData(size_t level, uint32_t column, uint32_t row, size_t& size) const {
+    const TilePyramidEntry& entry = entries[levels[level].firstTile + row * levels[level].columns + column];
+    size = entry.size;
+    return entry.size ? file.data() + entry.offset : nullptr;
+}
+
+// -------------------- Streaming --------------------
+SceneryStreamer::SceneryStreamer(size_t cacheTiles, unsigned count)
+    : slots(std::max<size_t>(8, cacheTiles)), workerCount(std::max(1u, count)) {
+}
+
+SceneryStreamer::~SceneryStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+bool SceneryStreamer::open(const std::string& path) {
+    if (!workers.empty() || !pyramid.open(path)) return false;
+    for (unsigned i = 0; i < workerCount; i++) {
+        workers.emplace_back(&SceneryStreamer::workerLoop, this);
+    }
+    const TilePyramidHeader& header = pyramid.header();
+    std::cout << "Scenery: " << header.width << "x" << header.height << " px in " << pyramid.levelCount()
+              << " levels, " << slots.size() << " cached tiles of " << header.tileSize << " px\n";
+    return true;
+}
+
+void SceneryStreamer::workerLoop() {
+    const unsigned tileSize = pyramid.header().tileSize;
+    const bool png = pyramid.header().encoding == static_cast<uint16_t>(TileEncoding::Png);
+
+    for (;;) {
+        uint64_t key;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || !requests.empty(); });
+            if (stopping) return;
+            key = requests.front();
+            requests.pop_front();
+            decoding.insert(key);
+        }
+
+        // Reading the payload is what faults the mapped pages in, so it stays off the main thread too
+        DecodedTile tile{key, true, sf::Image()};
+        size_t size = 0;
+        const uint8_t* data = pyramid.tileData(keyLevel(key), keyColumn(key), keyRow(key), size);
+        if (data && png) {
+            tile.empty = !tile.image.loadFromMemory(data, size);
+        } else if (data && size == static_cast<size_t>(tileSize) * tileSize * 4) {
+            tile.image.create(tileSize, tileSize, data);
+            tile.empty = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            decoding.erase(key);
+            finished.push_back(std::move(tile));
+        }
+    }
+}
+
+// Level whose texels are closest to one screen pixel, coarsened until the tiles
+// the view needs fit comfortably in the cache
+size_t SceneryStreamer::chooseLevel(const sf::View& view, sf::Vector2u windowSize) const {
+    const size_t top = pyramid.levelCount() - 1;
+    float unitsPerPixel = view.getSize().x / std::max(1u, windowSize.x);
+    float texelsPerPixel = unitsPerPixel / pyramid.header().worldScale;
+    size_t level = texelsPerPixel > 1.f ? static_cast<size_t>(std::log2(texelsPerPixel)) : 0;
+    level = std::min(level, top);
+
+    for (; level < top; level++) {
+        float tile = pyramid.tileWorldSize(level);
+        float across = std::ceil(view.getSize().x / tile) + 1 + 2 * PREFETCH_TILES;
+        float down = std::ceil(view.getSize().y / tile) + 1 + 2 * PREFETCH_TILES;
+        if (across * down <= slots.size() / 2) break;
+    }
+    return level;
+}
+
+// Tiles of one level overlapping an area, nearest to the centre first
+void SceneryStreamer::collectTiles(size_t level, const sf::FloatRect& area, sf::Vector2f centre, std::vector<uint64_t>& keys) const {
+    keys.clear();
+    const TilePyramidLevel& info = pyramid.level(level);
+    const float tile = pyramid.tileWorldSize(level);
+    const float left = (area.left - pyramid.header().originX) / tile;
+    const float top = (area.top - pyramid.header().originY) / tile;
+
+    int c0 = std::max(0, static_cast<int>(std::floor(left)));
+    int r0 = std::max(0, static_cast<int>(std::floor(top)));
+    int c1 = std::min(static_cast<int>(info.columns) - 1, static_cast<int>(std::floor(left + area.width / tile)));
+    int r1 = std::min(static_cast<int>(info.rows) - 1, static_cast<int>(std::floor(top + area.height / tile)));
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            keys.push_back(tileKey(level, c, r));
+        }
+    }
+
+    auto distanceToCentre = [&](uint64_t key) {
+        float dx = pyramid.header().originX + (keyColumn(key) + 0.5f) * tile - centre.x;
+        float dy = pyramid.header().originY + (keyRow(key) + 0.5f) * tile - centre.y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(keys.begin(), keys.end(), [&](uint64_t a, uint64_t b) { return distanceToCentre(a) < distanceToCentre(b); });
+}
+
+void SceneryStreamer::update(const sf::View& view, sf::Vector2u windowSize) {
+    if (!isOpen()) return;
+    frame++;
+
+    // Tiles this frame wants: the coarsest level as a backdrop, the chosen level with a prefetch ring
+    const size_t level = chooseLevel(view, windowSize);
+    const size_t top = pyramid.levelCount() - 1;
+    const sf::Vector2f centre = view.getCenter(), size = view.getSize();
+    const float margin = PREFETCH_TILES * pyramid.tileWorldSize(level);
+    collectTiles(level, sf::FloatRect(centre.x - size.x / 2 - margin, centre.y - size.y / 2 - margin,
+                                      size.x + 2 * margin, size.y + 2 * margin), centre, visibleFine);
+    visibleCoarse.clear();
+    if (level != top) {
+        collectTiles(top, sf::FloatRect(centre - size / 2.f, size), centre, visibleCoarse);
+    }
+
+    std::vector<uint64_t> wanted(visibleCoarse);
+    wanted.insert(wanted.end(), visibleFine.begin(), visibleFine.end());
+    for (uint64_t key : wanted) {
+        auto it = resident.find(key);
+        if (it != resident.end()) slots[it->second].lastUsed = frame;
+    }
+
+    // Upload finished decodes that are still wanted; anything else is dropped
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& tile : finished) uploads.push_back(std::move(tile));
+        finished.clear();
+    }
+    std::unordered_set<uint64_t> wantedSet(wanted.begin(), wanted.end());
+    uploads.erase(std::remove_if(uploads.begin(), uploads.end(),
+                                 [&](const DecodedTile& tile) { return !wantedSet.count(tile.key) || resident.count(tile.key); }),
+                  uploads.end());
+    size_t uploadCount = std::min(uploads.size(), MAX_UPLOADS_PER_FRAME);
+    for (size_t i = 0; i < uploadCount; i++) upload(uploads[i]);
+    uploads.erase(uploads.begin(), uploads.begin() + uploadCount);
+
+    // Everything still missing replaces the old request queue, nearest first
+    std::unordered_set<uint64_t> waiting;
+    for (const auto& tile : uploads) waiting.insert(tile.key);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.clear();
+        for (uint64_t key : wanted) {
+            if (!resident.count(key) && !waiting.count(key) && !decoding.count(key)) requests.push_back(key);
+        }
+    }
+    wake.notify_all();
+}
+
+// Recycles the least recently used texture that is not needed this frame
+void SceneryStreamer::upload(DecodedTile& tile) {
+    size_t victim = slots.size();
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (slots[i].lastUsed < frame && (victim == slots.size() || slots[i].lastUsed < slots[victim].lastUsed)) {
+            victim = i;
+        }
+    }
+    if (victim == slots.size()) return; // every texture is on screen
+
+    TileSlot& slot = slots[victim];
+    resident.erase(slot.key);
+    slot.key = tile.key;
+    slot.lastUsed = frame;
+    slot.empty = tile.empty;
+    if (!tile.empty) {
+        if (!slot.created) {
+            const unsigned tileSize = pyramid.header().tileSize;
+            slot.created = slot.texture.create(tileSize, tileSize);
+            slot.texture.setSmooth(true);
+            if (slot.created) textureMemory.set(textureMemory.bytes() + size_t(4) * tileSize * tileSize);
+        }
+        slot.texture.update(tile.image);
+    }
+    resident[tile.key] = victim;
+}
+
+void SceneryStreamer::drawTile(sf::RenderTarget& target, uint64_t key) const {
+    auto it = resident.find(key);
+    if (it == resident.end() || slots[it->second].empty) return;
+
+    const size_t level = keyLevel(key);
+    const float tile = pyramid.tileWorldSize(level);
+    sf::Sprite sprite(slots[it->second].texture);
+    sprite.setPosition(pyramid.header().originX + keyColumn(key) * tile, pyramid.header().originY + keyRow(key) * tile);
+    sprite.setScale(tile / pyramid.header().tileSize, tile / pyramid.header().tileSize);
+    target.draw(sprite);
+}
+
+void SceneryStreamer::draw(sf::RenderTarget& target) const {
+    for (uint64_t key : visibleCoarse) drawTile(target, key);
+    for (uint64_t key : visibleFine) drawTile(target, key);
+}
@@ -0,0 +1,158 @@
+/******************************************************
+ *  Scenery - tiled background streamed from a memory-mapped pyramid
+ ******************************************************/
+#pragma once
+
+#include "mapped_file.hpp"
+#include "memory_budget.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// -------------------- Tile Pyramid File --------------------
+// [header][level table][tile table][tile payloads]. Level 0 is full resolution and
+// every level above halves it, down to a level that fits in a single tile. Tiles
+// are always tileSize x tileSize; edge tiles are padded with transparent pixels.
+// All fields little-endian.
+
+enum class TileEncoding : uint16_t {
+    Rgba = 0, // raw 8-bit RGBA, decoding is a copy
+    Png = 1,  // PNG, smaller files, decoded on the worker threads
+};
+
+struct TilePyramidHeader {
+    uint32_t magic;      // TILE_PYRAMID_MAGIC
+    uint16_t version;    // TILE_PYRAMID_VERSION
+    uint16_t encoding;   // TileEncoding
+    uint32_t tileSize;   // pixels per tile side
+    uint32_t levelCount;
+    uint32_t width;      // level 0 size in pixels
+    uint32_t height;
+    float    originX;    // world position of level 0 pixel (0, 0)
+    float    originY;
+    float    worldScale; // world units per level 0 pixel
+    uint32_t reserved;
+};
+static_assert(sizeof(TilePyramidHeader) == 40, "TilePyramidHeader layout is part of the file format");
+
+struct TilePyramidLevel {
+    uint32_t columns;
+    uint32_t rows;
+    uint32_t firstTile; // index of this level's (0, 0) tile in the tile table, row-major
+    uint32_t reserved;
+};
+static_assert(sizeof(TilePyramidLevel) == 16, "TilePyramidLevel layout is part of the file format");
+
+struct TilePyramidEntry {
+    uint64_t offset; // from the start of the file
+    uint32_t size;   // 0 = fully transparent tile, nothing stored
+    uint32_t reserved;
+};
+static_assert(sizeof(TilePyramidEntry) == 16, "TilePyramidEntry layout is part of the file format");
+
+static const uint32_t TILE_PYRAMID_MAGIC = 0x50545253; // "SRTP"
+static const uint16_t TILE_PYRAMID_VERSION = 1;
+
+// Builds a pyramid from one big image (offline, see mktiles.cpp)
+bool writeTilePyramid(const sf::Image& image, const std::string& path, unsigned tileSize,
+                      TileEncoding encoding, sf::Vector2f origin, float worldScale);
+
+// Read-only view of a pyramid file. Tile payloads are never copied up front;
+// they are read straight out of the mapping when a tile is decoded.
+class TilePyramid {
+public:
+    bool open(const std::string& path);
+
+    bool isOpen() const { return file.isOpen(); }
+    const TilePyramidHeader& header() const { return head; }
+    size_t levelCount() const { return levels.size(); }
+    const TilePyramidLevel& level(size_t index) const { return levels[index]; }
+
+    // World size covered by one tile at the given level
+    float tileWorldSize(size_t level) const;
+    sf::FloatRect worldBounds() const;
+
+    // Payload of a tile, nullptr with size 0 for empty tiles
+    const uint8_t* tileData(size_t level, uint32_t column, uint32_t row, size_t& size) const;
+
+private:
+    MappedFile file;
+    TilePyramidHeader head = {};
+    std::vector<TilePyramidLevel> levels;
+    const TilePyramidEntry* entries = nullptr;
+};
+
+// -------------------- Streaming --------------------
+// Keeps the tiles around the camera resident in a fixed number of GPU textures.
+// Missing tiles are decoded on worker threads, uploaded on the main thread and the
+// least recently used texture is recycled for them. The request queue, in-flight
+// decodes and texture cache are all bounded by the cache size, so memory use does
+// not depend on how big the map is.
+class SceneryStreamer {
+public:
+    explicit SceneryStreamer(size_t cacheTiles = 96, unsigned workerCount = 2);
+    ~SceneryStreamer();
+    SceneryStreamer(const SceneryStreamer&) = delete;
+    SceneryStreamer& operator=(const SceneryStreamer&) = delete;
+
+    bool open(const std::string& path);
+    bool isOpen() const { return pyramid.isOpen(); }
+    sf::FloatRect worldBounds() const { return pyramid.worldBounds(); }
+
+    // Main thread, once per frame: uploads finished tiles and requests the ones the
+    // view needs next
+    void update(const sf::View& view, sf::Vector2u windowSize);
+
+    // Draws the resident tiles under the view passed to the last update()
+    void draw(sf::RenderTarget& target) const;
+
+    size_t residentTiles() const { return resident.size(); }
+    size_t cacheCapacity() const { return slots.size(); }
+
+private:
+    struct TileSlot {
+        uint64_t key = ~0ull; // none
+        uint64_t lastUsed = 0;
+        bool empty = false;   // transparent tile, nothing to draw
+        bool created = false; // texture storage allocated
+        sf::Texture texture;
+    };
+    struct DecodedTile {
+        uint64_t key;
+        bool empty;
+        sf::Image image;
+    };
+
+    void workerLoop();
+    size_t chooseLevel(const sf::View& view, sf::Vector2u windowSize) const;
+    void collectTiles(size_t level, const sf::FloatRect& area, sf::Vector2f centre, std::vector<uint64_t>& keys) const;
+    void upload(DecodedTile& tile);
+    void drawTile(sf::RenderTarget& target, uint64_t key) const;
+
+    TilePyramid pyramid;
+    std::vector<TileSlot> slots;
+    std::unordered_map<uint64_t, size_t> resident; // key -> slot
+    std::vector<uint64_t> visibleCoarse, visibleFine;
+    std::vector<DecodedTile> uploads;              // decoded, waiting for a texture
+    uint64_t frame = 0;
+    MemoryCharge textureMemory{MemoryTag::Textures}; // texture storage created so far
+
+    // Shared with the workers
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<uint64_t> requests;
+    std::unordered_set<uint64_t> decoding;
+    std::vector<DecodedTile> finished;
+    bool stopping = false;
+    unsigned workerCount;
+    std::vector<std::thread> workers;
+};
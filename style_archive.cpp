@@ -0,0 +1,238 @@
+/******************************************************
+ *  Style Archive - MAP-Elites search for a roster of distinct racing lines
+ ******************************************************/
+
+#include "style_archive.hpp"
+#include "artifact.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+static const float STYLE_SAMPLE_STEP = 10.0f; // pixels of line between descriptor samples
+
+// -------------------- Behaviour Descriptors --------------------
+// +1 if the centreline winds so that the inside of the loop is on the left of travel
+// (positive cross product), -1 otherwise
+static float windingSign(const std::vector<sf::Vector2f>& c) {
+    float area = 0.f;
+    for (size_t i = 0; i < c.size(); i++) {
+        const sf::Vector2f& a = c[i];
+        const sf::Vector2f& b = c[(i + 1) % c.size()];
+        area += a.x * b.y - b.x * a.y;
+    }
+    return area >= 0.f ? 1.f : -1.f;
+}
+
+// Signed offset of p from the nearest centreline segment, positive towards the inside
+// of the loop; inward receives the unit direction that counts as positive
+static float inwardOffset(const std::vector<sf::Vector2f>& c, float winding, sf::Vector2f p, sf::Vector2f* inward = nullptr) {
+    float bestDistSq = -1.f, offset = 0.f;
+    for (size_t i = 0; i + 1 < c.size(); i++) {
+        sf::Vector2f d = c[i + 1] - c[i];
+        float lenSq = d.x * d.x + d.y * d.y;
+        if (lenSq <= 0.f) continue;
+        float t = std::clamp(((p.x - c[i].x) * d.x + (p.y - c[i].y) * d.y) / lenSq, 0.f, 1.f);
+        sf::Vector2f r = p - (c[i] + d * t);
+        float distSq = r.x * r.x + r.y * r.y;
+        if (bestDistSq < 0.f || distSq < bestDistSq) {
+            bestDistSq = distSq;
+            float len = std::sqrt(lenSq);
+            sf::Vector2f left(-d.y / len, d.x / len);
+            offset = winding * (r.x * left.x + r.y * left.y);
+            if (inward) *inward = left * winding;
+        }
+    }
+    return offset;
+}
+
+float lineInnerDistance(const std::vector<sf::Vector2f>& line, const TrackLayout& layout) {
+    const std::vector<sf::Vector2f>& c = layout.centreline;
+    if (line.empty() || c.size() < 2) return layout.wallOffset;
+    const float winding = windingSign(c);
+    const float maxDistance = 2.f * layout.wallOffset;
+    auto innerDistance = [&](sf::Vector2f p) {
+        return std::clamp(layout.wallOffset - inwardOffset(c, winding, p), 0.f, maxDistance);
+    };
+
+    // Samples sit every STYLE_SAMPLE_STEP pixels of line, carrying the remainder across
+    // waypoints, so the mean is per pixel driven rather than per waypoint
+    double sum = innerDistance(line[0]);
+    size_t samples = 1;
+    float carried = 0.f;
+    for (size_t i = 0; i + 1 < line.size(); i++) {
+        sf::Vector2f d = line[i + 1] - line[i];
+        float len = std::sqrt(d.x * d.x + d.y * d.y);
+        float s = STYLE_SAMPLE_STEP - carried;
+        for (; s <= len; s += STYLE_SAMPLE_STEP) {
+            sum += innerDistance(line[i] + d * (s / len));
+            samples++;
+        }
+        carried = len - (s - STYLE_SAMPLE_STEP);
+    }
+    return static_cast<float>(sum / samples);
+}
+
+// -------------------- Archive --------------------
+StyleArchive::StyleArchive(const StyleSettings& settings, float maxInnerDistance)
+    : distanceBins(std::max<size_t>(1, settings.distanceBins)),
+      collisionBins(std::max<size_t>(1, settings.collisionBins)),
+      maxInnerDistance(maxInnerDistance) {
+    cells.resize(distanceBins * collisionBins);
+    occupiedFlags.resize(cells.size(), false);
+    memory.set(vectorBytes(cells));
+}
+
+size_t StyleArchive::cellIndex(float innerDistance, int collisions) const {
+    float t = maxInnerDistance > 0.f ? innerDistance / maxInnerDistance : 0.f;
+    size_t d = std::min(distanceBins - 1, static_cast<size_t>(std::max(0.f, t) * distanceBins));
+    size_t k = std::min(collisionBins - 1, static_cast<size_t>(std::max(0, collisions)));
+    return d * collisionBins + k;
+}
+
+bool StyleArchive::insert(StyleElite elite) {
+    size_t cell = cellIndex(elite.innerDistance, elite.collisions);
+    if (occupiedFlags[cell] && cells[cell].fitness <= elite.fitness) return false;
+    if (!occupiedFlags[cell]) filled++;
+    occupiedFlags[cell] = true;
+    memory.set(memory.bytes() - vectorBytes(cells[cell].waypoints) + vectorBytes(elite.waypoints));
+    cells[cell] = std::move(elite);
+    return true;
+}
+
+std::vector<StyleElite> StyleArchive::roster(size_t count, float slack) const {
+    std::vector<StyleElite> bands;
+    for (size_t d = 0; d < distanceBins; d++) {
+        // Clean laps only live in the first collision bin
+        const size_t cell = d * collisionBins;
+        if (occupiedFlags[cell] && cells[cell].collisions == 0 && cells[cell].fitness < MAX_SIM_TIME) bands.push_back(cells[cell]);
+    }
+    std::sort(bands.begin(), bands.end(), [](const StyleElite& a, const StyleElite& b) { return a.fitness < b.fitness; });
+    size_t keep = 0;
+    while (keep < bands.size() && keep < count && bands[keep].fitness <= bands.front().fitness * slack) keep++;
+    bands.resize(keep);
+    return bands;
+}
+
+// -------------------- Search --------------------
+StyleArchive searchRacingStyles(const TrackLayout& layout, WorkPool& pool, const StyleSettings& settings, bool verbose) {
+    Track track;
+    track.build(layout);
+    BorderGrid grid;
+    grid.build(borderBoxes(track.borders()));
+
+    StyleArchive archive(settings, 2.f * layout.wallOffset);
+    const size_t batchSize = std::max<size_t>(1, settings.batchSize);
+    std::vector<StyleElite> batch(batchSize);
+    const int group = pool.addGroup("styles " + layout.name);
+    auto evaluateBatch = [&] {
+        pool.parallelFor(group, batch.size(), [&](size_t i) {
+            StyleElite& child = batch[i];
+            child.fitness = simulateRun(child.waypoints, grid, settings.aiSpeed, &child.collisions);
+            child.innerDistance = lineInnerDistance(child.waypoints, layout);
+        });
+        size_t kept = 0;
+        for (auto& child : batch) kept += archive.insert(child);
+        return kept;
+    };
+
+    // Seeds: the initial line shifted bodily across the track, one shift per child
+    std::mt19937 rng(std::random_device{}());
+    std::normal_distribution<float> gauss(0.f, 1.f);
+    const std::vector<sf::Vector2f>& c = layout.centreline;
+    const float winding = windingSign(c);
+    std::vector<sf::Vector2f> inward(layout.initialLine.size());
+    for (size_t w = 0; w < inward.size(); w++) inwardOffset(c, winding, layout.initialLine[w], &inward[w]);
+    for (size_t i = 0; i < batchSize; i++) {
+        float shift = layout.wallOffset * (batchSize > 1 ? 2.f * i / (batchSize - 1) - 1.f : 0.f);
+        batch[i].waypoints = layout.initialLine;
+        for (size_t w = 0; w < inward.size(); w++) {
+            batch[i].waypoints[w] += inward[w] * shift + sf::Vector2f(gauss(rng), gauss(rng)) * settings.isoSigma;
+        }
+    }
+    evaluateBatch();
+
+    std::vector<size_t> elites;
+    for (int b = 1; b <= settings.batches; b++) {
+        elites.clear();
+        for (size_t cell = 0; cell < archive.cellCount(); cell++) {
+            if (archive.occupied(cell)) elites.push_back(cell);
+        }
+        std::uniform_int_distribution<size_t> pick(0, elites.size() - 1);
+
+        // iso+line variation: Gaussian noise around one elite plus a shared random step
+        // along the difference to another
+        for (auto& child : batch) {
+            const auto& parent = archive.elite(elites[pick(rng)]).waypoints;
+            const auto& other = archive.elite(elites[pick(rng)]).waypoints;
+            float along = settings.lineSigma * gauss(rng);
+            child.waypoints = parent;
+            for (size_t w = 0; w < parent.size(); w++) {
+                child.waypoints[w] += sf::Vector2f(gauss(rng), gauss(rng)) * settings.isoSigma + (other[w] - parent[w]) * along;
+            }
+        }
+        size_t kept = evaluateBatch();
+
+        if (verbose && (b % 10 == 0 || b == settings.batches)) {
+            float best = 0.f;
+            bool any = false;
+            for (size_t cell = 0; cell < archive.cellCount(); cell++) {
+                if (archive.occupied(cell) && (!any || archive.elite(cell).fitness < best)) best = archive.elite(cell).fitness;
+                any = any || archive.occupied(cell);
+            }
+            std::cout << "Styles " << layout.name << " batch " << b << "/" << settings.batches << ": " << archive.filledCount()
+                      << "/" << archive.cellCount() << " cells, best " << best << ", " << kept << " kept this batch\n";
+        }
+    }
+    return archive;
+}
+
+// -------------------- Rosters on Disk --------------------
+std::string racingStyleFileName(const std::string& trackName, size_t index) {
+    std::string file = racingLineFileName(trackName);
+    return file.substr(0, file.size() - 4) + ".style" + std::to_string(index) + ".sra";
+}
+
+size_t exportStyleRoster(const TrackLayout& layout, const std::vector<StyleElite>& roster, const std::string& directory,
+                         AsyncWriter* writer) {
+    const uint64_t hash = trackLayoutHash(layout);
+    size_t written = 0;
+    for (size_t k = 0; k < roster.size(); k++) {
+        if (writeRacingLineArtifact(directory + "/" + racingStyleFileName(layout.name, k), hash, roster[k].waypoints, roster[k].fitness,
+                                    writer)) {
+            written++;
+        }
+    }
+    // A stale style after the new ones would otherwise be loaded as part of this roster
+    size_t stale = roster.size();
+    while (std::remove((directory + "/" + racingStyleFileName(layout.name, stale)).c_str()) == 0) stale++;
+    return written;
+}
+
+bool loadStyleRoster(const TrackLayout& layout, const std::string& directory, std::vector<std::vector<sf::Vector2f>>& lines) {
+    lines.clear();
+    const uint64_t hash = trackLayoutHash(layout);
+    for (size_t k = 0;; k++) {
+        const std::string path = directory + "/" + racingStyleFileName(layout.name, k);
+        std::ifstream probe(path);
+        if (!probe) break; // end of the roster
+        probe.close();
+
+        Artifact artifact;
+        std::vector<sf::Vector2f> line;
+        if (!artifact.open(path) || artifact.kind() != ArtifactKind::RacingLine || artifact.header().trackHash != hash ||
+            !artifact.racingLine(line)) {
+            std::cerr << "Ignoring " << path << ": not a racing line for this layout\n";
+            continue;
+        }
+        if (artifact.header().fitness >= MAX_SIM_TIME) {
+            std::cerr << "Ignoring " << path << ": its line never finishes a lap\n";
+            continue;
+        }
+        lines.push_back(std::move(line));
+    }
+    return !lines.empty();
+}
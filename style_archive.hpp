@@ -0,0 +1,92 @@
+/******************************************************
+ *  Style Archive - MAP-Elites search for a roster of distinct racing lines
+ ******************************************************/
+#pragma once
+
+#include "optimizer.hpp"
+#include "track.hpp"
+#include "work_pool.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class AsyncWriter;
+
+// -------------------- Behaviour Descriptors --------------------
+// Mean distance from the line to the inner wall, sampled every few pixels along the
+// line so dense stretches of waypoints don't count for more. 0 hugs the inside of every
+// corner, 2 * wallOffset runs along the outside wall. "Inner" is the side facing the
+// inside of the loop, whichever way the centreline winds.
+float lineInnerDistance(const std::vector<sf::Vector2f>& line, const TrackLayout& layout);
+
+struct StyleSettings {
+    size_t distanceBins = 12;  // across [0, 2 * wallOffset]
+    size_t collisionBins = 4;  // 0, 1, 2, 3 or more collisions
+    size_t batchSize = 32;     // offspring per batch, evaluated in parallel
+    int batches = 80;
+    float aiSpeed = 3.0f;
+    float isoSigma = 8.0f;     // per-waypoint Gaussian noise, pixels
+    float lineSigma = 0.3f;    // step along the direction to another elite
+    size_t rosterSize = 6;
+    float rosterSlack = 1.15f; // roster lines are at most this much slower than the fastest
+};
+
+struct StyleElite {
+    std::vector<sf::Vector2f> waypoints;
+    float fitness = 0.f;       // simulateRun, lower is better
+    float innerDistance = 0.f;
+    int collisions = 0;
+};
+
+// -------------------- Archive --------------------
+// A grid over the two descriptors holding the fastest line found in each cell. The grid
+// is its own spatial index: a descriptor maps straight to its cell, so insertion is O(1)
+// however many elites the archive holds.
+class StyleArchive {
+public:
+    StyleArchive(const StyleSettings& settings, float maxInnerDistance);
+
+    // Keeps elite if its cell is empty or holds a slower line; true if it was kept
+    bool insert(StyleElite elite);
+
+    size_t cellIndex(float innerDistance, int collisions) const;
+    size_t cellCount() const { return cells.size(); }
+    size_t filledCount() const { return filled; }
+    bool occupied(size_t cell) const { return occupiedFlags[cell]; }
+    const StyleElite& elite(size_t cell) const { return cells[cell]; }
+
+    // Up to count fast and distinct lines: the fastest line of each distance band, fastest
+    // first, leaving out any band whose best is more than slack times the overall best.
+    // Only lines that finish without a collision are raced, so this may come back empty.
+    std::vector<StyleElite> roster(size_t count, float slack) const;
+
+private:
+    std::vector<StyleElite> cells; // [distance bin * collisionBins + collision bin]
+    std::vector<bool> occupiedFlags;
+    size_t distanceBins, collisionBins;
+    float maxInnerDistance;
+    size_t filled = 0;
+    MemoryCharge memory{MemoryTag::Population}; // cells and the elites' waypoints
+};
+
+// -------------------- Search --------------------
+// Seeds the archive with the layout's initial line shifted across the track, then runs
+// batches of offspring on the pool. Each child comes from a random elite, with Gaussian
+// noise plus a random step towards another elite (iso+line variation), so lines
+// between two known styles get tried as well as lines near one.
+StyleArchive searchRacingStyles(const TrackLayout& layout, WorkPool& pool, const StyleSettings& settings, bool verbose = true);
+
+// -------------------- Rosters on Disk --------------------
+// Style k of a track lives in DIR/<track>.style<k>.sra, e.g. "l-shape.style0.sra"
+std::string racingStyleFileName(const std::string& trackName, size_t index);
+
+// Writes the roster as racing line artifacts, through writer if given, removing any
+// higher-numbered styles left over from an earlier, larger roster. Returns how many
+// were written (handed to the writer).
+size_t exportStyleRoster(const TrackLayout& layout, const std::vector<StyleElite>& roster, const std::string& directory,
+                         AsyncWriter* writer = nullptr);
+
+// Every exported style for exactly this layout that finishes a lap; false if there are none
+bool loadStyleRoster(const TrackLayout& layout, const std::string& directory, std::vector<std::vector<sf::Vector2f>>& lines);
@@ -0,0 +1,118 @@
+/******************************************************
+ *  Telemetry - live car state streamed over local UDP
+ ******************************************************/
+
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Stay under a typical MTU so datagrams are never fragmented
+static const size_t TELEMETRY_MAX_DATAGRAM = 1400;
+static const size_t TELEMETRY_RECORDS_PER_DATAGRAM =
+    (TELEMETRY_MAX_DATAGRAM - sizeof(TelemetryHeader)) / sizeof(TelemetryRecord);
+
+TelemetrySender::TelemetrySender(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    ring.resize(size);
+    mask = size - 1;
+    datagram.resize(TELEMETRY_MAX_DATAGRAM);
+}
+
+TelemetrySender::~TelemetrySender() {
+    stop();
+}
+
+bool TelemetrySender::start(const std::string& host, unsigned short destPort, float rateHz) {
+    if (running()) return true;
+
+    address = sf::IpAddress(host);
+    if (address == sf::IpAddress::None) {
+        std::cerr << "Telemetry: unknown host " << host << "\n";
+        return false;
+    }
+    port = destPort;
+    interval = 1.f / std::max(1.f, rateHz);
+
+    active = true;
+    worker = std::thread(&TelemetrySender::run, this);
+    std::cout << "Telemetry: streaming to " << host << ":" << port << " at " << rateHz << " Hz\n";
+    return true;
+}
+
+void TelemetrySender::stop() {
+    if (!active.exchange(false)) return;
+    if (worker.joinable()) worker.join();
+    flush();
+}
+
+bool TelemetrySender::push(const TelemetryRecord& record) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) > mask) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    ring[h & mask] = record;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+void TelemetrySender::run() {
+    auto next = std::chrono::steady_clock::now();
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<float>(interval));
+
+    while (active.load(std::memory_order_relaxed)) {
+        next += period;
+        std::this_thread::sleep_until(next);
+        flush();
+    }
+}
+
+// Drains everything queued so far into as few datagrams as possible
+void TelemetrySender::flush() {
+    size_t t = tail.load(std::memory_order_relaxed);
+    const size_t h = head.load(std::memory_order_acquire);
+
+    while (t != h) {
+        size_t count = std::min(h - t, TELEMETRY_RECORDS_PER_DATAGRAM);
+
+        TelemetryHeader header;
+        header.magic = TELEMETRY_MAGIC;
+        header.version = TELEMETRY_VERSION;
+        header.count = static_cast<uint16_t>(count);
+        header.sequence = sequence++;
+        header.dropped = static_cast<uint32_t>(dropped());
+
+        char* out = datagram.data();
+        std::memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        for (size_t i = 0; i < count; i++, out += sizeof(TelemetryRecord)) {
+            std::memcpy(out, &ring[(t + i) & mask], sizeof(TelemetryRecord));
+        }
+
+        t += count;
+        tail.store(t, std::memory_order_release);
+
+        // Nobody listening is fine: UDP errors are ignored so the game never notices
+        socket.send(datagram.data(), static_cast<size_t>(out - datagram.data()), address, port);
+    }
+}
+
+bool parseHostPort(const std::string& spec, std::string& host, unsigned short& port) {
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos) return false;
+
+    host = colon == 0 ? "127.0.0.1" : spec.substr(0, colon);
+    try {
+        int value = std::stoi(spec.substr(colon + 1));
+        if (value <= 0 || value > 65535) return false;
+        port = static_cast<unsigned short>(value);
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+/******************************************************
+ *  Telemetry - live car state streamed over local UDP
+ ******************************************************/
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Fixed-layout record, sent as-is (little-endian on every platform we ship)
+struct TelemetryRecord {
+    uint32_t frame;
+    uint8_t  car;        // 0 = player, 1 = AI
+    uint8_t  checkpoint; // checkpoints hit so far
+    uint8_t  governorLevel; // frame governor load level (0 = nothing shed)
+    uint8_t  reserved;
+    float    x, y;
+    float    speed;      // pixels per frame
+    float    heading;    // degrees
+    float    simMs;      // previous frame's update time
+    float    renderMs;   // previous frame's draw time
+    float    frameMs;    // previous frame's total time
+    uint32_t memoryKB;   // bytes on every memory tag (memory_budget.hpp), in KB
+};
+static_assert(sizeof(TelemetryRecord) == 40, "TelemetryRecord layout is part of the wire format");
+
+// Every datagram starts with this header, followed by `count` records
+struct TelemetryHeader {
+    uint32_t magic;    // TELEMETRY_MAGIC
+    uint16_t version;  // TELEMETRY_VERSION
+    uint16_t count;
+    uint32_t sequence; // datagram counter, lets listeners detect loss
+    uint32_t dropped;  // records dropped so far because the queue was full
+};
+static_assert(sizeof(TelemetryHeader) == 16, "TelemetryHeader layout is part of the wire format");
+
+static const uint32_t TELEMETRY_MAGIC = 0x4C545253; // "SRTL"
+static const uint16_t TELEMETRY_VERSION = 2;
+
+// Game thread pushes records into a single-producer/single-consumer ring; a sender
+// thread drains it at a fixed rate and packs the records into datagrams.
+// push() never blocks or allocates: a full ring just drops the record.
+class TelemetrySender {
+public:
+    explicit TelemetrySender(size_t capacity = 4096);
+    ~TelemetrySender();
+
+    bool start(const std::string& host, unsigned short port, float rateHz);
+    void stop();
+    bool running() const { return active.load(std::memory_order_relaxed); }
+
+    bool push(const TelemetryRecord& record);
+    uint64_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void flush();
+
+    std::vector<TelemetryRecord> ring;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0}; // written by the game thread
+    alignas(64) std::atomic<size_t> tail{0}; // written by the sender thread
+    alignas(64) std::atomic<uint64_t> droppedCount{0};
+
+    std::atomic<bool> active{false};
+    std::thread worker;
+    sf::UdpSocket socket;
+    sf::IpAddress address;
+    unsigned short port = 0;
+    float interval = 1.f / 30.f;
+    uint32_t sequence = 0;
+    std::vector<char> datagram;
+};
+
+// Parses "host:port" (host may be omitted: ":9000" means 127.0.0.1)
+bool parseHostPort(const std::string& spec, std::string& host, unsigned short& port);
@@ -0,0 +1,364 @@
+/******************************************************
+ *  Track - geometry, walls and checkpoint gates built from a centreline
+ ******************************************************/
+
+#include "track.hpp"
+#include "baked_tracks.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <limits>
+
+static const float WALL_THICKNESS = 5.f;
+
+struct StdSqrt {
+    float operator()(float x) const { return std::sqrt(x); }
+};
+
+static sf::Vector2f toVector(GeoPoint p) { return sf::Vector2f(p.x, p.y); }
+static GeoPoint toGeo(sf::Vector2f v) { return GeoPoint{v.x, v.y}; }
+
+template <size_t N>
+static std::vector<sf::Vector2f> toVectors(const std::array<GeoPoint, N>& points) {
+    std::vector<sf::Vector2f> result;
+    for (GeoPoint p : points) result.push_back(toVector(p));
+    return result;
+}
+
+// Centreline, checkpoints and wall offset of a baked layout, with its tables attached
+template <const auto& Layout>
+static TrackLayout bakedLayout(const char* name) {
+    TrackLayout layout;
+    layout.name = name;
+    layout.centreline = toVectors(Layout.centreline);
+    layout.checkpoints = toVectors(Layout.checkpoints);
+    layout.width = Layout.width;
+    layout.wallOffset = Layout.wallOffset;
+    layout.baked = &BakedTrack<Layout>::tables;
+    return layout;
+}
+
+TrackLayout defaultTrackLayout() {
+    TrackLayout layout = bakedLayout<RECTANGLE_LAYOUT>("Rectangle");
+    // More detailed than the checkpoints so the AI has something to refine
+    layout.initialLine = {
+        {200, 400}, {300, 400}, {400, 400}, {500, 400}, {600, 400}, {700, 400}, {800, 400},
+        {900, 400}, {900, 350}, {900, 300}, {900, 250}, {900, 200}, {800, 200}, {700, 200},
+        {600, 200}, {500, 200}, {400, 200}, {300, 200}, {200, 200}, {200, 250}, {200, 300},
+        {200, 350}, {200, 400}
+    };
+    return layout;
+}
+
+// Initial AI line for layouts without a hand-written one: the centreline resampled
+// every `spacing` pixels
+static std::vector<sf::Vector2f> resampleLine(const std::vector<sf::Vector2f>& P, float spacing) {
+    std::vector<float> arc(P.size(), 0.f);
+    for (size_t i = 1; i < P.size(); i++) {
+        sf::Vector2f d = P[i] - P[i - 1];
+        arc[i] = arc[i - 1] + std::sqrt(d.x * d.x + d.y * d.y);
+    }
+
+    auto pointAt = [&](float s) {
+        size_t i = 1;
+        while (i + 1 < P.size() && arc[i] < s) i++;
+        float span = arc[i] - arc[i - 1];
+        float t = span > 0.f ? (s - arc[i - 1]) / span : 0.f;
+        return P[i - 1] + (P[i] - P[i - 1]) * t;
+    };
+
+    std::vector<sf::Vector2f> line;
+    for (float s = 0.f; s < arc.back(); s += spacing) line.push_back(pointAt(s));
+    line.push_back(P.back());
+    return line;
+}
+
+std::vector<TrackLayout> builtinTrackLayouts() {
+    std::vector<TrackLayout> layouts;
+    layouts.push_back(defaultTrackLayout());
+
+    TrackLayout hexagon = bakedLayout<HEXAGON_LAYOUT>("Hexagon");
+    hexagon.initialLine = resampleLine(hexagon.centreline, 50.f);
+    layouts.push_back(hexagon);
+
+    TrackLayout lShape = bakedLayout<L_SHAPE_LAYOUT>("L-Shape");
+    lShape.initialLine = resampleLine(lShape.centreline, 50.f);
+    layouts.push_back(lShape);
+
+    return layouts;
+}
+
+bool findBuiltinTrack(const std::string& name, TrackLayout& layout) {
+    auto lower = [](std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+        return text;
+    };
+    for (const auto& candidate : builtinTrackLayouts()) {
+        if (lower(candidate.name) == lower(name)) {
+            layout = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// -------------------- Helpers --------------------
+static sf::Vector2f unitNormal(sf::Vector2f dir) {
+    return toVector(geoUnitNormal(toGeo(dir), StdSqrt{}));
+}
+
+// Thin rotated rectangle (also what collision tests against)
+static sf::RectangleShape makeBorder(const sf::Vector2f& start, float length, float rotation) {
+    sf::RectangleShape border(sf::Vector2f(length, WALL_THICKNESS));
+    border.setPosition(start);
+    border.setFillColor(sf::Color::Red);
+    border.setRotation(rotation);
+    return border;
+}
+
+static sf::RectangleShape makeBorder(const sf::Vector2f& start, const sf::Vector2f& end) {
+    sf::Vector2f diff = end - start;
+    float length = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+    return makeBorder(start, length, std::atan2(diff.y, diff.x) * 180.f / GEO_PI);
+}
+
+// -------------------- Full Build --------------------
+bool Track::closed() const {
+    const auto& c = layout_.centreline;
+    return c.size() > 2 && c.front() == c.back();
+}
+
+void Track::build(const TrackLayout& layout) {
+    layout_ = layout;
+    if (layout_.baked && bakedTablesMatch()) {
+        buildFromBaked();
+        return;
+    }
+    layout_.baked = nullptr;
+
+    const size_t n = layout_.centreline.size();
+    const size_t segments = n > 0 ? n - 1 : 0;
+
+    outerCorners.assign(n, sf::Vector2f());
+    innerCorners.assign(n, sf::Vector2f());
+    for (size_t v = 0; v < n; v++) computeCorner(v);
+
+    quads.assign(segments, sf::ConvexShape());
+    borderShapes.assign(2 * segments, sf::RectangleShape());
+    std::vector<WallSegment> wallSegments;
+    for (size_t s = 0; s < segments; s++) {
+        buildQuad(s, unitNormal(layout_.centreline[s + 1] - layout_.centreline[s]));
+        borderShapes[2 * s]     = makeBorder(outerCorners[s], outerCorners[s + 1]);
+        borderShapes[2 * s + 1] = makeBorder(innerCorners[s], innerCorners[s + 1]);
+        wallSegments.push_back({outerCorners[s], outerCorners[s + 1]});
+        wallSegments.push_back({innerCorners[s], innerCorners[s + 1]});
+    }
+    grid.build(wallSegments, TRACK_WALL_GRID_CELL);
+
+    gates.assign(layout_.checkpoints.size(), sf::RectangleShape());
+    gateSegment.assign(layout_.checkpoints.size(), 0);
+    gateDistance.assign(layout_.checkpoints.size(), 0.f);
+    for (size_t c = 0; c < layout_.checkpoints.size(); c++) buildGate(c);
+    chargeShapes();
+}
+
+// Baked tables are only valid for the exact layout they were computed from
+bool Track::bakedTablesMatch() const {
+    const BakedTrackTables& baked = *layout_.baked;
+    if (baked.vertexCount != layout_.centreline.size() || baked.gateCount != layout_.checkpoints.size() ||
+        baked.wallOffset != layout_.wallOffset) {
+        return false;
+    }
+    for (size_t v = 0; v < baked.vertexCount; v++) {
+        if (!(toGeo(layout_.centreline[v]) == baked.centreline[v])) return false;
+    }
+    for (size_t c = 0; c < baked.gateCount; c++) {
+        if (!(toGeo(layout_.checkpoints[c]) == baked.checkpoints[c])) return false;
+    }
+    return true;
+}
+
+// Same result as the full build, with every derived number read from the tables
+void Track::buildFromBaked() {
+    const BakedTrackTables& baked = *layout_.baked;
+    const size_t n = baked.vertexCount;
+    const size_t segments = n - 1;
+
+    outerCorners.resize(n);
+    innerCorners.resize(n);
+    for (size_t v = 0; v < n; v++) {
+        outerCorners[v] = toVector(baked.outerCorners[v]);
+        innerCorners[v] = toVector(baked.innerCorners[v]);
+    }
+
+    quads.assign(segments, sf::ConvexShape());
+    borderShapes.assign(2 * segments, sf::RectangleShape());
+    std::vector<WallSegment> wallSegments(2 * segments);
+    for (size_t s = 0; s < segments; s++) {
+        buildQuad(s, toVector(baked.normals[s]));
+        borderShapes[2 * s]     = makeBorder(outerCorners[s], baked.walls[2 * s].length, baked.walls[2 * s].rotation);
+        borderShapes[2 * s + 1] = makeBorder(innerCorners[s], baked.walls[2 * s + 1].length, baked.walls[2 * s + 1].rotation);
+        wallSegments[2 * s]     = {outerCorners[s], outerCorners[s + 1]};
+        wallSegments[2 * s + 1] = {innerCorners[s], innerCorners[s + 1]};
+    }
+    grid.assign(wallSegments, TRACK_WALL_GRID_CELL, toVector(baked.gridOrigin), baked.gridColumns, baked.gridRows,
+                baked.cellStart, baked.cellIds);
+
+    gates.assign(baked.gateCount, sf::RectangleShape());
+    gateSegment.assign(baked.gateCount, 0);
+    gateDistance.assign(baked.gateCount, 0.f);
+    for (size_t c = 0; c < baked.gateCount; c++) {
+        gateSegment[c] = baked.gates[c].segment;
+        gateDistance[c] = baked.gates[c].distance;
+        placeGate(c, baked.gates[c].rotation);
+    }
+    chargeShapes();
+}
+
+// Shape objects only; SFML's own vertex arrays inside them aren't visible from here
+void Track::chargeShapes() {
+    shapeMemory.set(vectorBytes(quads) + vectorBytes(borderShapes) + vectorBytes(gates));
+}
+
+// Mitered wall corners at a centreline vertex
+void Track::computeCorner(size_t v) {
+    const auto& P = layout_.centreline;
+    const size_t n = P.size();
+    const bool loop = closed();
+
+    // A closed loop's ends wrap around to the segments on the other side of the seam
+    GeoPoint prev, next;
+    bool hasPrev = true, hasNext = true;
+    if (v > 0) prev = toGeo(P[v - 1]);
+    else if (loop) prev = toGeo(P[n - 2]);
+    else hasPrev = false;
+    if (v + 1 < n) next = toGeo(P[v + 1]);
+    else if (loop) next = toGeo(P[1]);
+    else hasNext = false;
+
+    GeoPoint outer, inner;
+    geoMiterCorner(prev, toGeo(P[v]), next, hasPrev, hasNext, layout_.wallOffset, TRACK_MAX_MITER_SCALE,
+                   StdSqrt{}, outer, inner);
+    outerCorners[v] = toVector(outer);
+    innerCorners[v] = toVector(inner);
+}
+
+void Track::buildQuad(size_t s, sf::Vector2f normal) {
+    sf::Vector2f current = layout_.centreline[s];
+    sf::Vector2f next    = layout_.centreline[s + 1];
+    float half = layout_.width / 2.f;
+
+    // Make a quad for the track segment
+    sf::ConvexShape seg;
+    seg.setPointCount(4);
+    seg.setPoint(0, current + normal * half);
+    seg.setPoint(1, next    + normal * half);
+    seg.setPoint(2, next    - normal * half);
+    seg.setPoint(3, current - normal * half);
+    seg.setFillColor(sf::Color(80, 80, 80));
+    quads[s] = seg;
+}
+
+void Track::buildWalls(size_t s) {
+    borderShapes[2 * s]     = makeBorder(outerCorners[s], outerCorners[s + 1]);
+    borderShapes[2 * s + 1] = makeBorder(innerCorners[s], innerCorners[s + 1]);
+    grid.updateSegment(static_cast<uint32_t>(2 * s),     {outerCorners[s], outerCorners[s + 1]});
+    grid.updateSegment(static_cast<uint32_t>(2 * s + 1), {innerCorners[s], innerCorners[s + 1]});
+}
+
+float Track::gateDistanceTo(size_t c, size_t s) const {
+    return geoPointSegmentDistance(toGeo(layout_.checkpoints[c]), toGeo(layout_.centreline[s]),
+                                   toGeo(layout_.centreline[s + 1]), StdSqrt{});
+}
+
+// Gates lie across the road, perpendicular to the closest centreline segment
+void Track::buildGate(size_t c) {
+    size_t best = 0;
+    float bestDistance = std::numeric_limits<float>::max();
+    for (size_t s = 0; s < segmentCount(); s++) {
+        float d = gateDistanceTo(c, s);
+        if (d < bestDistance) {
+            bestDistance = d;
+            best = s;
+        }
+    }
+    gateSegment[c] = best;
+    gateDistance[c] = bestDistance;
+
+    sf::Vector2f dir = layout_.centreline[best + 1] - layout_.centreline[best];
+    placeGate(c, std::atan2(dir.y, dir.x) * 180.f / GEO_PI + 90.f);
+}
+
+void Track::placeGate(size_t c, float rotation) {
+    sf::RectangleShape cp(sf::Vector2f(layout_.width, 10.f));
+    cp.setOrigin(layout_.width / 2.f, 5.f);
+    cp.setPosition(layout_.checkpoints[c]);
+    cp.setFillColor(sf::Color::Yellow);
+    cp.setRotation(rotation);
+    gates[c] = cp;
+}
+
+// -------------------- Incremental Edits --------------------
+void Track::moveCentrelinePoint(size_t index, sf::Vector2f position, std::vector<uint32_t>* movedBorders) {
+    auto& P = layout_.centreline;
+    const size_t n = P.size();
+    if (index >= n || n < 2) return;
+
+    const bool loop = closed();
+    const size_t unique = loop ? n - 1 : n; // the loop's last point duplicates the first
+    layout_.baked = nullptr; // the tables describe the unedited layout
+    P[index] = position;
+    if (loop && (index == 0 || index == n - 1)) {
+        P[0] = P[n - 1] = position;
+        index = 0;
+    }
+
+    // Miters at the moved point and both neighbours change
+    std::vector<size_t> vertices;
+    for (int offset = -1; offset <= 1; offset++) {
+        long v = static_cast<long>(index) + offset;
+        if (loop) v = (v + static_cast<long>(unique)) % static_cast<long>(unique);
+        else if (v < 0 || v >= static_cast<long>(n)) continue;
+        vertices.push_back(static_cast<size_t>(v));
+    }
+
+    // Every segment touching one of those vertices
+    std::vector<size_t> touched;
+    for (size_t v : vertices) {
+        computeCorner(v);
+        if (loop && v == 0) computeCorner(n - 1);
+
+        if (v > 0) touched.push_back(v - 1);
+        else if (loop) touched.push_back(segmentCount() - 1);
+        if (v < segmentCount()) touched.push_back(v);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    if (movedBorders) movedBorders->clear();
+    for (size_t s : touched) {
+        buildQuad(s, unitNormal(P[s + 1] - P[s]));
+        buildWalls(s);
+        if (movedBorders) {
+            movedBorders->push_back(static_cast<uint32_t>(2 * s));
+            movedBorders->push_back(static_cast<uint32_t>(2 * s + 1));
+        }
+    }
+
+    // A gate only needs re-aligning if its own segment moved or a moved one got closer
+    for (size_t c = 0; c < gates.size(); c++) {
+        bool rebuild = std::find(touched.begin(), touched.end(), gateSegment[c]) != touched.end();
+        for (size_t s : touched) {
+            if (rebuild) break;
+            rebuild = gateDistanceTo(c, s) < gateDistance[c];
+        }
+        if (rebuild) buildGate(c);
+    }
+}
+
+void Track::draw(sf::RenderTarget& target) const {
+    for (const auto& seg : quads) target.draw(seg);
+    for (const auto& border : borderShapes) target.draw(border);
+    for (const auto& cp : gates) target.draw(cp);
+}
@@ -0,0 +1,78 @@
+/******************************************************
+ *  Track - geometry, walls and checkpoint gates built from a centreline
+ ******************************************************/
+#pragma once
+
+#include "memory_budget.hpp"
+#include "wall_grid.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+struct BakedTrackTables;
+
+// Everything needed to build a track. A centreline whose last point equals its
+// first is treated as a closed loop.
+struct TrackLayout {
+    std::string name;
+    std::vector<sf::Vector2f> centreline;
+    std::vector<sf::Vector2f> checkpoints;
+    std::vector<sf::Vector2f> initialLine; // starting guess for the AI racing line
+    float width = 80.f;                    // asphalt drawn around the centreline
+    float wallOffset = 50.f;               // walls sit this far either side of the centreline
+    const BakedTrackTables* baked = nullptr; // compile-time tables for built-in layouts (baked_tracks.hpp)
+};
+
+// The rectangle circuit the game has always shipped with
+TrackLayout defaultTrackLayout();
+
+// Every built-in layout, the default rectangle first
+std::vector<TrackLayout> builtinTrackLayouts();
+
+// Looks a built-in layout up by name (case-insensitive)
+bool findBuiltinTrack(const std::string& name, TrackLayout& layout);
+
+// Derived track data. Wall segment ids are shared between borders() and walls():
+// id 2*i is the outer (+normal) wall of centreline segment i, 2*i+1 the inner one.
+class Track {
+public:
+    void build(const TrackLayout& layout);
+
+    // Moves one centreline point and rebuilds only the quads, walls, grid cells and
+    // gates that depend on it. movedBorders, if given, receives the rebuilt borders' ids.
+    void moveCentrelinePoint(size_t index, sf::Vector2f position, std::vector<uint32_t>* movedBorders = nullptr);
+
+    const TrackLayout& layout() const { return layout_; }
+    const std::vector<sf::Vector2f>& centreline() const { return layout_.centreline; }
+    const std::vector<sf::ConvexShape>& segments() const { return quads; }
+    const std::vector<sf::RectangleShape>& borders() const { return borderShapes; }
+    const std::vector<sf::RectangleShape>& checkpointShapes() const { return gates; }
+    const WallGrid& walls() const { return grid; }
+    bool closed() const;
+
+    void draw(sf::RenderTarget& target) const;
+
+private:
+    size_t segmentCount() const { return layout_.centreline.size() - 1; }
+    bool bakedTablesMatch() const;
+    void buildFromBaked();
+    void computeCorner(size_t vertex);
+    void buildQuad(size_t segment, sf::Vector2f normal);
+    void buildWalls(size_t segment);
+    void buildGate(size_t checkpoint);
+    void placeGate(size_t checkpoint, float rotation);
+    float gateDistanceTo(size_t checkpoint, size_t segment) const;
+
+    void chargeShapes();
+
+    TrackLayout layout_;
+    TaggedVector<sf::Vector2f, MemoryTag::TrackGeometry> outerCorners, innerCorners;
+    std::vector<sf::ConvexShape> quads;
+    std::vector<sf::RectangleShape> borderShapes;
+    std::vector<sf::RectangleShape> gates;
+    TaggedVector<size_t, MemoryTag::TrackGeometry> gateSegment; // centreline segment each gate is aligned with
+    TaggedVector<float, MemoryTag::TrackGeometry> gateDistance;
+    MemoryCharge shapeMemory{MemoryTag::TrackGeometry}; // the shape vectors, which segments() etc. expose
+    WallGrid grid;
+};
@@ -0,0 +1,251 @@
+/******************************************************
+ *  Track Manager - background preloading of upcoming tracks
+ ******************************************************/
+
+#include "track_manager.hpp"
+#include "artifact.hpp"
+#include "optimizer.hpp"
+#include "style_archive.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+
+static const size_t REFINE_MIN_CANDIDATES = 8; // per generation; more on pools with more threads
+
+TrackManager::TrackManager(std::vector<TrackLayout> rotation, float speed, int generationCount, size_t depth,
+                           std::string linesDirectory, unsigned idleThreads, AsyncWriter* writer)
+    : layouts(std::move(rotation)),
+      trainedLines(layouts.size()),
+      aiSpeed(speed),
+      generations(generationCount),
+      preloadDepth(std::max<size_t>(1, depth)),
+      linesDir(std::move(linesDirectory)),
+      exportWriter(writer),
+      refineJobs(layouts.size()),
+      refinePool(idleThreads) {
+    refinePool.setActiveThreads(0); // a race is about to start
+    refineGroup = refinePool.addGroup("refine");
+    worker = std::thread(&TrackManager::run, this);
+}
+
+TrackManager::~TrackManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (worker.joinable()) worker.join();
+
+    // Generations in flight finish without starting new ones (a parked pool is woken for them)
+    refineStopping = true;
+    refinePool.setActiveThreads(refinePool.threadCount());
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        refineDrained.wait(lock, [&] { return refineInFlight == 0; });
+    }
+    for (auto& job : refineJobs) {
+        if (job) exportRefined(*job);
+    }
+}
+
+void TrackManager::setIdle(bool idle) {
+    if (idle == idleNow) return;
+    idleNow = idle;
+    refineYield = !idle;
+    refinePool.setActiveThreads(idle ? refinePool.threadCount() : 0);
+}
+
+bool TrackManager::nextReady() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !ready.empty();
+}
+
+std::unique_ptr<TrackBundle> TrackManager::takeNext() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return !ready.empty(); });
+    std::unique_ptr<TrackBundle> bundle = std::move(ready.front());
+    ready.pop_front();
+    handedOut++;
+    lock.unlock();
+
+    changed.notify_all(); // room for another preload
+    return bundle;
+}
+
+// Builds one bundle. Runs on the worker thread without holding the lock.
+std::unique_ptr<TrackBundle> TrackManager::prepare(size_t index, bool verbose) {
+    auto bundle = std::make_unique<TrackBundle>();
+    const TrackLayout& layout = layouts[index];
+    bundle->rotationIndex = index;
+    bundle->track.build(layout);
+    bundle->borderGrid.build(borderBoxes(bundle->track.borders()));
+
+    // An exported roster of racing styles puts a different opponent on the track each
+    // time it comes round, and makes training a single line unnecessary
+    std::vector<std::vector<sf::Vector2f>> styles;
+    if (!linesDir.empty() && loadStyleRoster(layout, linesDir, styles)) {
+        size_t pick = styleRng() % styles.size();
+        std::cout << "Track manager: " << layout.name << " opponent drives racing style " << pick + 1 << " of " << styles.size() << "\n";
+        bundle->aiWaypoints = std::move(styles[pick]);
+    }
+
+    // Only the worker adds lines to the cache; the refiner replaces them under the lock
+    std::vector<sf::Vector2f> line;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        line = trainedLines[index];
+    }
+    const bool cached = !line.empty();
+    if (bundle->aiWaypoints.empty() && line.empty() && !linesDir.empty() && loadRacingLineFor(layout, linesDir, line)) {
+        std::cout << "Track manager: loaded racing line for " << layout.name << " from " << linesDir << "\n";
+    }
+    if (bundle->aiWaypoints.empty() && line.empty()) {
+        if (layout.initialLine.size() > LONG_TRACK_WAYPOINTS) {
+            line = optimizeWaypointsWindowed(layout.initialLine, bundle->track.borders(), aiSpeed, WindowSettings(), verbose);
+        } else {
+            line = optimizeWaypointsProgressive(layout.initialLine, bundle->track.borders(), aiSpeed, generations, ProgressiveSettings(),
+                                                verbose);
+        }
+        if (!verbose) std::cout << "Track manager: trained racing line for " << layout.name << "\n";
+
+        if (!linesDir.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories(linesDir, error);
+            float fitness = simulateRun(line, bundle->borderGrid, aiSpeed);
+            writeRacingLineArtifact(linesDir + "/" + racingLineFileName(layout.name), trackLayoutHash(layout), line, fitness, exportWriter);
+        }
+    }
+    if (!cached && !line.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        trainedLines[index] = line;
+        size_t bytes = vectorBytes(trainedLines);
+        for (const auto& trained : trainedLines) bytes += vectorBytes(trained);
+        lineCacheMemory.set(bytes);
+    }
+    if (!line.empty() && !refineJobs[index]) startRefining(index, bundle->borderGrid, line);
+
+    if (bundle->aiWaypoints.empty()) bundle->aiWaypoints = std::move(line);
+    bundle->aiLine.build(bundle->aiWaypoints);
+    bundle->trackLine.build(layout.centreline);
+    return bundle;
+}
+
+void TrackManager::run() {
+    for (;;) {
+        size_t index;
+        bool verbose;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return stopping || ready.size() < preloadDepth; });
+            if (stopping) return;
+            index = nextToPrepare;
+            nextToPrepare = (nextToPrepare + 1) % layouts.size();
+            // The very first track is trained while the player waits, so show progress
+            verbose = handedOut == 0 && ready.empty();
+        }
+
+        std::unique_ptr<TrackBundle> bundle = prepare(index, verbose);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(std::move(bundle));
+        }
+        changed.notify_all();
+    }
+}
+
+// -------------------- Idle Refinement --------------------
+// Same hill climbing as trainTracks: mutations around the best line, a generation per
+// pool batch, until REFINE_PATIENCE generations bring nothing
+void TrackManager::startRefining(size_t index, const BorderGrid& grid, const std::vector<sf::Vector2f>& line) {
+    auto job = std::make_unique<RefineJob>();
+    job->index = index;
+    job->grid = grid;
+    job->rng.seed(std::random_device{}());
+    job->best = line;
+    job->bestFitness = simulateRun(line, grid, aiSpeed);
+    job->exportedFitness = job->bestFitness;
+    job->exportedAt = std::chrono::steady_clock::now();
+    job->candidates.resize(std::max<size_t>(REFINE_MIN_CANDIDATES, refinePool.threadCount()));
+    job->fitness.resize(job->candidates.size());
+    job->memory.set(vectorBytes(job->candidates) + vectorBytes(job->fitness) +
+                    (job->candidates.size() + 1) * line.size() * sizeof(sf::Vector2f));
+
+    refineJobs[index] = std::move(job);
+    refineGeneration(*refineJobs[index]);
+}
+
+void TrackManager::refineGeneration(RefineJob& job) {
+    if (refineStopping) return;
+    if (job.sinceImprovement >= REFINE_PATIENCE) {
+        exportRefined(job);
+        std::cout << "Track manager: racing line for " << layouts[job.index].name << " converged while idle (fitness "
+                  << job.bestFitness << ")\n";
+        return;
+    }
+
+    std::uniform_real_distribution<float> mutationDist(-20.0f, 20.0f);
+    for (auto& candidate : job.candidates) {
+        candidate = job.best;
+        for (auto& wp : candidate) {
+            wp.x += mutationDist(job.rng);
+            wp.y += mutationDist(job.rng);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        refineInFlight++;
+    }
+    RefineJob* target = &job;
+    refinePool.submit(
+        refineGroup, job.candidates.size(),
+        [this, target](size_t i) {
+            target->fitness[i] = simulateRun(target->candidates[i], target->grid, aiSpeed, nullptr, &refineYield);
+        },
+        [this, target] {
+            // A race that resumed mid-generation cut some pre-races short; that
+            // generation doesn't count towards convergence
+            bool complete = true;
+            for (float fitness : target->fitness) complete = complete && !std::isinf(fitness);
+            if (complete) {
+                refineGenerationCount++;
+                target->sinceImprovement++;
+            }
+            bool improved = false;
+            for (size_t i = 0; i < target->candidates.size(); i++) {
+                if (target->fitness[i] < target->bestFitness) {
+                    target->bestFitness = target->fitness[i];
+                    target->best.swap(target->candidates[i]);
+                    target->sinceImprovement = 0;
+                    improved = true;
+                }
+            }
+            if (improved) {
+                std::lock_guard<std::mutex> lock(mutex);
+                trainedLines[target->index] = target->best;
+            }
+            if (std::chrono::duration<float>(std::chrono::steady_clock::now() - target->exportedAt).count() >= REFINE_EXPORT_SECONDS) {
+                exportRefined(*target);
+            }
+            refineGeneration(*target);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--refineInFlight == 0) refineDrained.notify_all();
+        });
+}
+
+// Writes the line if it got better since it was last written
+void TrackManager::exportRefined(RefineJob& job) {
+    job.exportedAt = std::chrono::steady_clock::now();
+    if (linesDir.empty() || job.bestFitness >= job.exportedFitness) return;
+    const TrackLayout& layout = layouts[job.index];
+    if (writeRacingLineArtifact(linesDir + "/" + racingLineFileName(layout.name), trackLayoutHash(layout), job.best, job.bestFitness,
+                                exportWriter)) {
+        std::cout << "Track manager: refined racing line for " << layout.name << " while idle (fitness " << job.exportedFitness
+                  << " -> " << job.bestFitness << ")\n";
+        job.exportedFitness = job.bestFitness;
+    }
+}
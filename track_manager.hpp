@@ -0,0 +1,123 @@
+/******************************************************
+ *  Track Manager - background preloading of upcoming tracks
+ ******************************************************/
+#pragma once
+
+#include "optimizer.hpp"
+#include "racing_line.hpp"
+#include "track.hpp"
+#include "work_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AsyncWriter;
+
+// Everything a race needs for one track, ready to use
+struct TrackBundle {
+    size_t rotationIndex = 0;
+    Track track;
+    std::vector<sf::Vector2f> aiWaypoints; // trained racing line
+    RacingLine aiLine;                     // closest-point index over aiWaypoints
+    RacingLine trackLine;                  // closest-point index over the centreline
+    BorderGrid borderGrid;                 // broad phase for car-vs-border tests
+};
+
+// Cycles through a list of layouts. A worker thread keeps the next few bundles
+// built (geometry, collision structures, trained racing line) so switching between
+// races is just a pointer hand-off. Trained lines are cached per layout, so coming
+// back around the rotation never retrains. With a lines directory, exported racing
+// line artifacts for the exact same geometry are used instead of training, and
+// lines trained here are exported there for the next start. If the directory holds a
+// roster of racing styles for a layout (style_archive.hpp), each visit races one of
+// them at random.
+//
+// Idle time is spent improving the trained lines. While the game is idle (paused or
+// at the post-race screen), a work pool keeps hill climbing every line trained or
+// loaded so far on all of its threads. The moment a race resumes, the pool parks and
+// the pre-races in flight give up on their next step, so a long track's pre-race
+// doesn't hold a core into the race. Improved lines go to the cache, so
+// the next preload races them. They are also exported, at most every
+// REFINE_EXPORT_SECONDS and at exit, so the next session starts from them.
+class TrackManager {
+public:
+    static constexpr float REFINE_EXPORT_SECONDS = 10.f;
+    static const int REFINE_PATIENCE = 200; // generations without improvement before a line is left alone
+
+    // Line exports go through writer, which must outlive the manager; null = written in place
+    TrackManager(std::vector<TrackLayout> rotation, float aiSpeed, int generations, size_t preloadDepth = 2,
+                 std::string linesDirectory = "", unsigned idleThreads = 0, AsyncWriter* writer = nullptr);
+    ~TrackManager();
+
+    // Call once per frame; only a change from the last call does anything
+    void setIdle(bool idle);
+
+    // True if the next bundle can be taken without waiting
+    bool nextReady() const;
+
+    // Hands over the next bundle in the rotation, waiting only if it isn't built yet
+    std::unique_ptr<TrackBundle> takeNext();
+
+    size_t rotationSize() const { return layouts.size(); }
+
+    // Pre-races run while idle, over the whole session
+    uint64_t refineGenerations() const { return refineGenerationCount.load(); }
+
+private:
+    // One line being refined; only its pool batch's completion touches it
+    struct RefineJob {
+        size_t index = 0;
+        BorderGrid grid;
+        std::mt19937 rng;
+        std::vector<sf::Vector2f> best;
+        float bestFitness = 0.f;
+        float exportedFitness = 0.f;
+        std::chrono::steady_clock::time_point exportedAt;
+        int sinceImprovement = 0;
+        std::vector<std::vector<sf::Vector2f>> candidates;
+        std::vector<float> fitness;
+        MemoryCharge memory{MemoryTag::Population};
+    };
+
+    void run();
+    std::unique_ptr<TrackBundle> prepare(size_t index, bool verbose);
+    void startRefining(size_t index, const BorderGrid& grid, const std::vector<sf::Vector2f>& line);
+    void refineGeneration(RefineJob& job);
+    void exportRefined(RefineJob& job);
+
+    std::vector<TrackLayout> layouts;
+    std::vector<std::vector<sf::Vector2f>> trainedLines; // cache, empty until trained; guarded by mutex
+    MemoryCharge lineCacheMemory{MemoryTag::LineCache};
+    float aiSpeed;
+    int generations;
+    size_t preloadDepth;
+    std::string linesDir; // racing line artifacts, empty = always train
+    AsyncWriter* exportWriter;
+    std::mt19937 styleRng{std::random_device{}()}; // which roster style races next
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::unique_ptr<TrackBundle>> ready;
+    size_t nextToPrepare = 0;
+    size_t handedOut = 0;
+    bool stopping = false;
+    std::thread worker;
+
+    std::vector<std::unique_ptr<RefineJob>> refineJobs; // per layout, created by the worker thread
+    std::atomic<bool> refineStopping{false};
+    std::atomic<bool> refineYield{true}; // not idle: pre-races in flight give up
+    std::atomic<uint64_t> refineGenerationCount{0};
+    size_t refineInFlight = 0; // generations submitted and not yet completed; guarded by mutex
+    std::condition_variable refineDrained;
+    bool idleNow = false;
+    int refineGroup = 0;
+    WorkPool refinePool; // last, so it goes first, once the destructor has drained it
+};
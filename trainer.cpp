@@ -0,0 +1,213 @@
+/******************************************************
+ *  Trainer - racing-line training for several tracks on one shared pool
+ ******************************************************/
+
+#include "trainer.hpp"
+#include "novelty_archive.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+
+// -------------------- Job State --------------------
+// A job never has more than one batch in flight, and its bookkeeping only runs in that
+// batch's completion, so nothing here needs a lock of its own
+struct JobState {
+    const TrainingJob* job = nullptr;
+    int group = 0;
+    BorderGrid grid;
+    std::mt19937 rng;
+
+    std::vector<sf::Vector2f> best;
+    float bestFitness = 0.f;
+    int generation = 0;
+    int sinceImprovement = 0;
+
+    std::vector<std::vector<sf::Vector2f>> candidates;
+    std::vector<float> fitness;
+    MemoryCharge memory{MemoryTag::Population};
+
+    // Novelty search only
+    std::unique_ptr<NoveltyArchive> archive;
+    std::vector<float> trajectories;                  // candidates', TRAJECTORY_DIMS each
+    std::vector<std::vector<sf::Vector2f>> parents;
+    std::vector<float> parentTrajectories;
+    std::vector<float> parentNovelty;
+};
+
+struct TrainingRun {
+    WorkPool* pool = nullptr;
+    const TrainingSettings* settings = nullptr;
+    std::vector<std::unique_ptr<JobState>> jobs;
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::vector<TrainingResult> results;
+    size_t running = 0;
+};
+
+static void finishJob(TrainingRun& run, JobState& state) {
+    TrainingResult result;
+    result.name = state.job->layout.name;
+    result.waypoints = state.best;
+    result.fitness = state.bestFitness;
+    result.generations = state.generation;
+    result.cpuSeconds = run.pool->groupSeconds(state.group);
+
+    std::string path = run.settings->outputDir + "/" + racingLineFileName(result.name);
+    if (writeRacingLineArtifact(path, trackLayoutHash(state.job->layout), result.waypoints, result.fitness, run.settings->writer)) {
+        result.path = path;
+    }
+
+    std::lock_guard<std::mutex> lock(run.mutex);
+    std::cout << "Trained " << result.name << " in " << result.generations << " generations"
+              << " (fitness " << result.fitness << ", " << result.cpuSeconds << "s CPU)"
+              << (result.path.empty() ? "" : " -> " + result.path) << "\n";
+    run.results.push_back(std::move(result));
+    if (--run.running == 0) run.finished.notify_all();
+}
+
+// Rescores parents and children against the archive (parents' scores go stale as it
+// grows), files the children in it and keeps the most novel lines as the next parents.
+// Parents are archived already, so their own entry is left out of their score; children
+// are scored before they go in, so both are measured against everyone else.
+static void selectNovelParents(const TrainingSettings& settings, JobState& state) {
+    struct Scored {
+        float novelty;
+        const std::vector<sf::Vector2f>* line;
+        const float* trajectory;
+    };
+    std::vector<Scored> scored;
+    for (size_t i = 0; i < state.parents.size(); i++) {
+        const float* trajectory = &state.parentTrajectories[i * TRAJECTORY_DIMS];
+        scored.push_back({state.archive->novelty(trajectory, settings.noveltyNeighbours, true), &state.parents[i], trajectory});
+    }
+    for (size_t i = 0; i < state.candidates.size(); i++) {
+        const float* trajectory = &state.trajectories[i * TRAJECTORY_DIMS];
+        scored.push_back({state.archive->novelty(trajectory, settings.noveltyNeighbours), &state.candidates[i], trajectory});
+    }
+    for (size_t i = 0; i < state.candidates.size(); i++) state.archive->insert(&state.trajectories[i * TRAJECTORY_DIMS]);
+
+    const size_t keep = std::min(scored.size(), std::max<size_t>(1, settings.noveltyParents));
+    std::partial_sort(scored.begin(), scored.begin() + keep, scored.end(),
+                      [](const Scored& a, const Scored& b) { return a.novelty > b.novelty; });
+    std::vector<std::vector<sf::Vector2f>> parents(keep);
+    std::vector<float> trajectories(keep * TRAJECTORY_DIMS);
+    state.parentNovelty.resize(keep);
+    for (size_t i = 0; i < keep; i++) {
+        parents[i] = *scored[i].line;
+        std::copy_n(scored[i].trajectory, TRAJECTORY_DIMS, &trajectories[i * TRAJECTORY_DIMS]);
+        state.parentNovelty[i] = scored[i].novelty;
+    }
+    state.parents.swap(parents);
+    state.parentTrajectories.swap(trajectories);
+}
+
+// Same mutation as optimizeWaypoints, but around the best line so far (hill climbing),
+// so a job can stop once nothing nearby is better. With novelty search, each child
+// comes from the more novel of two random parents instead.
+static void startGeneration(TrainingRun& run, JobState& state) {
+    const TrainingSettings& settings = *run.settings;
+    const bool novelty = state.archive != nullptr;
+    if (state.generation >= settings.maxGenerations || (!novelty && state.sinceImprovement >= settings.patience)) {
+        finishJob(run, state);
+        return;
+    }
+
+    std::uniform_real_distribution<float> mutationDist(-20.0f, 20.0f);
+    size_t populationBytes = vectorBytes(state.candidates) + vectorBytes(state.fitness) + vectorBytes(state.best);
+    for (auto& candidate : state.candidates) {
+        if (novelty) {
+            std::uniform_int_distribution<size_t> pick(0, state.parents.size() - 1);
+            size_t a = pick(state.rng), b = pick(state.rng);
+            candidate = state.parents[state.parentNovelty[a] >= state.parentNovelty[b] ? a : b];
+        } else {
+            candidate = state.best;
+        }
+        for (auto& wp : candidate) {
+            wp.x += mutationDist(state.rng);
+            wp.y += mutationDist(state.rng);
+        }
+        populationBytes += vectorBytes(candidate);
+    }
+    for (const auto& parent : state.parents) populationBytes += vectorBytes(parent);
+    state.memory.set(populationBytes + vectorBytes(state.trajectories) + vectorBytes(state.parentTrajectories));
+
+    JobState* job = &state;
+    run.pool->submit(
+        state.group, state.candidates.size(),
+        [job, &settings](size_t i) {
+            if (job->archive) {
+                job->fitness[i] = simulateTrajectory(job->candidates[i], job->grid, settings.aiSpeed, &job->trajectories[i * TRAJECTORY_DIMS]);
+            } else {
+                job->fitness[i] = simulateRun(job->candidates[i], job->grid, settings.aiSpeed);
+            }
+        },
+        [job, &run] {
+            job->generation++;
+            job->sinceImprovement++;
+            for (size_t i = 0; i < job->candidates.size(); i++) {
+                if (job->fitness[i] < job->bestFitness) {
+                    job->bestFitness = job->fitness[i];
+                    // Novelty search may still breed from the candidate, so it is copied
+                    if (job->archive) {
+                        job->best = job->candidates[i];
+                    } else {
+                        job->best.swap(job->candidates[i]);
+                    }
+                    job->sinceImprovement = 0;
+                }
+            }
+            if (job->archive) selectNovelParents(*run.settings, *job);
+            startGeneration(run, *job);
+        });
+}
+
+// -------------------- Training --------------------
+std::vector<TrainingResult> trainTracks(const std::vector<TrainingJob>& jobs, WorkPool& pool, const TrainingSettings& settings) {
+    std::error_code error;
+    std::filesystem::create_directories(settings.outputDir, error);
+
+    TrainingRun run;
+    run.pool = &pool;
+    run.settings = &settings;
+
+    std::random_device seed;
+    for (const auto& job : jobs) {
+        auto state = std::make_unique<JobState>();
+        Track track;
+        track.build(job.layout);
+
+        state->job = &job;
+        state->group = pool.addGroup(job.layout.name, job.weight);
+        state->grid.build(borderBoxes(track.borders()));
+        state->rng.seed(seed());
+        state->best = job.layout.initialLine;
+        state->candidates.resize(std::max<size_t>(1, settings.candidatesPerGeneration));
+        state->fitness.resize(state->candidates.size());
+        if (settings.noveltySearch) {
+            state->archive = std::make_unique<NoveltyArchive>(TRAJECTORY_DIMS);
+            state->trajectories.resize(state->candidates.size() * TRAJECTORY_DIMS);
+            state->parents.push_back(state->best);
+            state->parentTrajectories.resize(TRAJECTORY_DIMS);
+            state->parentNovelty.push_back(0.f);
+            state->bestFitness = simulateTrajectory(state->best, state->grid, settings.aiSpeed, state->parentTrajectories.data());
+            state->archive->insert(state->parentTrajectories.data());
+        } else {
+            state->bestFitness = simulateRun(state->best, state->grid, settings.aiSpeed);
+        }
+        run.jobs.push_back(std::move(state));
+    }
+
+    std::cout << "Training " << jobs.size() << " tracks on " << pool.threadCount() << " threads...\n";
+    run.running = run.jobs.size();
+    for (auto& state : run.jobs) startGeneration(run, *state);
+
+    std::unique_lock<std::mutex> lock(run.mutex);
+    run.finished.wait(lock, [&] { return run.running == 0; });
+    return std::move(run.results);
+}
@@ -0,0 +1,49 @@
+/******************************************************
+ *  Trainer - racing-line training for several tracks on one shared pool
+ ******************************************************/
+#pragma once
+
+#include "artifact.hpp"
+#include "optimizer.hpp"
+#include "track.hpp"
+#include "work_pool.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+struct TrainingJob {
+    TrackLayout layout;
+    float weight = 1.f; // fair-share priority; 2 gets twice the CPU of 1 while both are running
+};
+
+struct TrainingSettings {
+    float aiSpeed = 3.0f;
+    size_t candidatesPerGeneration = 8; // mutations per generation, evaluated in parallel
+    int maxGenerations = GENERATIONS;
+    int patience = 40;                  // converged after this many generations without improvement
+    std::string outputDir = "lines";    // created if missing; the game loads lines from here
+    AsyncWriter* writer = nullptr;      // exports go through it, off the pool's threads; null = written in place
+
+    // Novelty search: breed from the lines whose trajectories are least like anything
+    // tried before, instead of climbing from the best one. Runs all maxGenerations (no
+    // patience); the fastest line seen is still what gets exported.
+    bool noveltySearch = false;
+    size_t noveltyNeighbours = 15;      // k of the k-nearest-neighbour novelty score
+    size_t noveltyParents = 16;         // most novel lines kept to breed from
+};
+
+struct TrainingResult {
+    std::string name;
+    std::string path; // where the line was written, empty if writing failed
+    std::vector<sf::Vector2f> waypoints;
+    float fitness = 0.f;
+    int generations = 0;
+    double cpuSeconds = 0.0;
+};
+
+// Trains every job's racing line at once. Each generation's candidates go to the pool
+// as one batch in the job's fair-share group, and each line is exported to
+// outputDir/<track>.sra (artifact.hpp) the moment its job converges. Blocks until all
+// are done; results come back in the order the jobs finished.
+std::vector<TrainingResult> trainTracks(const std::vector<TrainingJob>& jobs, WorkPool& pool, const TrainingSettings& settings);
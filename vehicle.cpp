@@ -0,0 +1,117 @@
+/******************************************************
+ *  Vehicle - table-driven car dynamics for many cars at once
+ ******************************************************/
+
+#include "vehicle.hpp"
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+float vehicleEngineAccel(const VehicleParams& p, float speed) {
+    return speed > 0.f ? std::min(p.maxEngineAccel, p.enginePower / speed) : p.maxEngineAccel;
+}
+
+float vehicleResistance(const VehicleParams& p, float speed) {
+    return speed > 0.f ? p.dragCoefficient * speed * speed + p.rollingResistance : 0.f;
+}
+
+float vehicleTopSpeed(const VehicleParams& params) {
+    float lo = 0.f, hi = 1000.f;
+    for (int i = 0; i < 60; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (vehicleEngineAccel(params, mid) > vehicleResistance(params, mid)) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+VehicleTables buildVehicleTables(const VehicleParams& params) {
+    VehicleTables t;
+    t.tableTopSpeed = 1.25f * std::max(vehicleTopSpeed(params), params.maxReverse);
+    t.invStep = VehicleTables::SIZE / t.tableTopSpeed;
+    t.brakeDecel = params.brakeDecel;
+    t.reverseAccel = params.reverseAccel;
+    t.maxReverse = params.maxReverse;
+
+    for (int i = 0; i <= VehicleTables::SIZE; i++) {
+        float speed = i / t.invStep;
+        t.engine[i] = vehicleEngineAccel(params, speed);
+        t.resistance[i] = vehicleResistance(params, speed);
+        float lock = params.maxYawRate * std::min(1.f, speed / params.fullLockSpeed);
+        t.yawLimit[i] = speed > 0.f ? std::min(lock, params.lateralGrip / speed) : 0.f;
+    }
+    return t;
+}
+
+// -------------------- State --------------------
+void VehicleState::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    dirX.resize(count, 1.f);
+    dirY.resize(count, 0.f);
+    speed.resize(count, 0.f);
+}
+
+void VehicleState::place(size_t car, float px, float py, float headingDegrees, float initialSpeed) {
+    x[car] = px;
+    y[car] = py;
+    dirX[car] = std::cos(headingDegrees * GEO_PI / 180.f);
+    dirY[car] = std::sin(headingDegrees * GEO_PI / 180.f);
+    speed[car] = initialSpeed;
+}
+
+float VehicleState::headingDeg(size_t car) const {
+    return std::atan2(dirY[car], dirX[car]) * 180.f / GEO_PI;
+}
+
+// -------------------- Kernel --------------------
+void stepVehicles(const VehicleTables& tables, VehicleState& state, const float* throttle, const float* steer) {
+    const size_t count = state.size();
+    float* __restrict px = state.x.data();
+    float* __restrict py = state.y.data();
+    float* __restrict dx = state.dirX.data();
+    float* __restrict dy = state.dirY.data();
+    float* __restrict sp = state.speed.data();
+    const float lastIndex = VehicleTables::SIZE - 0.001f;
+
+    for (size_t i = 0; i < count; i++) {
+        const float v = sp[i];
+        const float t = std::min(std::fabs(v) * tables.invStep, lastIndex);
+        const int k = static_cast<int>(t);
+        const float f = t - k;
+        const float engine = tables.engine[k] + f * (tables.engine[k + 1] - tables.engine[k]);
+        const float resist = tables.resistance[k] + f * (tables.resistance[k + 1] - tables.resistance[k]);
+        const float yawLimit = tables.yawLimit[k] + f * (tables.yawLimit[k + 1] - tables.yawLimit[k]);
+
+        // Throttle forwards brakes a reversing car; throttle backwards brakes a moving one
+        const float forward = std::max(throttle[i], 0.f);
+        const float backward = std::max(-throttle[i], 0.f);
+        const float direction = v > 0.f ? 1.f : (v < 0.f ? -1.f : 0.f);
+        const float push = forward * (v < 0.f ? tables.brakeDecel : engine);
+        const float pull = backward * (v > 0.f ? tables.brakeDecel : tables.reverseAccel);
+        float next = v + push - pull - direction * resist;
+        next = v * next < 0.f ? 0.f : next; // brakes and drag stop the car; reversing starts next frame
+        next = std::clamp(next, -tables.maxReverse, tables.tableTopSpeed);
+
+        // Reversing turns the other way, like a real car
+        const float sign = next > 0.f ? 1.f : (next < 0.f ? -1.f : 0.f);
+        const float yaw = steer[i] * yawLimit * sign;
+        const float c = 1.f - 0.5f * yaw * yaw;
+        float nx = dx[i] * c - dy[i] * yaw;
+        float ny = dx[i] * yaw + dy[i] * c;
+        const float renorm = 1.5f - 0.5f * (nx * nx + ny * ny);
+        nx *= renorm;
+        ny *= renorm;
+
+        dx[i] = nx;
+        dy[i] = ny;
+        sp[i] = next;
+        px[i] += nx * next;
+        py[i] += ny * next;
+    }
+}
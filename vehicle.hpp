@@ -0,0 +1,63 @@
+/******************************************************
+ *  Vehicle - table-driven car dynamics for many cars at once
+ ******************************************************/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Physical description of a car. Units are the game's: pixels and frames, so speeds
+// are pixels per frame and accelerations pixels per frame per frame.
+struct VehicleParams {
+    float enginePower = 0.6f;     // full-throttle accel is min(maxEngineAccel, enginePower / speed)
+    float maxEngineAccel = 0.25f; // traction limit off the line
+    float reverseAccel = 0.15f;
+    float maxReverse = 3.0f;
+    float brakeDecel = 0.35f;
+    float dragCoefficient = 0.0033f; // aerodynamic drag, k * speed^2
+    float rollingResistance = 0.01f;
+    float lateralGrip = 0.2f;     // max lateral accel; caps yaw rate at lateralGrip / speed
+    float maxYawRate = 0.0524f;   // radians per frame at full lock (3 degrees)
+    float fullLockSpeed = 1.0f;   // below this, steering authority scales down with speed
+};
+
+// Curves sampled over speed, so a tick is a lerp per table plus a few multiply-adds.
+// Tables run from 0 to tableTopSpeed; reversing looks them up by |speed|.
+struct VehicleTables {
+    static const int SIZE = 64;
+    float engine[SIZE + 1];    // forward engine accel at full throttle
+    float resistance[SIZE + 1]; // drag + rolling resistance, always opposes motion
+    float yawLimit[SIZE + 1];  // max yaw rate (grip limit, steering lock)
+    float tableTopSpeed = 0.f;
+    float invStep = 0.f;       // SIZE / tableTopSpeed
+    float brakeDecel = 0.f;
+    float reverseAccel = 0.f;
+    float maxReverse = 0.f;
+};
+
+VehicleTables buildVehicleTables(const VehicleParams& params);
+
+// Speed where engine accel and resistance balance (the table range ends a bit above it)
+float vehicleTopSpeed(const VehicleParams& params);
+
+// The curves the tables sample, at a forward speed: full-throttle engine accel, and
+// drag + rolling resistance (zero at rest)
+float vehicleEngineAccel(const VehicleParams& params, float speed);
+float vehicleResistance(const VehicleParams& params, float speed);
+
+// Car state, SoA. (dirX, dirY) is the unit heading; speed is signed (negative = reversing).
+struct VehicleState {
+    std::vector<float> x, y, dirX, dirY, speed;
+
+    void resize(size_t count);
+    size_t size() const { return x.size(); }
+    void place(size_t car, float px, float py, float headingDeg, float speed = 0.f);
+    float headingDeg(size_t car) const;
+};
+
+// Advances every car one frame. throttle and steer are in [-1, 1] per car:
+// throttle > 0 drives forwards (or brakes while reversing), < 0 brakes then reverses;
+// steer > 0 turns clockwise on screen, like a positive sf::Sprite rotation.
+// No branches or trig in the loop: the heading is rotated with a second-order
+// small-angle step and renormalized with one Newton iteration.
+void stepVehicles(const VehicleTables& tables, VehicleState& state, const float* throttle, const float* steer);
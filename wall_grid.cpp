@@ -0,0 +1,146 @@
+/******************************************************
+ *  Wall Grid - uniform broad-phase over track wall segments
+ ******************************************************/
+
+#include "wall_grid.hpp"
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static bool segmentTouchesBox(const WallSegment& s, float minX, float minY, float maxX, float maxY) {
+    return geoSegmentTouchesBox(GeoPoint{s.a.x, s.a.y}, GeoPoint{s.b.x, s.b.y}, minX, minY, maxX, maxY);
+}
+
+int WallGrid::cellX(float x) const {
+    return static_cast<int>(std::floor((x - origin_.x) / cell_));
+}
+
+int WallGrid::cellY(float y) const {
+    return static_cast<int>(std::floor((y - origin_.y) / cell_));
+}
+
+void WallGrid::build(const std::vector<WallSegment>& segments, float cellSize) {
+    walls = segments;
+    cell_ = cellSize;
+    cells.clear();
+
+    if (walls.empty()) {
+        cols = rowCount = 0;
+        return;
+    }
+
+    float minX = walls[0].a.x, maxX = minX;
+    float minY = walls[0].a.y, maxY = minY;
+    for (const auto& w : walls) {
+        minX = std::min({minX, w.a.x, w.b.x});
+        maxX = std::max({maxX, w.a.x, w.b.x});
+        minY = std::min({minY, w.a.y, w.b.y});
+        maxY = std::max({maxY, w.a.y, w.b.y});
+    }
+
+    origin_ = sf::Vector2f(minX - cell_, minY - cell_);
+    cols     = static_cast<int>(std::ceil((maxX - minX) / cell_)) + 2;
+    rowCount = static_cast<int>(std::ceil((maxY - minY) / cell_)) + 2;
+    cells.resize(static_cast<size_t>(cols) * rowCount);
+
+    for (uint32_t id = 0; id < walls.size(); id++) {
+        insert(id);
+    }
+}
+
+void WallGrid::assign(const std::vector<WallSegment>& segments, float cellSize, sf::Vector2f origin,
+                      int columns, int rows, const uint32_t* cellStart, const uint32_t* cellIds) {
+    walls = segments;
+    cell_ = cellSize;
+    origin_ = origin;
+    cols = columns;
+    rowCount = rows;
+    cells.assign(static_cast<size_t>(cols) * rowCount, Cell());
+
+    for (size_t i = 0; i < cells.size(); i++) {
+        Cell& c = cells[i];
+        for (uint32_t k = cellStart[i]; k < cellStart[i + 1]; k++) {
+            const WallSegment& w = walls[cellIds[k]];
+            c.ax.push_back(w.a.x);
+            c.ay.push_back(w.a.y);
+            c.ex.push_back(w.b.x - w.a.x);
+            c.ey.push_back(w.b.y - w.a.y);
+            c.ids.push_back(cellIds[k]);
+        }
+    }
+}
+
+void WallGrid::insert(uint32_t id) {
+    const WallSegment& w = walls[id];
+    int x0 = std::max(0, cellX(std::min(w.a.x, w.b.x)));
+    int x1 = std::min(cols - 1, cellX(std::max(w.a.x, w.b.x)));
+    int y0 = std::max(0, cellY(std::min(w.a.y, w.b.y)));
+    int y1 = std::min(rowCount - 1, cellY(std::max(w.a.y, w.b.y)));
+
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            float bx = origin_.x + cx * cell_;
+            float by = origin_.y + cy * cell_;
+            // Diagonal walls only go into the cells they actually cross
+            if (!segmentTouchesBox(w, bx, by, bx + cell_, by + cell_)) continue;
+
+            Cell& c = cells[static_cast<size_t>(cy) * cols + cx];
+            c.ax.push_back(w.a.x);
+            c.ay.push_back(w.a.y);
+            c.ex.push_back(w.b.x - w.a.x);
+            c.ey.push_back(w.b.y - w.a.y);
+            c.ids.push_back(id);
+        }
+    }
+}
+
+void WallGrid::remove(uint32_t id) {
+    const WallSegment& w = walls[id];
+    int x0 = std::max(0, cellX(std::min(w.a.x, w.b.x)));
+    int x1 = std::min(cols - 1, cellX(std::max(w.a.x, w.b.x)));
+    int y0 = std::max(0, cellY(std::min(w.a.y, w.b.y)));
+    int y1 = std::min(rowCount - 1, cellY(std::max(w.a.y, w.b.y)));
+
+    for (int cy = y0; cy <= y1; cy++) {
+        for (int cx = x0; cx <= x1; cx++) {
+            Cell& c = cells[static_cast<size_t>(cy) * cols + cx];
+            for (size_t i = 0; i < c.ids.size(); i++) {
+                if (c.ids[i] != id) continue;
+                // Swap-remove keeps the SoA arrays dense
+                c.ax[i] = c.ax.back(); c.ax.pop_back();
+                c.ay[i] = c.ay.back(); c.ay.pop_back();
+                c.ex[i] = c.ex.back(); c.ex.pop_back();
+                c.ey[i] = c.ey.back(); c.ey.pop_back();
+                c.ids[i] = c.ids.back(); c.ids.pop_back();
+                break;
+            }
+        }
+    }
+}
+
+bool WallGrid::covers(const WallSegment& w) const {
+    float hiX = cols * cell_, hiY = rowCount * cell_;
+    for (const sf::Vector2f& p : {w.a, w.b}) {
+        float x = p.x - origin_.x, y = p.y - origin_.y;
+        if (x < 0.f || y < 0.f || x >= hiX || y >= hiY) return false;
+    }
+    return true;
+}
+
+void WallGrid::updateSegment(uint32_t id, const WallSegment& segment) {
+    if (cells.empty() || !covers(segment)) {
+        walls[id] = segment;
+        build(walls, cell_);
+        return;
+    }
+    remove(id);
+    walls[id] = segment;
+    insert(id);
+}
+
+void appendPolylineWalls(const std::vector<sf::Vector2f>& polyline, std::vector<WallSegment>& out) {
+    for (size_t i = 0; i + 1 < polyline.size(); i++) {
+        out.push_back({polyline[i], polyline[i + 1]});
+    }
+}
@@ -0,0 +1,66 @@
+/******************************************************
+ *  Wall Grid - uniform broad-phase over track wall segments
+ ******************************************************/
+#pragma once
+
+#include "memory_budget.hpp"
+
+#include <SFML/System.hpp>
+#include <cstdint>
+#include <vector>
+
+// A single straight piece of track wall
+struct WallSegment {
+    sf::Vector2f a;
+    sf::Vector2f b;
+};
+
+// Uniform grid over the wall segments. Every cell keeps its own SoA copy of the
+// segments that cross it, so narrow-phase tests stream through contiguous floats.
+class WallGrid {
+public:
+    struct Cell {
+        TaggedVector<float, MemoryTag::CollisionIndex> ax, ay; // segment start
+        TaggedVector<float, MemoryTag::CollisionIndex> ex, ey; // segment direction (b - a)
+        TaggedVector<uint32_t, MemoryTag::CollisionIndex> ids; // index into segments()
+    };
+
+    // Builds the grid; the covered area is the segments' bounds plus one cell of padding
+    void build(const std::vector<WallSegment>& segments, float cellSize);
+
+    // Loads a grid whose layout was computed ahead of time (see baked_tracks.hpp).
+    // cellStart has columns*rows+1 entries indexing into cellIds, one row after another.
+    void assign(const std::vector<WallSegment>& segments, float cellSize, sf::Vector2f origin,
+                int columns, int rows, const uint32_t* cellStart, const uint32_t* cellIds);
+
+    // Moves one segment, touching only the cells it leaves and enters. Falls back to
+    // a full rebuild if it moves outside the covered area.
+    void updateSegment(uint32_t id, const WallSegment& segment);
+
+    const std::vector<WallSegment>& segments() const { return walls; }
+    const Cell& cell(int cx, int cy) const { return cells[static_cast<size_t>(cy) * cols + cx]; }
+
+    int columns() const { return cols; }
+    int rows() const { return rowCount; }
+    float cellSize() const { return cell_; }
+    sf::Vector2f origin() const { return origin_; }
+
+    // Cell coordinate containing a world position (not clamped)
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+private:
+    void insert(uint32_t id);
+    void remove(uint32_t id);
+    bool covers(const WallSegment& segment) const;
+
+    std::vector<WallSegment> walls;
+    TaggedVector<Cell, MemoryTag::CollisionIndex> cells;
+    sf::Vector2f origin_;
+    float cell_ = 64.f;
+    int cols = 0;
+    int rowCount = 0;
+};
+
+// Splits a closed or open polyline (e.g. outerBorder) into wall segments
+void appendPolylineWalls(const std::vector<sf::Vector2f>& polyline, std::vector<WallSegment>& out);
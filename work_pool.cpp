@@ -0,0 +1,186 @@
+/******************************************************
+ *  Work Pool - shared work-stealing thread pool with fair-share groups
+ ******************************************************/
+
+#include "work_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+WorkPool::WorkPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threads; i++) workers.push_back(std::make_unique<Worker>());
+    activeLimit = threads;
+    for (size_t i = 0; i < workers.size(); i++) workers[i]->thread = std::thread(&WorkPool::workerLoop, this, i);
+}
+
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+int WorkPool::addGroup(const std::string& name, float weight) {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    auto group = std::make_unique<Group>();
+    group->name = name;
+    group->weight = std::max(weight, 0.01f);
+    groups.push_back(std::move(group));
+    return static_cast<int>(groups.size()) - 1;
+}
+
+double WorkPool::groupSeconds(int group) {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    return groups[group]->nanoseconds.load() * 1e-9;
+}
+
+void WorkPool::setActiveThreads(unsigned count) {
+    activeLimit = std::min(count, threadCount());
+    notifyWork(); // workers under a raised cap look for work, the ones over a lowered one park
+}
+
+void WorkPool::notifyWork() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        workEpoch++;
+    }
+    wake.notify_all();
+}
+
+void WorkPool::submit(int group, size_t count, std::function<void(size_t)> body, std::function<void()> done) {
+    if (count == 0) {
+        if (done) done();
+        return;
+    }
+    auto batch = std::make_shared<Batch>();
+    batch->body = std::move(body);
+    batch->done = std::move(done);
+    batch->remaining = count;
+    {
+        std::lock_guard<std::mutex> lock(groupMutex);
+        Group& target = *groups[group];
+        batch->group = &target;
+        target.pending++;
+        target.queue.push_back(Range{std::move(batch), 0, count});
+    }
+    notifyWork();
+}
+
+void WorkPool::parallelFor(int group, size_t count, const std::function<void(size_t)>& body) {
+    std::mutex doneMutex;
+    std::condition_variable doneSignal;
+    bool finished = false;
+    submit(group, count, body, [&] {
+        std::lock_guard<std::mutex> lock(doneMutex);
+        finished = true;
+        doneSignal.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneSignal.wait(lock, [&] { return finished; });
+}
+
+// The group with pending work that has had the least CPU time for its weight
+WorkPool::Group* WorkPool::neediestGroup() {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    Group* pick = nullptr;
+    double pickShare = 0.0;
+    for (auto& group : groups) {
+        if (group->pending.load() == 0) continue;
+        double share = group->nanoseconds.load() / group->weight;
+        if (!pick || share < pickShare) {
+            pick = group.get();
+            pickShare = share;
+        }
+    }
+    return pick;
+}
+
+bool WorkPool::takeFrom(Worker& worker, bool back, const Group* only, Range& range) {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.deque.empty()) return false;
+    Range& candidate = back ? worker.deque.back() : worker.deque.front();
+    if (only && candidate.batch->group != only) return false;
+    range = std::move(candidate);
+    if (back) {
+        worker.deque.pop_back();
+    } else {
+        worker.deque.pop_front();
+    }
+    range.batch->group->pending--;
+    return true;
+}
+
+bool WorkPool::takeQueued(Group* only, Range& range) {
+    std::lock_guard<std::mutex> lock(groupMutex);
+    for (auto& group : groups) {
+        Group* candidate = only ? only : group.get();
+        if (!candidate->queue.empty()) {
+            range = std::move(candidate->queue.front());
+            candidate->queue.pop_front();
+            candidate->pending--;
+            return true;
+        }
+        if (only) break;
+    }
+    return false;
+}
+
+// Own deque first (newest split, still warm in cache), then a new batch, then the
+// oldest half on someone else's deque. The first pass only takes the neediest group's
+// work; the second takes anything, so no worker idles while work is left.
+bool WorkPool::findWork(size_t index, Range& range) {
+    Group* target = neediestGroup();
+    for (int pass = target ? 0 : 1; pass < 2; pass++) {
+        Group* only = pass == 0 ? target : nullptr;
+        if (takeFrom(*workers[index], true, only, range)) return true;
+        if (takeQueued(only, range)) return true;
+        for (size_t offset = 1; offset < workers.size(); offset++) {
+            if (takeFrom(*workers[(index + offset) % workers.size()], false, only, range)) return true;
+        }
+    }
+    return false;
+}
+
+void WorkPool::run(size_t index, Range range) {
+    // Keep one item and leave the rest for thieves, halving until a single item is left
+    while (range.end - range.begin > 1) {
+        size_t mid = range.begin + (range.end - range.begin) / 2;
+        range.batch->group->pending++;
+        {
+            std::lock_guard<std::mutex> lock(workers[index]->mutex);
+            workers[index]->deque.push_back(Range{range.batch, mid, range.end});
+        }
+        notifyWork();
+        range.end = mid;
+    }
+
+    Batch& batch = *range.batch;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = range.begin; i < range.end; i++) batch.body(i);
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    batch.group->nanoseconds += elapsed.count();
+
+    if (batch.remaining.fetch_sub(range.end - range.begin) == range.end - range.begin) {
+        if (batch.done) batch.done();
+    }
+}
+
+void WorkPool::workerLoop(size_t index) {
+    for (;;) {
+        uint64_t epoch = workEpoch.load();
+        Range range;
+        if (index < activeLimit.load() && findWork(index, range)) {
+            run(index, std::move(range));
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&] { return stopping || workEpoch.load() != epoch; });
+        if (stopping) return;
+    }
+}
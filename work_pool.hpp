@@ -0,0 +1,93 @@
+/******************************************************
+ *  Work Pool - shared work-stealing thread pool with fair-share groups
+ ******************************************************/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Work is submitted as batches of indexed items. A batch enters the pool through its
+// group's queue. Whoever picks a batch up splits it in halves onto its own deque, and
+// idle workers steal halves from the other end, so one big batch still spreads over
+// every thread. Each time a worker needs work it serves the group that has used the
+// least CPU time relative to its weight, so fair share holds item by item, not just
+// when whole batches are queued.
+class WorkPool {
+public:
+    explicit WorkPool(unsigned threads = 0); // 0 = one per hardware thread
+    ~WorkPool();
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+    // Registers a fair-share group; a group with weight 2 gets twice the CPU of weight 1
+    int addGroup(const std::string& name, float weight = 1.f);
+
+    // Runs body(i) for every i in [0, count), then done() once on whichever worker
+    // finished last. done() may submit further batches. Returns immediately.
+    void submit(int group, size_t count, std::function<void(size_t)> body, std::function<void()> done = nullptr);
+
+    // Blocking version of submit, for callers outside the pool
+    void parallelFor(int group, size_t count, const std::function<void(size_t)>& body);
+
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+
+    // Caps how many workers take work; the others sleep and their queued halves are
+    // left to be stolen. Lowering the cap takes effect as each worker over it finishes
+    // the item it is on. 0 parks the whole pool: work queues up until the cap is raised.
+    void setActiveThreads(unsigned count);
+    unsigned activeThreads() const { return activeLimit.load(); }
+    double groupSeconds(int group); // CPU time spent on a group's items so far
+
+private:
+    struct Group;
+    struct Batch {
+        std::function<void(size_t)> body;
+        std::function<void()> done;
+        std::atomic<size_t> remaining{0};
+        Group* group = nullptr;
+    };
+    struct Range {
+        std::shared_ptr<Batch> batch;
+        size_t begin = 0, end = 0;
+    };
+    struct Group {
+        std::string name;
+        float weight = 1.f;
+        std::deque<Range> queue;
+        std::atomic<int64_t> nanoseconds{0};
+        std::atomic<int> pending{0}; // ranges waiting anywhere: group queue or a worker deque
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Range> deque; // owner pops the back, thieves take the front
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index);
+    bool findWork(size_t index, Range& range);
+    Group* neediestGroup();
+    bool takeFrom(Worker& worker, bool back, const Group* only, Range& range);
+    bool takeQueued(Group* only, Range& range);
+    void run(size_t index, Range range);
+    void notifyWork();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex groupMutex; // guards groups and their queues
+    std::vector<std::unique_ptr<Group>> groups; // stable addresses, batches point into it
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<uint64_t> workEpoch{0}; // bumped on every push, so sleepers never miss work
+    std::atomic<unsigned> activeLimit{0}; // workers [0, activeLimit) take work
+    bool stopping = false;
+};